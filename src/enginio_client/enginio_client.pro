@@ -18,8 +18,13 @@ SOURCES += \
     enginioclient.cpp \
     enginioreply.cpp \
     enginiomodel.cpp \
+    enginiotablemodel.cpp \
+    enginiosortfilterproxymodel.cpp \
     enginioidentity.cpp \
-    enginiofakereply.cpp
+    enginiofakereply.cpp \
+    enginionotificationchannel.cpp \
+    enginioobjectstore.cpp \
+    enginiorequestgroup.cpp
 
 HEADERS += \
     chunkdevice_p.h \
@@ -28,8 +33,13 @@ HEADERS += \
     enginioclient_p.h \
     enginioreply.h \
     enginiomodel.h \
+    enginiotablemodel.h \
+    enginiosortfilterproxymodel.h \
+    enginiorequestgroup.h \
     enginioidentity.h \
     enginioobjectadaptor_p.h \
     enginioreply_p.h \
-    enginiofakereply_p.h
+    enginiofakereply_p.h \
+    enginionotificationchannel_p.h \
+    enginioobjectstore_p.h
 
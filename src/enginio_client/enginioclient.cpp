@@ -37,12 +37,20 @@
 
 #include "enginioclient_p.h"
 #include "enginioreply.h"
+#include "enginioreply_p.h"
 #include "enginiomodel.h"
 #include "enginioidentity.h"
+#include "enginiorequestgroup.h"
 
 #include <QNetworkReply>
 #include <QSslError>
+#include <QtCore/qdir.h>
+#include <QtCore/qfileinfo.h>
+#include <QtCore/qstandardpaths.h>
 #include <QtCore/qthreadstorage.h>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 4, 0)
+#include <QtCore/qsavefile.h>
+#endif
 
 /*!
   \module enginio-client
@@ -160,12 +168,27 @@
     \sa authenticationState
 */
 
+/*!
+    \enum EnginioClient::Priority
+
+    This enum describes how urgently a request is sent to the backend. Every
+    priority class has its own limit of requests running at the same time,
+    further requests wait in the order in which they were made.
+
+    \value InteractivePriority The user is waiting for the result
+    \value NormalPriority The default for queries and object changes
+    \value BackgroundPriority Bulk work like file uploads, which should not delay other requests
+
+    \sa setMaxConcurrentRequests(), setPriority()
+*/
+
 ENGINIOCLIENT_EXPORT bool gEnableEnginioDebugInfo = !qEnvironmentVariableIsSet("ENGINIO_DEBUG_INFO");
 
 const QString EnginioString::pageSize = QStringLiteral("pageSize");
 const QString EnginioString::limit = QStringLiteral("limit");
 const QString EnginioString::offset = QStringLiteral("offset");
 const QString EnginioString::include = QStringLiteral("include");
+const QString EnginioString::fields = QStringLiteral("fields");
 const QString EnginioString::query = QStringLiteral("query");
 const QString EnginioString::message = QStringLiteral("message");
 const QString EnginioString::results = QStringLiteral("results");
@@ -187,6 +210,10 @@ const QString EnginioString::object = QStringLiteral("object");
 const QString EnginioString::url = QStringLiteral("url");
 const QString EnginioString::access = QStringLiteral("access");
 const QString EnginioString::sort = QStringLiteral("sort");
+const QString EnginioString::sortBy = QStringLiteral("sortBy");
+const QString EnginioString::direction = QStringLiteral("direction");
+const QString EnginioString::asc = QStringLiteral("asc");
+const QString EnginioString::desc = QStringLiteral("desc");
 const QString EnginioString::count = QStringLiteral("count");
 const QString EnginioString::targetFileProperty = QStringLiteral("targetFileProperty");
 const QString EnginioString::members = QStringLiteral("members");
@@ -207,13 +234,57 @@ EnginioClientPrivate::EnginioClientPrivate(EnginioClient *client) :
     _identity(),
     _serviceUrl(EnginioString::apiEnginIo),
     _networkManager(),
+    _networkManagerCount(1),
+    _reserveInteractiveManager(true),
+    _prewarmTimer(),
+    _tlsSessionCache(true),
     _uploadChunkSize(512 * 1024),
-    _authenticationState(EnginioClient::NotAuthenticated)
+    _authenticationState(EnginioClient::NotAuthenticated),
+    _rateLimitTimer(),
+    _queueDepth(0),
+    _maxAttempts(3),
+    _retryDelay(250),
+    _retryJitter(0.5),
+    _retryCount(0),
+    _hedgedReads(false),
+    _maxHedgeRatio(0.1),
+    _hedgeTokens(0),
+    _hedgeCount(0),
+    _hedgeWins(0),
+    _circuitBreakerThreshold(0.5),
+    _circuitBreakerTimeout(5000),
+    _rejectedRequests(0),
+    _requestTimeout(0),
+    _timedOutRequests(0)
 {
+    for (int i = 0; i < PriorityCount; ++i)
+        _activeRequestCount[i] = 0;
+    _maxActiveRequests[EnginioClient::InteractivePriority] = 6;
+    _maxActiveRequests[EnginioClient::NormalPriority] = 6; // as many as the connections of QNetworkAccessManager per host
+    _maxActiveRequests[EnginioClient::BackgroundPriority] = 2;
+    _clock.start();
+
+    _retryStatusCodes << 408 << 429 << 500 << 502 << 503 << 504;
+    _retryNetworkErrors << QNetworkReply::ConnectionRefusedError
+                        << QNetworkReply::RemoteHostClosedError
+                        << QNetworkReply::HostNotFoundError
+                        << QNetworkReply::TimeoutError
+                        << QNetworkReply::TemporaryNetworkFailureError
+                        << QNetworkReply::NetworkSessionFailedError
+                        << QNetworkReply::ProxyConnectionClosedError
+                        << QNetworkReply::ProxyTimeoutError;
+
     assignNetworkManager();
 
     _request.setHeader(QNetworkRequest::ContentTypeHeader,
                           QStringLiteral("application/json"));
+    loadSessionTicket();
+
+    // deferred, so that a serviceUrl set right after the construction is used
+    _prewarmTimer = new QTimer;
+    _prewarmTimer->setSingleShot(true);
+    QObject::connect(_prewarmTimer, &QTimer::timeout, PrewarmFunctor(this));
+    _prewarmTimer->start(0);
 }
 
 void EnginioClientPrivate::init()
@@ -222,6 +293,7 @@ void EnginioClientPrivate::init()
     qRegisterMetaType<EnginioModel*>();
     qRegisterMetaType<EnginioReply*>();
     qRegisterMetaType<EnginioIdentity*>();
+    qRegisterMetaType<EnginioRequestGroup*>();
     qRegisterMetaType<EnginioAuthentication*>();
 
     QObject::connect(q_ptr, &EnginioClient::sessionTerminated, AuthenticationStateTrackerFunctor(this));
@@ -232,11 +304,617 @@ void EnginioClientPrivate::init()
 
 EnginioClientPrivate::~EnginioClientPrivate()
 {
+    typedef QPair<EnginioNotificationChannel*, int> Subscription;
+    foreach (const Subscription &subscription, _notificationChannels)
+        delete subscription.first;
     foreach (const QMetaObject::Connection &identityConnection, _identityConnections)
         QObject::disconnect(identityConnection);
     foreach (const QMetaObject::Connection &connection, _connections)
         QObject::disconnect(connection);
-    QObject::disconnect(_networkManagerConnection);
+    foreach (const ActiveRequest &request, _activeRequests) {
+        QObject::disconnect(request.destroyedConnection);
+        delete request.hedgeTimer;
+    }
+    foreach (const QMetaObject::Connection &connection, _networkManagerConnections)
+        QObject::disconnect(connection);
+    delete _rateLimitTimer;
+    delete _prewarmTimer;
+    for (QHash<QTimer*, PendingRetry>::const_iterator i = _pendingRetries.constBegin(); i != _pendingRetries.constEnd(); ++i) {
+        delete i.key();
+        delete i->request.device;
+        delete i->chunkState.first;
+    }
+}
+
+QNetworkReply *EnginioClientPrivate::schedule(ScheduledRequest request)
+{
+    if (isCircuitRejecting(request.request.url()))
+        return send(request); // fails fast, without waiting in the queue
+
+    const EnginioClient::Priority priorityClass = requestPriority(request.request);
+    if (_queuedRequests[priorityClass].isEmpty() && hasFreeSlot(priorityClass) && !isRateLimited())
+        return send(request);
+
+    request.placeholder = new EnginioDeferredReply(this);
+    if (request.device)
+        request.device->setParent(request.placeholder);
+    if (request.multiPart)
+        request.multiPart->setParent(request.placeholder);
+    _queuedRequests[priorityClass].append(request);
+    updateQueueDepth();
+    return request.placeholder;
+}
+
+QNetworkReply *EnginioClientPrivate::send(const ScheduledRequest &request)
+{
+    bool probe;
+    if (!acquireCircuit(request.request.url(), &probe)) {
+        QNetworkReply *reply = new EnginioFakeReply(this, constructErrorMessage(QByteArrayLiteral("EnginioClient: The service is unavailable, the request was not sent")),
+                                                    QNetworkReply::UnknownServerError, 503);
+        if (request.device)
+            request.device->setParent(reply);
+        if (request.multiPart)
+            request.multiPart->setParent(reply);
+        ++_rejectedRequests;
+        return reply;
+    }
+
+    _prewarmTimer->stop(); // the request opens the connection itself
+    const int manager = chooseNetworkManager(requestPriority(request.request));
+    QNetworkAccessManager *qnam = _networkManagers[manager];
+    QNetworkRequest networkRequest(request.request);
+    applySessionTicket(networkRequest);
+    QNetworkReply *reply = 0;
+    switch (request.operation) {
+    case QNetworkAccessManager::GetOperation:
+        reply = qnam->get(networkRequest);
+        break;
+    case QNetworkAccessManager::PostOperation:
+        if (request.multiPart)
+            reply = qnam->post(networkRequest, request.multiPart);
+        else
+            reply = qnam->post(networkRequest, request.data);
+        break;
+    case QNetworkAccessManager::PutOperation:
+        if (request.device)
+            reply = qnam->put(networkRequest, request.device);
+        else
+            reply = qnam->put(networkRequest, request.data);
+        break;
+    case QNetworkAccessManager::DeleteOperation:
+#if QT_VERSION < QT_VERSION_CHECK(5, 2, 0)
+        reply = qnam->deleteResource(networkRequest);
+#else
+        reply = qnam->deleteResource(networkRequest, request.data);
+#endif
+        break;
+    default:
+        reply = qnam->sendCustomRequest(networkRequest, request.verb, request.device);
+    }
+    _requestBucket.take(1);
+    _byteBucket.take(request.size);
+
+    if (request.device)
+        request.device->setParent(reply);
+    if (request.multiPart)
+        request.multiPart->setParent(reply);
+    if (request.reportsUploadProgress)
+        _connections.append(QObject::connect(reply, &QNetworkReply::uploadProgress, UploadProgressFunctor(this, reply)));
+
+    ActiveRequest &active = _activeRequests[reply];
+    active.request = request;
+    active.request.placeholder = 0;
+    ++active.request.attempts;
+    active.destroyedConnection = QObject::connect(reply, &QObject::destroyed, ReplyDestroyedFunctor(this, reply));
+    active.sentAt = _clock.elapsed();
+    active.probe = probe;
+    active.networkManager = manager;
+    ++_activeRequestCount[requestPriority(request.request)];
+    ++_networkManagerLoad[manager];
+
+    if (request.hedgeable && _hedgedReads) {
+        // every read earns a part of a hedge, a few can be saved up for a burst of slow replies
+        _hedgeTokens = qMin(_hedgeTokens + _maxHedgeRatio, qMax(1.0, 10 * _maxHedgeRatio));
+        if (const qint64 delay = hedgeDelay()) {
+            active.hedgeTimer = new QTimer;
+            active.hedgeTimer->setSingleShot(true);
+            QObject::connect(active.hedgeTimer, &QTimer::timeout, HedgeFunctor(this, reply));
+            active.hedgeTimer->start(delay);
+        }
+    }
+    return reply;
+}
+
+void EnginioClientPrivate::dispatch(const ScheduledRequest &request)
+{
+    EnginioDeferredReply *placeholder = request.placeholder;
+    if (!placeholder)
+        return; // the reply was deleted while waiting, together with the request body
+    QByteArray data;
+    if (gEnableEnginioDebugInfo)
+        data = _requestData.take(placeholder);
+
+    QNetworkReply *reply = send(request);
+    if (_chunkedUploads.contains(placeholder))
+        _chunkedUploads.insert(reply, _chunkedUploads.take(placeholder));
+    if (EnginioReply *ereply = _replyReplyMap.value(placeholder))
+        ereply->setNetworkReply(reply); // deletes the placeholder
+    else
+        delete placeholder;
+
+    if (gEnableEnginioDebugInfo && !data.isEmpty())
+        _requestData.insert(reply, data);
+}
+
+void EnginioClientPrivate::dispatchQueued()
+{
+    for (int i = 0; i < PriorityCount; ++i) {
+        const EnginioClient::Priority priority = static_cast<EnginioClient::Priority>(i);
+        while (!_queuedRequests[priority].isEmpty() && hasFreeSlot(priority)) {
+            if (isRateLimited()) {
+                updateQueueDepth();
+                return;
+            }
+            dispatch(_queuedRequests[priority].takeFirst());
+        }
+    }
+    updateQueueDepth();
+}
+
+bool EnginioClientPrivate::isRateLimited()
+{
+    const qint64 now = _clock.elapsed();
+    _requestBucket.refill(now);
+    _byteBucket.refill(now);
+    const qint64 wait = qMax(_requestBucket.msecsToAvailable(), _byteBucket.msecsToAvailable());
+    if (!wait)
+        return false;
+
+    if (!_rateLimitTimer) {
+        _rateLimitTimer = new QTimer;
+        _rateLimitTimer->setSingleShot(true);
+        QObject::connect(_rateLimitTimer, &QTimer::timeout, DispatchQueuedFunctor(this));
+    }
+    if (!_rateLimitTimer->isActive())
+        _rateLimitTimer->start(wait);
+    return true;
+}
+
+void EnginioClientPrivate::updateQueueDepth()
+{
+    int depth = 0;
+    for (int i = 0; i < PriorityCount; ++i)
+        depth += _queuedRequests[i].count();
+    if (depth == _queueDepth)
+        return;
+
+    const bool wasSaturated = _queueDepth > 0;
+    _queueDepth = depth;
+    emit q_ptr->queueDepthChanged(depth);
+    if (wasSaturated != (depth > 0))
+        emit q_ptr->saturatedChanged(depth > 0);
+}
+
+void EnginioClientPrivate::setMaxRequestsPerSecond(double rate)
+{
+    _requestBucket.reset(qMax(0.0, rate), _clock.elapsed());
+    emit q_ptr->maxRequestsPerSecondChanged(_requestBucket.rate);
+    dispatchQueued();
+}
+
+void EnginioClientPrivate::setMaxBytesPerSecond(qint64 rate)
+{
+    _byteBucket.reset(qMax(qint64(0), rate), _clock.elapsed());
+    emit q_ptr->maxBytesPerSecondChanged(_byteBucket.rate);
+    dispatchQueued();
+}
+
+void EnginioClientPrivate::setMaxAttempts(int attempts)
+{
+    _maxAttempts = qMax(1, attempts);
+    emit q_ptr->maxAttemptsChanged(_maxAttempts);
+}
+
+void EnginioClientPrivate::setRetryDelay(int msecs)
+{
+    _retryDelay = qMax(0, msecs);
+    emit q_ptr->retryDelayChanged(_retryDelay);
+}
+
+void EnginioClientPrivate::setRetryJitter(double jitter)
+{
+    _retryJitter = qBound(0.0, jitter, 1.0);
+    emit q_ptr->retryJitterChanged(_retryJitter);
+}
+
+QString EnginioClientPrivate::circuitKey(const QUrl &url)
+{
+    return url.scheme() + QStringLiteral("://") + url.host() + QLatin1Char(':') + QString::number(url.port());
+}
+
+EnginioClientPrivate::CircuitBreaker::State EnginioClientPrivate::circuitState(const QUrl &url) const
+{
+    if (_circuitBreakerThreshold <= 0)
+        return CircuitBreaker::Closed;
+    QHash<QString, CircuitBreaker>::const_iterator i = _circuitBreakers.constFind(circuitKey(url));
+    if (i == _circuitBreakers.constEnd())
+        return CircuitBreaker::Closed;
+    if (i->state == CircuitBreaker::Open && _clock.elapsed() - i->openedAt >= _circuitBreakerTimeout)
+        return CircuitBreaker::HalfOpen;
+    return i->state;
+}
+
+bool EnginioClientPrivate::isCircuitRejecting(const QUrl &url) const
+{
+    // a half open circuit lets one probe through, it is queued like any other request
+    switch (circuitState(url)) {
+    case CircuitBreaker::Open:
+        return true;
+    case CircuitBreaker::HalfOpen:
+        return _circuitBreakers.value(circuitKey(url)).probing;
+    default:
+        break;
+    }
+    return false;
+}
+
+bool EnginioClientPrivate::acquireCircuit(const QUrl &url, bool *probe)
+{
+    *probe = false;
+    const CircuitBreaker::State state = circuitState(url);
+    if (state == CircuitBreaker::Closed)
+        return true;
+
+    CircuitBreaker &breaker = _circuitBreakers[circuitKey(url)];
+    breaker.state = state;
+    if (state == CircuitBreaker::Open || breaker.probing)
+        return false;
+    // only one request at a time tests whether the endpoint recovered
+    breaker.probing = true;
+    *probe = true;
+    return true;
+}
+
+void EnginioClientPrivate::recordOutcome(QNetworkReply *nreply, const ActiveRequest &active)
+{
+    if (_circuitBreakerThreshold <= 0 || nreply->error() == QNetworkReply::OperationCanceledError)
+        return;
+    const int status = nreply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const qint64 now = _clock.elapsed();
+    const bool failed = status >= 500 || status == 408
+            || (!status && nreply->error() != QNetworkReply::NoError)
+            || now - active.sentAt > CircuitBreaker::SlowRequestMsecs;
+
+    CircuitBreaker &breaker = _circuitBreakers[circuitKey(active.request.request.url())];
+    if (active.probe) {
+        if (failed)
+            breaker.open(now);
+        else
+            breaker.close();
+        return;
+    }
+    if (breaker.state != CircuitBreaker::Closed)
+        return; // sent before the circuit was opened
+    breaker.record(failed);
+    if (breaker.samples >= CircuitBreaker::MinimumSamples && breaker.errorRate() >= _circuitBreakerThreshold)
+        breaker.open(now);
+}
+
+void EnginioClientPrivate::setCircuitBreakerThreshold(double threshold)
+{
+    _circuitBreakerThreshold = qBound(0.0, threshold, 1.0);
+    _circuitBreakers.clear();
+    emit q_ptr->circuitBreakerThresholdChanged(_circuitBreakerThreshold);
+}
+
+void EnginioClientPrivate::setCircuitBreakerTimeout(int msecs)
+{
+    _circuitBreakerTimeout = qMax(0, msecs);
+    emit q_ptr->circuitBreakerTimeoutChanged(_circuitBreakerTimeout);
+}
+
+void EnginioClientPrivate::setHedgedReads(bool hedgedReads)
+{
+    _hedgedReads = hedgedReads;
+    emit q_ptr->hedgedReadsChanged(hedgedReads);
+}
+
+void EnginioClientPrivate::setMaxHedgeRatio(double ratio)
+{
+    _maxHedgeRatio = qBound(0.0, ratio, 1.0);
+    emit q_ptr->maxHedgeRatioChanged(_maxHedgeRatio);
+}
+
+bool EnginioClientPrivate::releaseSlot(QNetworkReply *nreply, ActiveRequest *active)
+{
+    QHash<QNetworkReply*, ActiveRequest>::iterator i = _activeRequests.find(nreply);
+    if (i == _activeRequests.end())
+        return false;
+    QObject::disconnect(i->destroyedConnection);
+    --_activeRequestCount[requestPriority(i->request.request)];
+    --_networkManagerLoad[i->networkManager];
+    if (i->hedgeTimer)
+        i->hedgeTimer->deleteLater();
+    if (i->hedge && _activeRequests.contains(i->hedge))
+        _activeRequests[i->hedge].hedge = 0;
+    if (i->probe) {
+        QHash<QString, CircuitBreaker>::iterator breaker = _circuitBreakers.find(circuitKey(i->request.request.url()));
+        if (breaker != _circuitBreakers.end())
+            breaker->probing = false;
+    }
+    if (active)
+        *active = *i;
+    _activeRequests.erase(i);
+    dispatchQueued();
+    return true;
+}
+
+void EnginioClientPrivate::replyDestroyed(QNetworkReply *nreply)
+{
+    QNetworkReply *hedge = _activeRequests.value(nreply).hedge;
+    releaseSlot(nreply);
+    // nobody waits for the other reply of a hedged read anymore, its transfer is aborted
+    if (hedge && _activeRequests.contains(hedge) && !_replyReplyMap.contains(hedge))
+        delete hedge;
+}
+
+bool EnginioClientPrivate::requestFinished(QNetworkReply *nreply, const ActiveRequest &active)
+{
+    QNetworkReply *other = _activeRequests.contains(active.hedge) ? active.hedge : 0;
+    const bool hedgeWon = other && !active.request.hedgeable;
+    const bool failed = nreply->error() != QNetworkReply::NoError;
+    recordOutcome(nreply, active);
+
+    if (!failed)
+        storeSessionTicket(nreply);
+    if (!failed && (active.request.hedgeable || hedgeWon)) {
+        const qint64 sentAt = hedgeWon ? _activeRequests.value(other).sentAt : active.sentAt;
+        _readLatency.add(_clock.elapsed() - sentAt);
+    }
+
+    if (!other)
+        return true;
+    if (failed) {
+        // the other reply of the hedged read may still succeed, it takes over
+        if (EnginioReply *ereply = _replyReplyMap.take(nreply)) {
+            if (gEnableEnginioDebugInfo)
+                _requestData.remove(nreply);
+            ereply->d->_nreply = other;
+            ereply->d->_data = QJsonObject();
+            other->setParent(ereply);
+            registerReply(other, ereply);
+        }
+        nreply->deleteLater(); // it is emitting finished()
+        return false;
+    }
+    // the first successful reply of a hedged read is taken, the other one is aborted
+    if (hedgeWon) {
+        ++_hedgeWins;
+        if (EnginioReply *ereply = _replyReplyMap.value(other)) {
+            ereply->setNetworkReply(nreply); // deletes the other one
+            return true;
+        }
+    }
+    delete other;
+    return true;
+}
+
+qint64 EnginioClientPrivate::hedgeDelay() const
+{
+    // the percentile is not meaningful for the first few reads
+    if (_readLatency.count < 20)
+        return 0;
+    return _readLatency.percentile(0.95);
+}
+
+void EnginioClientPrivate::sendHedge(QNetworkReply *nreply)
+{
+    QHash<QNetworkReply*, ActiveRequest>::iterator i = _activeRequests.find(nreply);
+    if (i == _activeRequests.end())
+        return;
+    i->hedgeTimer->deleteLater();
+    i->hedgeTimer = 0;
+    if (i->hedge || _hedgeTokens < 1 || circuitState(i->request.request.url()) != CircuitBreaker::Closed)
+        return;
+    // the duplicate is not sent when it would have to wait, for a slot or for the rate limit
+    const EnginioClient::Priority priority = requestPriority(i->request.request);
+    if (!_queuedRequests[priority].isEmpty() || !hasFreeSlot(priority) || isRateLimited())
+        return;
+
+    ScheduledRequest request = i->request;
+    request.hedgeable = false;
+    --request.attempts; // it is the same attempt
+    QNetworkReply *hedge = send(request);
+    _activeRequests[nreply].hedge = hedge;
+    _activeRequests[hedge].hedge = nreply;
+    _hedgeTokens -= 1;
+    ++_hedgeCount;
+}
+
+bool EnginioClientPrivate::isRetryable(QNetworkReply *nreply, const ScheduledRequest &request) const
+{
+    if (!request.retryable || request.attempts >= _maxAttempts)
+        return false;
+    const int status = nreply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status)
+        return _retryStatusCodes.contains(status);
+    return _retryNetworkErrors.contains(nreply->error());
+}
+
+bool EnginioClientPrivate::scheduleRetry(EnginioReply *ereply, QNetworkReply *nreply, ScheduledRequest request)
+{
+    if (!isRetryable(nreply, request))
+        return false;
+
+    // the failed reply, owning the body, is deleted when the retry replaces it
+    if (request.device)
+        request.device->setParent(0);
+
+    PendingRetry retry;
+    retry.request = request;
+    retry.reply = ereply;
+    retry.chunkState = _chunkedUploads.take(nreply);
+
+    // exponential backoff, shortened by a random part to spread the retries of many clients
+    qint64 delay = qint64(_retryDelay) << qMin(request.attempts - 1, 16);
+    delay -= qint64(delay * _retryJitter * (qrand() % 1000) / 1000);
+
+    QTimer *timer = new QTimer;
+    timer->setSingleShot(true);
+    QObject::connect(timer, &QTimer::timeout, RetryFunctor(this, timer));
+    timer->start(int(qMin(delay, qint64(24 * 60 * 60 * 1000))));
+    _pendingRetries.insert(timer, retry);
+    ++_retryCount;
+    return true;
+}
+
+void EnginioClientPrivate::sendRetry(QTimer *timer)
+{
+    PendingRetry retry = _pendingRetries.take(timer);
+    timer->deleteLater();
+    if (!retry.reply) {
+        delete retry.request.device;
+        delete retry.chunkState.first;
+        return;
+    }
+
+    if (retry.request.device)
+        retry.request.device->seek(0);
+    QNetworkReply *reply = schedule(retry.request);
+    if (retry.chunkState.first)
+        _chunkedUploads.insert(reply, retry.chunkState);
+    retry.reply->setNetworkReply(reply);
+
+    if (gEnableEnginioDebugInfo && !retry.request.data.isEmpty())
+        _requestData.insert(reply, retry.request.data);
+}
+
+bool EnginioClientPrivate::findQueued(const QNetworkReply *placeholder, int *priority, int *index) const
+{
+    for (int i = 0; i < PriorityCount; ++i) {
+        const QList<ScheduledRequest> &queue = _queuedRequests[i];
+        for (int j = 0; j < queue.count(); ++j) {
+            if (queue[j].placeholder.data() == placeholder) {
+                *priority = i;
+                *index = j;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool EnginioClientPrivate::setPriority(EnginioReply *ereply, const EnginioClient::Priority priority)
+{
+    int oldPriority, index;
+    if (!findQueued(ereply->d->_nreply, &oldPriority, &index))
+        return false;
+    if (oldPriority == priority)
+        return true;
+
+    ScheduledRequest request = _queuedRequests[oldPriority].takeAt(index);
+    request.request.setPriority(networkPriority(priority));
+    _queuedRequests[priority].append(request);
+    dispatchQueued();
+    return true;
+}
+
+bool EnginioClientPrivate::cancelQueued(EnginioReply *ereply)
+{
+    int priority, index;
+    if (!findQueued(ereply->d->_nreply, &priority, &index))
+        return false;
+
+    ScheduledRequest request = _queuedRequests[priority].takeAt(index);
+    delete request.device;
+    delete request.multiPart;
+    // finishes the reply with QNetworkReply::OperationCanceledError
+    request.placeholder->abort();
+    updateQueueDepth();
+    return true;
+}
+
+QTimer *EnginioClientPrivate::pendingRetryTimer(const EnginioReply *ereply) const
+{
+    for (QHash<QTimer*, PendingRetry>::const_iterator i = _pendingRetries.constBegin(); i != _pendingRetries.constEnd(); ++i) {
+        if (i->reply == ereply)
+            return i.key();
+    }
+    return 0;
+}
+
+bool EnginioClientPrivate::isPending(const EnginioReply *ereply) const
+{
+    return _replyReplyMap.value(ereply->d->_nreply) == ereply || pendingRetryTimer(ereply);
+}
+
+bool EnginioClientPrivate::finishEarly(EnginioReply *ereply, QNetworkReply::NetworkError error, const QByteArray &message)
+{
+    QNetworkReply *nreply = ereply->d->_nreply;
+    if (qobject_cast<EnginioFakeReply*>(nreply))
+        return false; // finishes already with a local error
+    int priority, index;
+    QTimer *retryTimer = pendingRetryTimer(ereply);
+
+    if (findQueued(nreply, &priority, &index)) {
+        ScheduledRequest request = _queuedRequests[priority].takeAt(index);
+        delete request.device;
+        delete request.multiPart;
+        updateQueueDepth();
+    } else if (retryTimer) {
+        PendingRetry retry = _pendingRetries.take(retryTimer);
+        delete retryTimer;
+        delete retry.request.device;
+        delete retry.chunkState.first;
+    } else if (_replyReplyMap.value(nreply) == ereply) {
+        // the aborted reply must not finish the EnginioReply, its slot is released right away
+        _replyReplyMap.remove(nreply);
+        QHash<QNetworkReply*, ActiveRequest>::const_iterator active = _activeRequests.constFind(nreply);
+        if (active != _activeRequests.constEnd() && active->hedge)
+            delete active->hedge;
+        nreply->abort();
+    } else {
+        return false; // finished already
+    }
+
+    QPair<QIODevice *, qint64> deviceState = _chunkedUploads.take(nreply);
+    delete deviceState.first;
+    if (error == QNetworkReply::TimeoutError)
+        ++_timedOutRequests;
+    // finishes the reply with the error, like any other failed request
+    ereply->setNetworkReply(new EnginioFakeReply(this, message, error, 0));
+    return true;
+}
+
+void EnginioClientPrivate::setRequestTimeout(int msecs)
+{
+    _requestTimeout = qMax(0, msecs);
+    emit q_ptr->requestTimeoutChanged(_requestTimeout);
+}
+
+void EnginioClientPrivate::setMaxActiveRequests(const EnginioClient::Priority priority, int count)
+{
+    _maxActiveRequests[priority] = qMax(0, count);
+    dispatchQueued();
+}
+
+EnginioNotificationChannel *EnginioClientPrivate::subscribe(const QString &objectType)
+{
+    QPair<EnginioNotificationChannel*, int> &subscription = _notificationChannels[objectType];
+    if (!subscription.second++)
+        subscription.first = new EnginioNotificationChannel(this, objectType);
+    return subscription.first;
+}
+
+void EnginioClientPrivate::unsubscribe(const QString &objectType)
+{
+    QHash<QString, QPair<EnginioNotificationChannel*, int> >::iterator i = _notificationChannels.find(objectType);
+    if (i == _notificationChannels.end() || --i->second)
+        return;
+    // it may be called from a handler of the channel's own signal
+    i->first->stop();
+    i->first->deleteLater();
+    _notificationChannels.erase(i);
 }
 
 /*!
@@ -344,10 +1022,8 @@ QUrl EnginioClient::serviceUrl() const
 void EnginioClient::setServiceUrl(const QUrl &serviceUrl)
 {
     Q_D(EnginioClient);
-    if (d->_serviceUrl != serviceUrl) {
-        d->_serviceUrl = serviceUrl;
-        emit serviceUrlChanged(serviceUrl);
-    }
+    if (d->_serviceUrl != serviceUrl)
+        d->setServiceUrl(serviceUrl);
 }
 
 /*!
@@ -361,6 +1037,32 @@ QNetworkAccessManager * EnginioClient::networkManager() const
     return d->networkManager();
 }
 
+/*!
+  \brief Get runtime statistics of the client.
+
+  The returned object contains:
+  \list
+  \li \c cachedObjects - the number of objects held in the cache shared by the models of the client
+  \li \c internedStrings - the number of distinct property names and short string values in the cache
+  \li \c internedBytesSaved - an estimate of the memory saved by storing repeated strings only once
+  \li \c activeRequests - the number of requests sent to the backend which did not finish yet
+  \li \c queuedRequests - the number of requests waiting for a free slot of their \l Priority
+  \li \c retries - the number of failed requests which were sent again
+  \li \c readLatencyP50, \c readLatencyP95, \c readLatencyP99 - percentiles of the recent response times
+  of queries and file downloads in milliseconds, rounded up to the histogram bucket
+  \li \c hedges - the number of duplicate reads sent by \l hedgedReads
+  \li \c hedgeWins - the number of duplicate reads which finished before the original request
+  \li \c openCircuits - the number of endpoints for which requests currently fail fast
+  \li \c rejectedRequests - the number of requests which failed fast without being sent
+  \li \c timedOutRequests - the number of replies which did not finish within their \l {EnginioReply::timeout}{timeout}
+  \endlist
+*/
+QJsonObject EnginioClient::metrics() const
+{
+    Q_D(const EnginioClient);
+    return d->metrics();
+}
+
 /*!
   \brief Create custom request to the enginio REST API
 
@@ -390,15 +1092,16 @@ EnginioReply *EnginioClient::customRequest(const QUrl &url, const QByteArray &ht
 
   The \a query is JSON sent to the backend to perform a fulltext search.
   Note that the search requires the searched properties to be indexed (on the server, configureable in the backend).
+  The request is sent with the given \a priority.
 
   \return EnginioReply containing the status and the result once it is finished.
   \sa EnginioReply, create(), query(), update(), remove()
 */
-EnginioReply *EnginioClient::search(const QJsonObject &query)
+EnginioReply *EnginioClient::search(const QJsonObject &query, const Priority priority)
 {
     Q_D(EnginioClient);
 
-    QNetworkReply *nreply = d->query<QJsonObject>(query, EnginioClientPrivate::SearchOperation);
+    QNetworkReply *nreply = d->query<QJsonObject>(query, EnginioClientPrivate::SearchOperation, priority);
     EnginioReply *ereply = new EnginioReply(d, nreply);
     return ereply;
 }
@@ -407,19 +1110,24 @@ EnginioReply *EnginioClient::search(const QJsonObject &query)
   \brief Query the database.
 
   The \a query is a JSON object containing the actual query to the backend.
-  The query will be run on the \a operation part of the backend.
+  The query will be run on the \a operation part of the backend. The request
+  is sent with the given \a priority.
 
   To query the database of all objects of type "objects.todo":
   \snippet enginioclient/tst_enginioclient.cpp query-todo
 
+  To download only some of the properties of the objects, list them in the \c fields
+  array of the query, for example \c {"fields": ["title", "completed"]}. The \c id,
+  \c objectType, \c createdAt and \c updatedAt properties are always returned.
+
   \return EnginioReply containing the status and the result once it is finished.
   \sa EnginioReply, create(), update(), remove(), Operation
  */
-EnginioReply* EnginioClient::query(const QJsonObject &query, const Operation operation)
+EnginioReply* EnginioClient::query(const QJsonObject &query, const Operation operation, const Priority priority)
 {
     Q_D(EnginioClient);
 
-    QNetworkReply *nreply = d->query<QJsonObject>(query, static_cast<EnginioClientPrivate::Operation>(operation));
+    QNetworkReply *nreply = d->query<QJsonObject>(query, static_cast<EnginioClientPrivate::Operation>(operation), priority);
     EnginioReply *ereply = new EnginioReply(d, nreply);
 
     return ereply;
@@ -429,18 +1137,21 @@ EnginioReply* EnginioClient::query(const QJsonObject &query, const Operation ope
   \brief Insert a new \a object into the database.
 
   The \a operation is the area in which the object gets created. It defaults to \l ObjectOperation
-  to create new objects by default.
+  to create new objects by default. The request is sent with the given \a priority.
 
   \snippet enginioclient/tst_enginioclient.cpp create-todo
 
+  Every call sends a unique \c Idempotency-Key header, which stays the same when
+  the request is retried, so that the object is created only once.
+
   \return EnginioReply containing the status of the query and the data once it is finished.
   \sa EnginioReply, query(), update(), remove()
 */
-EnginioReply* EnginioClient::create(const QJsonObject &object, const Operation operation)
+EnginioReply* EnginioClient::create(const QJsonObject &object, const Operation operation, const Priority priority)
 {
     Q_D(EnginioClient);
 
-    QNetworkReply *nreply = d->create<QJsonObject>(object, operation);
+    QNetworkReply *nreply = d->create<QJsonObject>(object, operation, priority);
     EnginioReply *ereply = new EnginioReply(d, nreply);
 
     return ereply;
@@ -450,15 +1161,15 @@ EnginioReply* EnginioClient::create(const QJsonObject &object, const Operation o
   \brief Update an existing \a object in the database.
 
   The \a operation is the area in which the object gets created. It defaults to \l ObjectOperation
-  to create new objects by default.
+  to create new objects by default. The request is sent with the given \a priority.
   \return EnginioReply containing the status of the query and the data once it is finished.
   \sa EnginioReply, create(), query(), remove()
 */
-EnginioReply* EnginioClient::update(const QJsonObject &object, const Operation operation)
+EnginioReply* EnginioClient::update(const QJsonObject &object, const Operation operation, const Priority priority)
 {
     Q_D(EnginioClient);
 
-    QNetworkReply *nreply = d->update<QJsonObject>(object, operation);
+    QNetworkReply *nreply = d->update<QJsonObject>(object, operation, priority);
     EnginioReply *ereply = new EnginioReply(d, nreply);
 
     return ereply;
@@ -468,18 +1179,18 @@ EnginioReply* EnginioClient::update(const QJsonObject &object, const Operation o
   \brief Remove an existing \a object from the database.
 
   The \a operation is the area in which the object gets created. It defaults to \l ObjectOperation
-  to create new objects by default.
+  to create new objects by default. The request is sent with the given \a priority.
 
   \snippet enginioclient/tst_enginioclient.cpp remove-todo
 
   \return EnginioReply containing the status of the query and the data once it is finished.
   \sa EnginioReply, create(), query(), update()
 */
-EnginioReply* EnginioClient::remove(const QJsonObject &object, const Operation operation)
+EnginioReply* EnginioClient::remove(const QJsonObject &object, const Operation operation, const Priority priority)
 {
     Q_D(EnginioClient);
 
-    QNetworkReply *nreply = d->remove<QJsonObject>(object, operation);
+    QNetworkReply *nreply = d->remove<QJsonObject>(object, operation, priority);
     EnginioReply *ereply = new EnginioReply(d, nreply);
 
     return ereply;
@@ -523,13 +1234,16 @@ void EnginioClient::setIdentity(EnginioIdentity *identity)
   Instead when the object that contains the link to the file gets deleted,
   the file will automatically be deleted as well.
 
+  The upload is sent with the given \a priority, by default \l BackgroundPriority,
+  so that it does not delay other requests.
+
   \sa downloadFile()
 */
-EnginioReply* EnginioClient::uploadFile(const QJsonObject &object, const QUrl &file)
+EnginioReply* EnginioClient::uploadFile(const QJsonObject &object, const QUrl &file, const Priority priority)
 {
     Q_D(EnginioClient);
 
-    QNetworkReply *nreply = d->uploadFile<QJsonObject>(object, file);
+    QNetworkReply *nreply = d->uploadFile<QJsonObject>(object, file, priority);
     EnginioReply *ereply = new EnginioReply(d, nreply);
 
     return ereply;
@@ -550,39 +1264,660 @@ EnginioReply* EnginioClient::uploadFile(const QJsonObject &object, const QUrl &f
         "variant": "thumbnail"
     }
   \endcode
+  The request is sent with the given \a priority.
 */
-EnginioReply* EnginioClient::downloadFile(const QJsonObject &object)
+EnginioReply* EnginioClient::downloadFile(const QJsonObject &object, const Priority priority)
 {
     Q_D(EnginioClient);
 
-    QNetworkReply *nreply = d->downloadFile<QJsonObject>(object);
+    QNetworkReply *nreply = d->downloadFile<QJsonObject>(object, priority);
     EnginioReply *ereply = new EnginioReply(d, nreply);
 
     return ereply;
 }
 
-Q_GLOBAL_STATIC(QThreadStorage<QNetworkAccessManager*>, NetworkManager)
+/*!
+  \brief The maximum number of requests of the given \a priority running at the same time.
+
+  \sa setMaxConcurrentRequests()
+*/
+int EnginioClient::maxConcurrentRequests(const Priority priority) const
+{
+    Q_D(const EnginioClient);
+    return d->_maxActiveRequests[priority];
+}
+
+/*!
+  \brief Limit the number of requests of the given \a priority running at the same time to \a count.
+
+  Further requests of the priority wait until one of the running requests finishes.
+  The defaults are 6 for \l InteractivePriority and \l NormalPriority, the number of
+  connections QNetworkAccessManager opens to a host, and 2 for \l BackgroundPriority.
+  The value 0 removes the limit.
+*/
+void EnginioClient::setMaxConcurrentRequests(const Priority priority, int count)
+{
+    Q_D(EnginioClient);
+    if (d->_maxActiveRequests[priority] == count)
+        return;
+    d->setMaxActiveRequests(priority, count);
+}
+
+/*!
+  \brief Move the request of \a reply, which is waiting to be sent, to the queue of \a priority.
+
+  The request is sent after the requests waiting in that queue already.
+  \return false if the request was sent already.
+  \sa cancelQueued()
+*/
+bool EnginioClient::setPriority(EnginioReply *reply, const Priority priority)
+{
+    Q_D(EnginioClient);
+    return reply && d->setPriority(reply, priority);
+}
+
+/*!
+  \brief Drop the request of \a reply, which is waiting to be sent.
+
+  The \a reply finishes with the QNetworkReply::OperationCanceledError error.
+  \return false if the request was sent already.
+  \sa setPriority()
+*/
+bool EnginioClient::cancelQueued(EnginioReply *reply)
+{
+    Q_D(EnginioClient);
+    return reply && d->cancelQueued(reply);
+}
+
+/*!
+  \property EnginioClient::maxRequestsPerSecond
+  \brief The maximum number of requests sent to the backend per second.
+
+  Requests above the rate are not failed, they wait until they can be sent.
+  Short bursts of up to one second worth of requests are sent immediately.
+  The default value 0 disables the limit.
+  \sa maxBytesPerSecond, queueDepth
+*/
+double EnginioClient::maxRequestsPerSecond() const
+{
+    Q_D(const EnginioClient);
+    return d->_requestBucket.rate;
+}
+
+void EnginioClient::setMaxRequestsPerSecond(double rate)
+{
+    Q_D(EnginioClient);
+    if (d->_requestBucket.rate == rate)
+        return;
+    d->setMaxRequestsPerSecond(rate);
+}
+
+/*!
+  \property EnginioClient::maxBytesPerSecond
+  \brief The maximum number of bytes of request data sent to the backend per second.
+
+  A request bigger than the limit is sent when the bytes of the previous requests
+  are paid off, the following requests wait accordingly longer.
+  The default value 0 disables the limit.
+  \sa maxRequestsPerSecond, queueDepth
+*/
+qint64 EnginioClient::maxBytesPerSecond() const
+{
+    Q_D(const EnginioClient);
+    return d->_byteBucket.rate;
+}
+
+void EnginioClient::setMaxBytesPerSecond(qint64 rate)
+{
+    Q_D(EnginioClient);
+    if (d->_byteBucket.rate == rate)
+        return;
+    d->setMaxBytesPerSecond(rate);
+}
+
+/*!
+  \property EnginioClient::queueDepth
+  \brief The number of requests waiting to be sent.
+
+  Requests wait for the rate limit or for a free slot of their \l Priority.
+  Producers of many requests can watch it to slow down.
+  \sa saturated
+*/
+int EnginioClient::queueDepth() const
+{
+    Q_D(const EnginioClient);
+    return d->_queueDepth;
+}
+
+/*!
+  \property EnginioClient::saturated
+  \brief Whether new requests have to wait before they are sent.
+  \sa queueDepth
+*/
+bool EnginioClient::isSaturated() const
+{
+    Q_D(const EnginioClient);
+    return d->_queueDepth > 0;
+}
+
+/*!
+  \property EnginioClient::maxAttempts
+  \brief How many times an idempotent request is sent before its error is reported.
+
+  Queries, creation of objects, file downloads and the chunks of file uploads which fail with one of the
+  \l retryStatusCodes() or \l retryNetworkErrors() are sent again after a delay. The
+  EnginioReply is finished only once, with the result of the last attempt.
+  The default value is 3, the value 1 disables retries.
+  \sa retryDelay, retryJitter
+*/
+int EnginioClient::maxAttempts() const
+{
+    Q_D(const EnginioClient);
+    return d->_maxAttempts;
+}
+
+void EnginioClient::setMaxAttempts(int attempts)
+{
+    Q_D(EnginioClient);
+    if (d->_maxAttempts == attempts)
+        return;
+    d->setMaxAttempts(attempts);
+}
+
+/*!
+  \property EnginioClient::retryDelay
+  \brief The delay in milliseconds before the first retry of a failed request.
+
+  The delay doubles with each further attempt. The default value is 250.
+  \sa maxAttempts, retryJitter
+*/
+int EnginioClient::retryDelay() const
+{
+    Q_D(const EnginioClient);
+    return d->_retryDelay;
+}
+
+void EnginioClient::setRetryDelay(int msecs)
+{
+    Q_D(EnginioClient);
+    if (d->_retryDelay == msecs)
+        return;
+    d->setRetryDelay(msecs);
+}
+
+/*!
+  \property EnginioClient::retryJitter
+  \brief The part of the retry delay, between 0 and 1, which is randomly left out.
+
+  The randomness keeps many clients from retrying at the same moment after a
+  failure of the backend. The default value is 0.5.
+  \sa retryDelay
+*/
+double EnginioClient::retryJitter() const
+{
+    Q_D(const EnginioClient);
+    return d->_retryJitter;
+}
+
+void EnginioClient::setRetryJitter(double jitter)
+{
+    Q_D(EnginioClient);
+    if (d->_retryJitter == jitter)
+        return;
+    d->setRetryJitter(jitter);
+}
+
+/*!
+  \property EnginioClient::hedgedReads
+  \brief Whether slow queries and file downloads are sent a second time.
+
+  When a read does not finish within the 95th percentile of the recent response
+  times, a duplicate request is sent. The first successful reply is used and the other
+  request is aborted, a failed reply is used only if both fail. The number of duplicates
+  is limited by \l maxHedgeRatio. Duplicates count against maxConcurrentRequests() and the
+  rate limits like any other request, they are not sent if they would have to wait.
+  The default value is false.
+  \sa metrics()
+*/
+bool EnginioClient::hedgedReads() const
+{
+    Q_D(const EnginioClient);
+    return d->_hedgedReads;
+}
+
+void EnginioClient::setHedgedReads(bool hedgedReads)
+{
+    Q_D(EnginioClient);
+    if (d->_hedgedReads == hedgedReads)
+        return;
+    d->setHedgedReads(hedgedReads);
+}
+
+/*!
+  \property EnginioClient::maxHedgeRatio
+  \brief The maximum number of duplicate reads relative to the number of sent reads.
+
+  The default value 0.1 allows one duplicate for every ten reads.
+  \sa hedgedReads
+*/
+double EnginioClient::maxHedgeRatio() const
+{
+    Q_D(const EnginioClient);
+    return d->_maxHedgeRatio;
+}
+
+void EnginioClient::setMaxHedgeRatio(double ratio)
+{
+    Q_D(EnginioClient);
+    if (d->_maxHedgeRatio == ratio)
+        return;
+    d->setMaxHedgeRatio(ratio);
+}
+
+/*!
+  \property EnginioClient::circuitBreakerThreshold
+  \brief The rate of failed requests at which requests to an endpoint start to fail fast.
+
+  The last 20 requests to each endpoint are tracked. Server errors, network errors and requests
+  taking longer than ten seconds count as failures. When at least ten requests were tracked and
+  the rate of failures reaches the threshold, the circuit of the endpoint opens. While it is open
+  new requests are not sent, they finish immediately with the backend status 503.
+  After \l circuitBreakerTimeout a single probe request is sent, it waits for its turn in
+  the queue and the rate limits like any other request. If it succeeds the circuit
+  is closed again, otherwise it stays open for another timeout.
+
+  The default value is 0.5. The value 0 disables the circuit breaker.
+  \sa metrics()
+*/
+double EnginioClient::circuitBreakerThreshold() const
+{
+    Q_D(const EnginioClient);
+    return d->_circuitBreakerThreshold;
+}
+
+void EnginioClient::setCircuitBreakerThreshold(double threshold)
+{
+    Q_D(EnginioClient);
+    if (d->_circuitBreakerThreshold == threshold)
+        return;
+    d->setCircuitBreakerThreshold(threshold);
+}
+
+/*!
+  \property EnginioClient::circuitBreakerTimeout
+  \brief The time in milliseconds for which requests fail fast before a probe is sent.
+
+  The default value is 5000.
+  \sa circuitBreakerThreshold
+*/
+int EnginioClient::circuitBreakerTimeout() const
+{
+    Q_D(const EnginioClient);
+    return d->_circuitBreakerTimeout;
+}
+
+void EnginioClient::setCircuitBreakerTimeout(int msecs)
+{
+    Q_D(EnginioClient);
+    if (d->_circuitBreakerTimeout == msecs)
+        return;
+    d->setCircuitBreakerTimeout(msecs);
+}
+
+/*!
+  \property EnginioClient::requestTimeout
+  \brief The default \l {EnginioReply::timeout}{timeout} in milliseconds of new replies.
+
+  The default value 0 means that requests do not time out.
+*/
+int EnginioClient::requestTimeout() const
+{
+    Q_D(const EnginioClient);
+    return d->_requestTimeout;
+}
+
+void EnginioClient::setRequestTimeout(int msecs)
+{
+    Q_D(EnginioClient);
+    if (d->_requestTimeout == msecs)
+        return;
+    d->setRequestTimeout(msecs);
+}
+
+/*!
+  \property EnginioClient::requestGroup
+  \brief The group to which new requests are added.
+
+  While it is set, every request made by the client, including the requests of
+  models using it, is added to the group. The default value is null.
+  \sa EnginioRequestGroup::cancelAll()
+*/
+EnginioRequestGroup *EnginioClient::requestGroup() const
+{
+    Q_D(const EnginioClient);
+    return d->_requestGroup;
+}
+
+void EnginioClient::setRequestGroup(EnginioRequestGroup *group)
+{
+    Q_D(EnginioClient);
+    if (d->_requestGroup == group)
+        return;
+    d->_requestGroup = group;
+    emit requestGroupChanged(group);
+}
+
+/*!
+  \property EnginioClient::networkManagerCount
+  \brief The number of network access managers over which requests are spread.
+
+  A QNetworkAccessManager opens at most six connections to a host, so with more
+  managers more requests are transferred in parallel. The managers are shared by
+  the clients of a thread. A request is sent through the manager with the fewest
+  requests of the client in flight, see \l reserveInteractiveManager for the
+  exception. \l networkManager() returns the first one.
+
+  The default value is 1.
+  \sa maxConcurrentRequests()
+*/
+int EnginioClient::networkManagerCount() const
+{
+    Q_D(const EnginioClient);
+    return d->_networkManagerCount;
+}
+
+void EnginioClient::setNetworkManagerCount(int count)
+{
+    Q_D(EnginioClient);
+    if (d->_networkManagerCount == count)
+        return;
+    d->setNetworkManagerCount(count);
+    emit networkManagerCountChanged(d->_networkManagerCount);
+}
+
+/*!
+  \property EnginioClient::reserveInteractiveManager
+  \brief Whether the first network access manager is reserved for interactive requests.
+
+  When it is true and \l networkManagerCount is larger than one, requests of the
+  InteractivePriority are always sent through the first manager and all other
+  requests through the remaining ones. Bulk transfers then never occupy the
+  connections which interactive requests need. The default value is true.
+*/
+bool EnginioClient::reserveInteractiveManager() const
+{
+    Q_D(const EnginioClient);
+    return d->_reserveInteractiveManager;
+}
+
+void EnginioClient::setReserveInteractiveManager(bool reserve)
+{
+    Q_D(EnginioClient);
+    if (d->_reserveInteractiveManager == reserve)
+        return;
+    d->_reserveInteractiveManager = reserve;
+    emit reserveInteractiveManagerChanged(reserve);
+}
+
+/*!
+  \property EnginioClient::tlsSessionCache
+  \brief Whether the TLS session of the backend connection is kept on disk.
+
+  A stored session is resumed by the first connection of a new process, which saves a
+  round trip of the handshake. The session is stored in the cache location of the
+  application, see QStandardPaths::CacheLocation, readable only by the user.
+  Only requests to the host of \l serviceUrl resume the session.
+  It requires Qt 5.4 or later. The default value is true.
+*/
+bool EnginioClient::tlsSessionCache() const
+{
+    Q_D(const EnginioClient);
+    return d->_tlsSessionCache;
+}
+
+void EnginioClient::setTlsSessionCache(bool enabled)
+{
+    Q_D(EnginioClient);
+    if (d->_tlsSessionCache == enabled)
+        return;
+    d->_tlsSessionCache = enabled;
+    d->loadSessionTicket();
+    emit tlsSessionCacheChanged(enabled);
+}
+
+/*!
+  \brief The HTTP status codes of the backend for which a request is retried.
+
+  The defaults are 408, 429, 500, 502, 503 and 504.
+  \sa setRetryStatusCodes(), maxAttempts
+*/
+QList<int> EnginioClient::retryStatusCodes() const
+{
+    Q_D(const EnginioClient);
+    return d->_retryStatusCodes;
+}
+
+/*!
+  \brief Retry requests for which the backend answers with one of the HTTP status \a codes.
+*/
+void EnginioClient::setRetryStatusCodes(const QList<int> &codes)
+{
+    Q_D(EnginioClient);
+    d->_retryStatusCodes = codes;
+}
+
+/*!
+  \brief The network errors, without any answer of the backend, for which a request is retried.
+
+  The defaults are connection failures and timeouts.
+  \sa setRetryNetworkErrors(), maxAttempts
+*/
+QList<QNetworkReply::NetworkError> EnginioClient::retryNetworkErrors() const
+{
+    Q_D(const EnginioClient);
+    return d->_retryNetworkErrors;
+}
+
+/*!
+  \brief Retry requests which fail with one of the network \a errors.
+*/
+void EnginioClient::setRetryNetworkErrors(const QList<QNetworkReply::NetworkError> &errors)
+{
+    Q_D(EnginioClient);
+    d->_retryNetworkErrors = errors;
+}
+
+// The managers of a thread are shared by all clients in it, each client uses as many
+// of them as its networkManagerCount.
+class NetworkManagerPool
+{
+public:
+    QVector<QNetworkAccessManager*> managers;
+
+    ~NetworkManagerPool()
+    {
+        qDeleteAll(managers);
+    }
+};
+
+Q_GLOBAL_STATIC(QThreadStorage<NetworkManagerPool*>, NetworkManagers)
 
 void EnginioClientPrivate::assignNetworkManager()
 {
     Q_ASSERT(!_networkManager);
 
-    _networkManager = prepareNetworkManagerInThread();
-    _networkManagerConnection = QObject::connect(_networkManager, &QNetworkAccessManager::finished, EnginioClientPrivate::ReplyFinishedFunctor(this));
+    setNetworkManagerCount(_networkManagerCount);
+    _networkManager = _networkManagers.first();
+}
+
+void EnginioClientPrivate::setNetworkManagerCount(int count)
+{
+    _networkManagerCount = qMax(1, count);
+    // managers beyond the count stay connected until their replies are finished
+    while (_networkManagers.count() < _networkManagerCount) {
+        QNetworkAccessManager *qnam = prepareNetworkManagerInThread(_networkManagers.count());
+        _networkManagers.append(qnam);
+        _networkManagerConnections.append(QObject::connect(qnam, &QNetworkAccessManager::finished, EnginioClientPrivate::ReplyFinishedFunctor(this)));
+        _networkManagerLoad.append(0);
+    }
+}
+
+void EnginioClientPrivate::setServiceUrl(const QUrl &serviceUrl)
+{
+    _serviceUrl = serviceUrl;
+    loadSessionTicket();
+    _prewarmTimer->start(0);
+    emit q_ptr->serviceUrlChanged(serviceUrl);
 }
 
-QNetworkAccessManager *EnginioClientPrivate::prepareNetworkManagerInThread()
+void EnginioClientPrivate::prewarm()
 {
-    QNetworkAccessManager *qnam;
-    qnam = NetworkManager->localData();
-    if (!qnam) {
-        qnam = new QNetworkAccessManager(); // it will be deleted by QThreadStorage.
 #if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
-        qnam->connectToHostEncrypted(EnginioString::apiEnginIo);
+    const QString host = _serviceUrl.host();
+    if (host.isEmpty())
+        return;
+    for (int i = 0; i < _networkManagerCount; ++i) {
+#ifndef QT_NO_SSL
+        if (_serviceUrl.scheme() == QStringLiteral("https")) {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+            QNetworkRequest request(_request);
+            request.setUrl(_serviceUrl);
+            applySessionTicket(request);
+            _networkManagers[i]->connectToHostEncrypted(host, _serviceUrl.port(443), request.sslConfiguration());
+#else
+            _networkManagers[i]->connectToHostEncrypted(host, _serviceUrl.port(443));
+#endif
+            continue;
+        }
+#endif
+        _networkManagers[i]->connectToHost(host, _serviceUrl.port(80));
+    }
+#endif
+}
+
+QString EnginioClientPrivate::sessionTicketPath() const
+{
+    const QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if (directory.isEmpty() || _serviceUrl.host().isEmpty())
+        return QString();
+    return directory + QStringLiteral("/enginio-tls/") + _serviceUrl.host() + QLatin1Char('_') + QString::number(_serviceUrl.port(443));
+}
+
+bool EnginioClientPrivate::usesSessionTicket(const QUrl &url) const
+{
+    // the ticket belongs to the service, requests to other hosts never carry it
+    return _tlsSessionCache && url.scheme() == QStringLiteral("https")
+            && url.host() == _serviceUrl.host() && url.port(443) == _serviceUrl.port(443);
+}
+
+void EnginioClientPrivate::applySessionTicket(QNetworkRequest &request) const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 4, 0) && !defined(QT_NO_SSL)
+    if (!usesSessionTicket(request.url()))
+        return;
+    // a new connection resumes the session instead of a full handshake
+    QSslConfiguration configuration = request.sslConfiguration();
+    configuration.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    configuration.setSessionTicket(_sessionTicket);
+    request.setSslConfiguration(configuration);
+#else
+    Q_UNUSED(request);
+#endif
+}
+
+void EnginioClientPrivate::loadSessionTicket()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 4, 0) && !defined(QT_NO_SSL)
+    _sessionTicket.clear();
+    if (usesSessionTicket(_serviceUrl)) {
+        QFile file(sessionTicketPath());
+        if (file.open(QIODevice::ReadOnly))
+            _sessionTicket = file.readAll();
+    }
+#endif
+}
+
+void EnginioClientPrivate::storeSessionTicket(QNetworkReply *nreply)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 4, 0) && !defined(QT_NO_SSL)
+    if (!usesSessionTicket(nreply->url()))
+        return;
+    const QByteArray ticket = nreply->sslConfiguration().sessionTicket();
+    if (ticket.isEmpty() || ticket == _sessionTicket)
+        return;
+    _sessionTicket = ticket;
+
+    // The ticket gives access to the session keys. The directory is closed to other users
+    // before the file is created in it, and the file is written to a temporary file of the
+    // user which replaces the old one at once.
+    const QString path = sessionTicketPath();
+    if (path.isEmpty())
+        return;
+    const QString directory = QFileInfo(path).path();
+    if (!QDir().mkpath(directory) || !QFile::setPermissions(directory, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner))
+        return;
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    file.setPermissions(QFile::ReadOwner | QFile::WriteOwner);
+    file.write(ticket);
+    file.commit();
+#else
+    Q_UNUSED(nreply);
 #endif
-        NetworkManager->setLocalData(qnam);
+}
+
+int EnginioClientPrivate::chooseNetworkManager(const EnginioClient::Priority priority) const
+{
+    int first = 0;
+    if (_networkManagerCount > 1 && _reserveInteractiveManager) {
+        if (priority == EnginioClient::InteractivePriority)
+            return 0;
+        first = 1;
+    }
+    int manager = first;
+    for (int i = first + 1; i < _networkManagerCount; ++i) {
+        if (_networkManagerLoad[i] < _networkManagerLoad[manager])
+            manager = i;
+    }
+    return manager;
+}
+
+QJsonObject EnginioClientPrivate::metrics() const
+{
+    QJsonObject metrics;
+    metrics[QStringLiteral("cachedObjects")] = _objectStore.count();
+    metrics[QStringLiteral("internedStrings")] = _objectStore.strings().count();
+    metrics[QStringLiteral("internedBytesSaved")] = double(_objectStore.strings().bytesSaved());
+    metrics[QStringLiteral("activeRequests")] = _activeRequests.count();
+    metrics[QStringLiteral("queuedRequests")] = _queueDepth;
+    metrics[QStringLiteral("retries")] = _retryCount;
+    metrics[QStringLiteral("readLatencyP50")] = double(_readLatency.percentile(0.5));
+    metrics[QStringLiteral("readLatencyP95")] = double(_readLatency.percentile(0.95));
+    metrics[QStringLiteral("readLatencyP99")] = double(_readLatency.percentile(0.99));
+    metrics[QStringLiteral("hedges")] = _hedgeCount;
+    metrics[QStringLiteral("hedgeWins")] = _hedgeWins;
+    int openCircuits = 0;
+    foreach (const CircuitBreaker &breaker, _circuitBreakers)
+        openCircuits += breaker.state != CircuitBreaker::Closed;
+    metrics[QStringLiteral("openCircuits")] = openCircuits;
+    metrics[QStringLiteral("rejectedRequests")] = _rejectedRequests;
+    metrics[QStringLiteral("timedOutRequests")] = _timedOutRequests;
+    return metrics;
+}
+
+QNetworkAccessManager *EnginioClientPrivate::prepareNetworkManagerInThread(int index)
+{
+    NetworkManagerPool *pool = NetworkManagers->localData();
+    if (!pool) {
+        pool = new NetworkManagerPool(); // it will be deleted by QThreadStorage.
+        NetworkManagers->setLocalData(pool);
+    }
+    while (pool->managers.count() <= index) {
+        // the clients connect them to their serviceUrl, see EnginioClientPrivate::prewarm()
+        pool->managers.append(new QNetworkAccessManager());
     }
-    return qnam;
+    return pool->managers.at(index);
 }
 
 EnginioClient::AuthenticationState EnginioClient::authenticationState() const
@@ -46,6 +46,7 @@
 #include <QtCore/qjsonobject.h>
 #include <QtCore/qurl.h>
 #include <QtNetwork/qnetworkaccessmanager.h>
+#include <QtNetwork/qnetworkreply.h>
 
 class EnginioClientPrivate;
 class QNetworkAccessManager;
@@ -54,6 +55,7 @@ class QNetworkReply;
 class QSslError;
 class EnginioReply;
 class EnginioIdentity;
+class EnginioRequestGroup;
 
 class ENGINIOCLIENT_EXPORT EnginioClient : public QObject
 {
@@ -78,6 +80,13 @@ public:
     };
     Q_ENUMS(Operation)
 
+    enum Priority {
+        InteractivePriority,
+        NormalPriority,
+        BackgroundPriority
+    };
+    Q_ENUMS(Priority)
+
     explicit EnginioClient(QObject *parent = 0);
     ~EnginioClient();
 
@@ -86,6 +95,22 @@ public:
     Q_PROPERTY(QUrl serviceUrl READ serviceUrl WRITE setServiceUrl NOTIFY serviceUrlChanged FINAL)
     Q_PROPERTY(EnginioIdentity *identity READ identity WRITE setIdentity NOTIFY identityChanged FINAL)
     Q_PROPERTY(AuthenticationState authenticationState READ authenticationState NOTIFY authenticationStateChanged FINAL)
+    Q_PROPERTY(double maxRequestsPerSecond READ maxRequestsPerSecond WRITE setMaxRequestsPerSecond NOTIFY maxRequestsPerSecondChanged FINAL)
+    Q_PROPERTY(qint64 maxBytesPerSecond READ maxBytesPerSecond WRITE setMaxBytesPerSecond NOTIFY maxBytesPerSecondChanged FINAL)
+    Q_PROPERTY(int queueDepth READ queueDepth NOTIFY queueDepthChanged FINAL)
+    Q_PROPERTY(bool saturated READ isSaturated NOTIFY saturatedChanged FINAL)
+    Q_PROPERTY(int maxAttempts READ maxAttempts WRITE setMaxAttempts NOTIFY maxAttemptsChanged FINAL)
+    Q_PROPERTY(int retryDelay READ retryDelay WRITE setRetryDelay NOTIFY retryDelayChanged FINAL)
+    Q_PROPERTY(double retryJitter READ retryJitter WRITE setRetryJitter NOTIFY retryJitterChanged FINAL)
+    Q_PROPERTY(bool hedgedReads READ hedgedReads WRITE setHedgedReads NOTIFY hedgedReadsChanged FINAL)
+    Q_PROPERTY(double maxHedgeRatio READ maxHedgeRatio WRITE setMaxHedgeRatio NOTIFY maxHedgeRatioChanged FINAL)
+    Q_PROPERTY(double circuitBreakerThreshold READ circuitBreakerThreshold WRITE setCircuitBreakerThreshold NOTIFY circuitBreakerThresholdChanged FINAL)
+    Q_PROPERTY(int circuitBreakerTimeout READ circuitBreakerTimeout WRITE setCircuitBreakerTimeout NOTIFY circuitBreakerTimeoutChanged FINAL)
+    Q_PROPERTY(int requestTimeout READ requestTimeout WRITE setRequestTimeout NOTIFY requestTimeoutChanged FINAL)
+    Q_PROPERTY(EnginioRequestGroup *requestGroup READ requestGroup WRITE setRequestGroup NOTIFY requestGroupChanged FINAL)
+    Q_PROPERTY(int networkManagerCount READ networkManagerCount WRITE setNetworkManagerCount NOTIFY networkManagerCountChanged FINAL)
+    Q_PROPERTY(bool reserveInteractiveManager READ reserveInteractiveManager WRITE setReserveInteractiveManager NOTIFY reserveInteractiveManagerChanged FINAL)
+    Q_PROPERTY(bool tlsSessionCache READ tlsSessionCache WRITE setTlsSessionCache NOTIFY tlsSessionCacheChanged FINAL)
 
     QByteArray backendId() const;
     void setBackendId(const QByteArray &backendId);
@@ -98,16 +123,61 @@ public:
     QUrl serviceUrl() const;
     void setServiceUrl(const QUrl &serviceUrl);
     QNetworkAccessManager *networkManager() const;
+    int networkManagerCount() const;
+    void setNetworkManagerCount(int count);
+    bool reserveInteractiveManager() const;
+    void setReserveInteractiveManager(bool reserve);
+    bool tlsSessionCache() const;
+    void setTlsSessionCache(bool enabled);
+    Q_INVOKABLE QJsonObject metrics() const;
 
     Q_INVOKABLE EnginioReply *customRequest(const QUrl &url, const QByteArray &httpOperation, const QJsonObject &data = QJsonObject());
-    Q_INVOKABLE EnginioReply *search(const QJsonObject &query);
-    Q_INVOKABLE EnginioReply *query(const QJsonObject &query, const Operation operation = ObjectOperation);
-    Q_INVOKABLE EnginioReply *create(const QJsonObject &object, const Operation operation = ObjectOperation);
-    Q_INVOKABLE EnginioReply *update(const QJsonObject &object, const Operation operation = ObjectOperation);
-    Q_INVOKABLE EnginioReply *remove(const QJsonObject &object, const Operation operation = ObjectOperation);
-
-    Q_INVOKABLE EnginioReply *uploadFile(const QJsonObject &associatedObject, const QUrl &file);
-    Q_INVOKABLE EnginioReply *downloadFile(const QJsonObject &object);
+    Q_INVOKABLE EnginioReply *search(const QJsonObject &query, const Priority priority = NormalPriority);
+    Q_INVOKABLE EnginioReply *query(const QJsonObject &query, const Operation operation = ObjectOperation, const Priority priority = NormalPriority);
+    Q_INVOKABLE EnginioReply *create(const QJsonObject &object, const Operation operation = ObjectOperation, const Priority priority = NormalPriority);
+    Q_INVOKABLE EnginioReply *update(const QJsonObject &object, const Operation operation = ObjectOperation, const Priority priority = NormalPriority);
+    Q_INVOKABLE EnginioReply *remove(const QJsonObject &object, const Operation operation = ObjectOperation, const Priority priority = NormalPriority);
+
+    Q_INVOKABLE EnginioReply *uploadFile(const QJsonObject &associatedObject, const QUrl &file, const Priority priority = BackgroundPriority);
+    Q_INVOKABLE EnginioReply *downloadFile(const QJsonObject &object, const Priority priority = NormalPriority);
+
+    int maxConcurrentRequests(const Priority priority) const;
+    void setMaxConcurrentRequests(const Priority priority, int count);
+    Q_INVOKABLE bool setPriority(EnginioReply *reply, const Priority priority);
+    Q_INVOKABLE bool cancelQueued(EnginioReply *reply);
+
+    double maxRequestsPerSecond() const;
+    void setMaxRequestsPerSecond(double rate);
+    qint64 maxBytesPerSecond() const;
+    void setMaxBytesPerSecond(qint64 rate);
+    int queueDepth() const;
+    bool isSaturated() const;
+
+    int maxAttempts() const;
+    void setMaxAttempts(int attempts);
+    int retryDelay() const;
+    void setRetryDelay(int msecs);
+    double retryJitter() const;
+    void setRetryJitter(double jitter);
+    QList<int> retryStatusCodes() const;
+    void setRetryStatusCodes(const QList<int> &codes);
+    QList<QNetworkReply::NetworkError> retryNetworkErrors() const;
+    void setRetryNetworkErrors(const QList<QNetworkReply::NetworkError> &errors);
+
+    bool hedgedReads() const;
+    void setHedgedReads(bool hedgedReads);
+    double maxHedgeRatio() const;
+    void setMaxHedgeRatio(double ratio);
+
+    double circuitBreakerThreshold() const;
+    void setCircuitBreakerThreshold(double threshold);
+    int circuitBreakerTimeout() const;
+    void setCircuitBreakerTimeout(int msecs);
+
+    int requestTimeout() const;
+    void setRequestTimeout(int msecs);
+    EnginioRequestGroup *requestGroup() const;
+    void setRequestGroup(EnginioRequestGroup *group);
 
 Q_SIGNALS:
     void sessionAuthenticated(EnginioReply *reply) const;
@@ -120,6 +190,22 @@ Q_SIGNALS:
     void identityChanged(const EnginioIdentity *identity);
     void finished(EnginioReply *reply);
     void error(EnginioReply *reply);
+    void maxRequestsPerSecondChanged(double rate);
+    void maxBytesPerSecondChanged(qint64 rate);
+    void queueDepthChanged(int depth);
+    void saturatedChanged(bool saturated);
+    void maxAttemptsChanged(int attempts);
+    void retryDelayChanged(int msecs);
+    void retryJitterChanged(double jitter);
+    void hedgedReadsChanged(bool hedgedReads);
+    void maxHedgeRatioChanged(double ratio);
+    void circuitBreakerThresholdChanged(double threshold);
+    void circuitBreakerTimeoutChanged(int msecs);
+    void requestTimeoutChanged(int msecs);
+    void requestGroupChanged(EnginioRequestGroup *group);
+    void networkManagerCountChanged(int count);
+    void reserveInteractiveManagerChanged(bool reserve);
+    void tlsSessionCacheChanged(bool enabled);
 
 protected:
     QScopedPointer<EnginioClientPrivate> d_ptr;
@@ -134,5 +220,7 @@ Q_DECLARE_TYPEINFO(EnginioClient::Operation, Q_PRIMITIVE_TYPE);
 Q_DECLARE_METATYPE(EnginioClient::Operation);
 Q_DECLARE_TYPEINFO(EnginioClient::AuthenticationState, Q_PRIMITIVE_TYPE);
 Q_DECLARE_METATYPE(EnginioClient::AuthenticationState);
+Q_DECLARE_TYPEINFO(EnginioClient::Priority, Q_PRIMITIVE_TYPE);
+Q_DECLARE_METATYPE(EnginioClient::Priority);
 
 #endif // ENGINIOCLIENT_H
@@ -43,6 +43,8 @@
 #include "enginioreply.h"
 #include "enginiofakereply_p.h"
 #include "enginioidentity.h"
+#include "enginionotificationchannel_p.h"
+#include "enginioobjectstore_p.h"
 #include "enginioobjectadaptor_p.h"
 
 #include <QNetworkAccessManager>
@@ -57,6 +59,10 @@
 #include <QtCore/qmimedatabase.h>
 #include <QtCore/qjsonarray.h>
 #include <QtCore/qbuffer.h>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qmath.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/quuid.h>
 
 
 struct ENGINIOCLIENT_EXPORT EnginioString
@@ -65,6 +71,7 @@ struct ENGINIOCLIENT_EXPORT EnginioString
     static const QString limit;
     static const QString offset;
     static const QString include;
+    static const QString fields;
     static const QString query;
     static const QString message;
     static const QString results;
@@ -86,6 +93,10 @@ struct ENGINIOCLIENT_EXPORT EnginioString
     static const QString url;
     static const QString access;
     static const QString sort;
+    static const QString sortBy;
+    static const QString direction;
+    static const QString asc;
+    static const QString desc;
     static const QString count;
     static const QString targetFileProperty;
     static const QString members;
@@ -124,6 +135,24 @@ static QByteArray constructErrorMessage(QByteArray msg)
     return msgBegin + msg + msgEnd;
 }
 
+// The query of a model with a pageSize is fetched page by page, the pageSize becomes the
+// limit of every page and an offset is ignored. Returns whether the query is paged.
+static bool preparePagedQuery(QJsonObject &query, const char *caller)
+{
+    if (!query.contains(EnginioString::pageSize))
+        return false;
+    const QString limitString(EnginioString::limit);
+    const QString offsetString(EnginioString::offset);
+    if (query[limitString].toDouble())
+        qWarning() << caller << "'limit' parameter can not be used together with model pagining feature, the value will be ignored";
+    if (query[offsetString].toDouble()) {
+        qWarning() << caller << "'offset' parameter can not be used together with model pagining feature, the value will be ignored";
+        query.remove(offsetString);
+    }
+    query[limitString] = query[EnginioString::pageSize];
+    return true;
+}
+
 class ENGINIOCLIENT_EXPORT EnginioClientPrivate
 {
     enum PathOptions { Default, IncludeIdInPath = 1};
@@ -248,6 +277,10 @@ class ENGINIOCLIENT_EXPORT EnginioClientPrivate
 
         void operator ()(QNetworkReply *nreply)
         {
+            ActiveRequest active;
+            const bool scheduled = d->releaseSlot(nreply, &active);
+            if (scheduled && !d->requestFinished(nreply, active))
+                return; // the other reply of a hedged read takes over
             EnginioReply *ereply = d->_replyReplyMap.take(nreply);
 
             if (!ereply)
@@ -256,6 +289,8 @@ class ENGINIOCLIENT_EXPORT EnginioClientPrivate
             EnginioClient *q = static_cast<EnginioClient*>(d->q_ptr);
 
             if (nreply->error() != QNetworkReply::NoError) {
+                if (scheduled && d->scheduleRetry(ereply, nreply, active.request))
+                    return;
                 QPair<QIODevice *, qint64> deviceState = d->_chunkedUploads.take(nreply);
                 delete deviceState.first;
                 emit q->error(ereply);
@@ -268,7 +303,7 @@ class ENGINIOCLIENT_EXPORT EnginioClientPrivate
                 QString status = ereply->data().value(EnginioString::status).toString();
                 if (status == EnginioString::empty || status == EnginioString::incomplete) {
                     Q_ASSERT(ereply->data().value(EnginioString::objectType).toString() == EnginioString::files);
-                    d->uploadChunk(ereply, deviceState.first, deviceState.second);
+                    d->uploadChunk(ereply, deviceState.first, deviceState.second, nreply->request().priority());
                     return;
                 }
                 // should never get here unless upload was successful
@@ -276,6 +311,7 @@ class ENGINIOCLIENT_EXPORT EnginioClientPrivate
                 delete deviceState.first;
             }
 
+            ereply->stopDeadline();
             ereply->dataChanged();
             ereply->emitFinished();
             q->finished(ereply);
@@ -351,6 +387,83 @@ class ENGINIOCLIENT_EXPORT EnginioClientPrivate
         }
     };
 
+    class ReplyDestroyedFunctor
+    {
+        EnginioClientPrivate *_enginio;
+        QNetworkReply *_reply;
+    public:
+        ReplyDestroyedFunctor(EnginioClientPrivate *enginio, QNetworkReply *reply)
+            : _enginio(enginio)
+            , _reply(reply)
+        {}
+
+        void operator()() const
+        {
+            // a reply deleted before it finished would hold its slot forever
+            _enginio->replyDestroyed(_reply);
+        }
+    };
+
+    class HedgeFunctor
+    {
+        EnginioClientPrivate *_enginio;
+        QNetworkReply *_reply;
+    public:
+        HedgeFunctor(EnginioClientPrivate *enginio, QNetworkReply *reply)
+            : _enginio(enginio)
+            , _reply(reply)
+        {}
+
+        void operator()() const
+        {
+            _enginio->sendHedge(_reply);
+        }
+    };
+
+    class RetryFunctor
+    {
+        EnginioClientPrivate *_enginio;
+        QTimer *_timer;
+    public:
+        RetryFunctor(EnginioClientPrivate *enginio, QTimer *timer)
+            : _enginio(enginio)
+            , _timer(timer)
+        {}
+
+        void operator()() const
+        {
+            _enginio->sendRetry(_timer);
+        }
+    };
+
+    class DispatchQueuedFunctor
+    {
+        EnginioClientPrivate *_enginio;
+    public:
+        DispatchQueuedFunctor(EnginioClientPrivate *enginio)
+            : _enginio(enginio)
+        {}
+
+        void operator()() const
+        {
+            _enginio->dispatchQueued();
+        }
+    };
+
+    class PrewarmFunctor
+    {
+        EnginioClientPrivate *_enginio;
+    public:
+        PrewarmFunctor(EnginioClientPrivate *enginio)
+            : _enginio(enginio)
+        {}
+
+        void operator()() const
+        {
+            _enginio->prewarm();
+        }
+    };
+
 public:
     enum Operation {
         // Do not forget to keep in sync with EnginioClient::Operation!
@@ -371,6 +484,208 @@ public:
 
     Q_ENUMS(Operation)
 
+    // A request as it is given to the QNetworkAccessManager. Requests which can not be
+    // sent immediately wait in the queue of their priority class, represented to the
+    // EnginioReply by the placeholder until they are dispatched.
+    struct ScheduledRequest
+    {
+        QNetworkRequest request;
+        QNetworkAccessManager::Operation operation;
+        QByteArray verb;
+        QByteArray data;
+        QIODevice *device;
+        QHttpMultiPart *multiPart;
+        qint64 size; // of the body, for the rate limiter
+        bool reportsUploadProgress;
+        bool retryable;
+        bool hedgeable;
+        int attempts;
+        QPointer<EnginioDeferredReply> placeholder;
+
+        ScheduledRequest(const QNetworkRequest &req = QNetworkRequest(),
+                         QNetworkAccessManager::Operation op = QNetworkAccessManager::GetOperation,
+                         const QByteArray &body = QByteArray())
+            : request(req)
+            , operation(op)
+            , data(body)
+            , device(0)
+            , multiPart(0)
+            , size(body.size())
+            , reportsUploadProgress(false)
+            , retryable(false)
+            , hedgeable(false)
+            , attempts(0)
+            , placeholder(0)
+        {}
+    };
+
+    // A failed request waiting for the backoff delay before it is sent again
+    struct PendingRetry
+    {
+        ScheduledRequest request;
+        QPointer<EnginioReply> reply;
+        QPair<QIODevice*, qint64> chunkState;
+    };
+
+    // Token bucket of the rate limiter. It holds at most one second worth of tokens. A request
+    // can take more tokens than there are left, the next one waits until the debt is paid off.
+    struct TokenBucket
+    {
+        double rate; // tokens per second, 0 means no limit
+        double tokens;
+        qint64 updatedAt;
+
+        TokenBucket()
+            : rate(0)
+            , tokens(0)
+            , updatedAt(0)
+        {}
+
+        void reset(double newRate, qint64 now)
+        {
+            rate = newRate;
+            tokens = qMax(rate, 1.0);
+            updatedAt = now;
+        }
+
+        void refill(qint64 now)
+        {
+            if (rate <= 0)
+                return;
+            tokens = qMin(qMax(rate, 1.0), tokens + (now - updatedAt) * rate / 1000);
+            updatedAt = now;
+        }
+
+        void take(double count)
+        {
+            if (rate > 0)
+                tokens -= count;
+        }
+
+        qint64 msecsToAvailable() const
+        {
+            if (rate <= 0 || tokens >= 1)
+                return 0;
+            return qint64((1 - tokens) * 1000 / rate) + 1;
+        }
+    };
+
+    struct ActiveRequest
+    {
+        ScheduledRequest request;
+        QMetaObject::Connection destroyedConnection;
+        qint64 sentAt;
+        QTimer *hedgeTimer;
+        QNetworkReply *hedge; // the other reply of a hedged read
+        bool probe; // sent to find out whether an open circuit can be closed
+        int networkManager;
+
+        ActiveRequest()
+            : sentAt(0)
+            , hedgeTimer(0)
+            , hedge(0)
+            , probe(false)
+            , networkManager(0)
+        {}
+    };
+
+    // Outcomes of the last requests to one endpoint. Server errors, network errors and
+    // requests slower than SlowRequestMsecs count as failures.
+    struct CircuitBreaker
+    {
+        enum State { Closed, Open, HalfOpen };
+        enum { WindowSize = 20, MinimumSamples = 10, SlowRequestMsecs = 10000 };
+        State state;
+        quint32 failures; // one bit for each outcome in the window
+        int samples;
+        int next;
+        qint64 openedAt;
+        bool probing;
+
+        CircuitBreaker()
+            : state(Closed)
+            , failures(0)
+            , samples(0)
+            , next(0)
+            , openedAt(0)
+            , probing(false)
+        {}
+
+        void record(bool failed)
+        {
+            const quint32 bit = 1u << next;
+            failures = failed ? failures | bit : failures & ~bit;
+            next = (next + 1) % WindowSize;
+            samples = qMin(samples + 1, int(WindowSize));
+        }
+
+        double errorRate() const
+        {
+            int count = 0;
+            for (quint32 bits = failures; bits; bits &= bits - 1)
+                ++count;
+            return samples ? double(count) / samples : 0;
+        }
+
+        void open(qint64 now)
+        {
+            state = Open;
+            openedAt = now;
+            probing = false;
+        }
+
+        void close()
+        {
+            *this = CircuitBreaker();
+        }
+    };
+
+    // Latency distribution in buckets growing by a factor of sqrt(2), from 1 ms to about
+    // a minute. The counts are halved regularly, so that it follows recent changes.
+    struct LatencyHistogram
+    {
+        enum { BucketCount = 32, DecayAfter = 1024 };
+        int buckets[BucketCount];
+        int count;
+
+        LatencyHistogram()
+            : count(0)
+        {
+            for (int i = 0; i < BucketCount; ++i)
+                buckets[i] = 0;
+        }
+
+        static qint64 upperBound(int bucket)
+        {
+            return qCeil(qPow(2, (bucket + 1) / 2.0));
+        }
+
+        void add(qint64 msecs)
+        {
+            const int bucket = msecs <= 1 ? 0 : qMin(int(2 * qLn(msecs) / qLn(2)), int(BucketCount) - 1);
+            ++buckets[bucket];
+            if (++count < DecayAfter)
+                return;
+            count = 0;
+            for (int i = 0; i < BucketCount; ++i)
+                count += buckets[i] /= 2;
+        }
+
+        // the upper bound of the bucket containing the percentile \a p, or 0 without any samples
+        qint64 percentile(double p) const
+        {
+            int seen = 0;
+            for (int i = 0; i < BucketCount; ++i) {
+                seen += buckets[i];
+                if (seen && seen >= p * count)
+                    return upperBound(i);
+            }
+            return 0;
+        }
+    };
+
+    enum { PriorityCount = EnginioClient::BackgroundPriority + 1 };
+
     EnginioClientPrivate(EnginioClient *client = 0);
     virtual ~EnginioClientPrivate();
     static EnginioClientPrivate* get(EnginioClient *client) { return client->d_func(); }
@@ -386,7 +701,16 @@ public:
     QVarLengthArray<QMetaObject::Connection, 4> _identityConnections;
     QUrl _serviceUrl;
     QNetworkAccessManager *_networkManager;
-    QMetaObject::Connection _networkManagerConnection;
+    // managers of the thread used by the client, the first one is _networkManager
+    QVector<QNetworkAccessManager*> _networkManagers;
+    QVector<QMetaObject::Connection> _networkManagerConnections;
+    QVector<int> _networkManagerLoad;
+    int _networkManagerCount;
+    bool _reserveInteractiveManager;
+    // connects to the service before the first request, unless a request is sent earlier
+    QTimer *_prewarmTimer;
+    bool _tlsSessionCache;
+    QByteArray _sessionTicket;
     QNetworkRequest _request;
     QMap<QNetworkReply*, EnginioReply*> _replyReplyMap;
     QMap<QNetworkReply*, QByteArray> _requestData;
@@ -394,8 +718,46 @@ public:
     // device and last position
     QMap<QNetworkReply*, QPair<QIODevice*, qint64> > _chunkedUploads;
     qint64 _uploadChunkSize;
+    // objects shown by models of the client
+    EnginioObjectStore _objectStore;
+    // channels are shared by all models interested in the objectType, with the number of them
+    QHash<QString, QPair<EnginioNotificationChannel*, int> > _notificationChannels;
     QJsonObject _identityToken;
     EnginioClient::AuthenticationState _authenticationState;
+    // request scheduler, indexed by EnginioClient::Priority
+    QList<ScheduledRequest> _queuedRequests[PriorityCount];
+    int _activeRequestCount[PriorityCount];
+    int _maxActiveRequests[PriorityCount];
+    QHash<QNetworkReply*, ActiveRequest> _activeRequests;
+    // rate limiter, applied to all requests in the order in which the scheduler sends them
+    QElapsedTimer _clock;
+    TokenBucket _requestBucket;
+    TokenBucket _byteBucket;
+    QTimer *_rateLimitTimer;
+    int _queueDepth;
+    // retry policy of idempotent requests
+    int _maxAttempts;
+    int _retryDelay;
+    double _retryJitter;
+    QList<int> _retryStatusCodes;
+    QList<QNetworkReply::NetworkError> _retryNetworkErrors;
+    QHash<QTimer*, PendingRetry> _pendingRetries;
+    int _retryCount;
+    // hedging of idempotent reads, the duplicates are limited to a part of the sent reads
+    bool _hedgedReads;
+    double _maxHedgeRatio;
+    LatencyHistogram _readLatency;
+    double _hedgeTokens;
+    int _hedgeCount;
+    int _hedgeWins;
+    // circuit breakers by endpoint, failing requests fast while the backend is degraded
+    QHash<QString, CircuitBreaker> _circuitBreakers;
+    double _circuitBreakerThreshold;
+    int _circuitBreakerTimeout;
+    int _rejectedRequests;
+    int _requestTimeout;
+    int _timedOutRequests;
+    QPointer<EnginioRequestGroup> _requestGroup;
 
     void init();
 
@@ -437,6 +799,96 @@ public:
         _replyReplyMap[nreply] = ereply;
     }
 
+    EnginioReply *createDeferredReply()
+    {
+        return new EnginioReply(this, new EnginioDeferredReply(this));
+    }
+
+    void setNetworkReply(EnginioReply *ereply, QNetworkReply *nreply)
+    {
+        ereply->setNetworkReply(nreply);
+    }
+
+    QJsonObject metrics() const;
+
+    static QNetworkRequest::Priority networkPriority(const EnginioClient::Priority priority)
+    {
+        switch (priority) {
+        case EnginioClient::InteractivePriority:
+            return QNetworkRequest::HighPriority;
+        case EnginioClient::BackgroundPriority:
+            return QNetworkRequest::LowPriority;
+        default:
+            return QNetworkRequest::NormalPriority;
+        }
+    }
+
+    static EnginioClient::Priority requestPriority(const QNetworkRequest &request)
+    {
+        switch (request.priority()) {
+        case QNetworkRequest::HighPriority:
+            return EnginioClient::InteractivePriority;
+        case QNetworkRequest::LowPriority:
+            return EnginioClient::BackgroundPriority;
+        default:
+            return EnginioClient::NormalPriority;
+        }
+    }
+
+    QNetworkRequest prepareRequest(const QUrl &url, const EnginioClient::Priority priority) const
+    {
+        QNetworkRequest req(_request);
+        req.setUrl(url);
+        req.setPriority(networkPriority(priority));
+        return req;
+    }
+
+    bool hasFreeSlot(const EnginioClient::Priority priority) const
+    {
+        const int max = _maxActiveRequests[priority];
+        return !max || _activeRequestCount[priority] < max;
+    }
+
+    QNetworkReply *schedule(ScheduledRequest request);
+    QNetworkReply *send(const ScheduledRequest &request);
+    void dispatch(const ScheduledRequest &request);
+    void dispatchQueued();
+    bool releaseSlot(QNetworkReply *nreply, ActiveRequest *active = 0);
+    void replyDestroyed(QNetworkReply *nreply);
+    bool requestFinished(QNetworkReply *nreply, const ActiveRequest &active);
+    bool findQueued(const QNetworkReply *placeholder, int *priority, int *index) const;
+    bool setPriority(EnginioReply *ereply, const EnginioClient::Priority priority);
+    bool cancelQueued(EnginioReply *ereply);
+    void setMaxActiveRequests(const EnginioClient::Priority priority, int count);
+    bool isRateLimited();
+    void updateQueueDepth();
+    void setMaxRequestsPerSecond(double rate);
+    void setMaxBytesPerSecond(qint64 rate);
+    bool isRetryable(QNetworkReply *nreply, const ScheduledRequest &request) const;
+    bool scheduleRetry(EnginioReply *ereply, QNetworkReply *nreply, ScheduledRequest request);
+    void sendRetry(QTimer *timer);
+    void setMaxAttempts(int attempts);
+    void setRetryDelay(int msecs);
+    void setRetryJitter(double jitter);
+    qint64 hedgeDelay() const;
+    void sendHedge(QNetworkReply *nreply);
+    void setHedgedReads(bool hedgedReads);
+    void setMaxHedgeRatio(double ratio);
+    static QString circuitKey(const QUrl &url);
+    CircuitBreaker::State circuitState(const QUrl &url) const;
+    bool isCircuitRejecting(const QUrl &url) const;
+    bool acquireCircuit(const QUrl &url, bool *probe);
+    void recordOutcome(QNetworkReply *nreply, const ActiveRequest &active);
+    void setCircuitBreakerThreshold(double threshold);
+    void setCircuitBreakerTimeout(int msecs);
+    QTimer *pendingRetryTimer(const EnginioReply *ereply) const;
+    bool isPending(const EnginioReply *ereply) const;
+    bool finishEarly(EnginioReply *ereply, QNetworkReply::NetworkError error, const QByteArray &message);
+    void setRequestTimeout(int msecs);
+
+    EnginioNotificationChannel *subscribe(const QString &objectType);
+    void unsubscribe(const QString &objectType);
+
     EnginioIdentity *identity() const
     {
         return _identity;
@@ -471,10 +923,9 @@ public:
         QUrl url(_serviceUrl);
         CHECK_AND_SET_PATH(url, object, AuthenticationOperation);
 
-        QNetworkRequest req(_request);
-        req.setUrl(url);
+        QNetworkRequest req = prepareRequest(url, EnginioClient::InteractivePriority);
         QByteArray data(QJsonDocument(object).toJson(QJsonDocument::Compact));
-        QNetworkReply *reply = networkManager()->post(req, data);
+        QNetworkReply *reply = schedule(ScheduledRequest(req, QNetworkAccessManager::PostOperation, data));
 
         if (gEnableEnginioDebugInfo)
             _requestData.insert(reply, data);
@@ -482,13 +933,12 @@ public:
         return reply;
     }
 
-    QNetworkReply *customRequest(const QUrl &url, const QByteArray &httpOperation, const QJsonObject &data)
+    QNetworkReply *customRequest(const QUrl &url, const QByteArray &httpOperation, const QJsonObject &data, const EnginioClient::Priority priority = EnginioClient::NormalPriority)
     {
         Q_ASSERT(!url.isEmpty());
         Q_ASSERT(!httpOperation.isEmpty());
 
-        QNetworkRequest req(_request);
-        req.setUrl(url);
+        QNetworkRequest req = prepareRequest(url, priority);
 
         if (data[EnginioString::headers].isObject()) {
             QJsonObject headers = data[EnginioString::headers].toObject();
@@ -512,25 +962,25 @@ public:
             buffer->open(QIODevice::ReadOnly);
         }
 
-        QNetworkReply *reply = networkManager()->sendCustomRequest(req, httpOperation, buffer);
+        ScheduledRequest request(req, QNetworkAccessManager::CustomOperation);
+        request.verb = httpOperation;
+        request.device = buffer;
+        request.size = payload.size();
+        QNetworkReply *reply = schedule(request);
 
         if (gEnableEnginioDebugInfo && !payload.isEmpty())
             _requestData.insert(reply, payload);
 
-        if (buffer)
-            buffer->setParent(reply);
-
         return reply;
     }
 
     template<class T>
-    QNetworkReply *update(const ObjectAdaptor<T> &object, const EnginioClient::Operation operation)
+    QNetworkReply *update(const ObjectAdaptor<T> &object, const EnginioClient::Operation operation, const EnginioClient::Priority priority = EnginioClient::NormalPriority)
     {
         QUrl url(_serviceUrl);
         CHECK_AND_SET_PATH_WITH_ID(url, object, operation);
 
-        QNetworkRequest req(_request);
-        req.setUrl(url);
+        QNetworkRequest req = prepareRequest(url, priority);
 
         // TODO FIXME we need to remove "id" and "objectType" because of an internal server error.
         // It failes at least for ACL but maybe for others too.
@@ -544,7 +994,7 @@ public:
         o.remove(EnginioString::id);
         QByteArray data = o.toJson();
 
-        QNetworkReply *reply = networkManager()->put(req, data);
+        QNetworkReply *reply = schedule(ScheduledRequest(req, QNetworkAccessManager::PutOperation, data));
 
         if (gEnableEnginioDebugInfo)
             _requestData.insert(reply, data);
@@ -553,13 +1003,12 @@ public:
     }
 
     template<class T>
-    QNetworkReply *remove(const ObjectAdaptor<T> &object, const EnginioClient::Operation operation)
+    QNetworkReply *remove(const ObjectAdaptor<T> &object, const EnginioClient::Operation operation, const EnginioClient::Priority priority = EnginioClient::NormalPriority)
     {
         QUrl url(_serviceUrl);
         CHECK_AND_SET_PATH_WITH_ID(url, object, operation);
 
-        QNetworkRequest req(_request);
-        req.setUrl(url);
+        QNetworkRequest req = prepareRequest(url, priority);
 
         // TODO FIXME we need to remove "id" and "objectType" because of an internal server error.
         // It failes at least for ACL but maybe for others too.
@@ -577,18 +1026,21 @@ public:
             QBuffer *buffer = new QBuffer();
             buffer->setData(data);
             buffer->open(QIODevice::ReadOnly);
-            QNetworkReply *reply = networkManager()->sendCustomRequest(req, QByteArrayLiteral("DELETE"), buffer);
-            buffer->setParent(reply);
+            ScheduledRequest request(req, QNetworkAccessManager::CustomOperation);
+            request.verb = QByteArrayLiteral("DELETE");
+            request.device = buffer;
+            request.size = data.size();
+            QNetworkReply *reply = schedule(request);
 
             if (gEnableEnginioDebugInfo)
                 _requestData.insert(reply, data);
 
             return reply;
         }
-        return networkManager()->deleteResource(req);
+        return schedule(ScheduledRequest(req, QNetworkAccessManager::DeleteOperation));
 #else
         QByteArray data = o.toJson();
-        QNetworkReply *reply = networkManager()->deleteResource(req, data);
+        QNetworkReply *reply = schedule(ScheduledRequest(req, QNetworkAccessManager::DeleteOperation, data));
 
         if (gEnableEnginioDebugInfo)
             _requestData.insert(reply, data);
@@ -598,17 +1050,20 @@ public:
     }
 
     template<class T>
-    QNetworkReply *create(const ObjectAdaptor<T> &object, const EnginioClient::Operation operation)
+    QNetworkReply *create(const ObjectAdaptor<T> &object, const EnginioClient::Operation operation, const EnginioClient::Priority priority = EnginioClient::NormalPriority)
     {
         QUrl url(_serviceUrl);
         CHECK_AND_SET_PATH(url, object, operation);
 
-        QNetworkRequest req(_request);
-        req.setUrl(url);
+        QNetworkRequest req = prepareRequest(url, priority);
+        // the backend creates the object only once for all attempts with the same key
+        req.setRawHeader(QByteArrayLiteral("Idempotency-Key"), QUuid::createUuid().toRfc4122().toHex());
 
         QByteArray data = object.toJson();
 
-        QNetworkReply *reply = networkManager()->post(req, data);
+        ScheduledRequest request(req, QNetworkAccessManager::PostOperation, data);
+        request.retryable = true;
+        QNetworkReply *reply = schedule(request);
 
         if (gEnableEnginioDebugInfo)
             _requestData.insert(reply, data);
@@ -617,7 +1072,7 @@ public:
     }
 
     template<class T>
-    QNetworkReply *query(const ObjectAdaptor<T> &object, const Operation operation)
+    QNetworkReply *query(const ObjectAdaptor<T> &object, const Operation operation, const EnginioClient::Priority priority = EnginioClient::NormalPriority)
     {
         QUrl url(_serviceUrl);
         CHECK_AND_SET_PATH(url, object, operation);
@@ -638,6 +1093,11 @@ public:
             urlQuery.addQueryItem(EnginioString::include,
                 QString::fromUtf8(include.toJson()));
         }
+        ValueAdaptor<T> fields = object[EnginioString::fields];
+        if (fields.isComposedType()) {
+            urlQuery.addQueryItem(EnginioString::fields,
+                QString::fromUtf8(fields.toJson()));
+        }
         ValueAdaptor<T> sort = object[EnginioString::sort];
         if (sort.isComposedType()) {
             urlQuery.addQueryItem(EnginioString::sort,
@@ -662,14 +1122,16 @@ public:
         }
         url.setQuery(urlQuery);
 
-        QNetworkRequest req(_request);
-        req.setUrl(url);
+        QNetworkRequest req = prepareRequest(url, priority);
 
-        return networkManager()->get(req);
+        ScheduledRequest request(req);
+        request.retryable = true;
+        request.hedgeable = true;
+        return schedule(request);
     }
 
     template<class T>
-    QNetworkReply *downloadFile(const ObjectAdaptor<T> &object)
+    QNetworkReply *downloadFile(const ObjectAdaptor<T> &object, const EnginioClient::Priority priority = EnginioClient::NormalPriority)
     {
         QUrl url(_serviceUrl);
         CHECK_AND_SET_PATH(url, object, FileGetDownloadUrlOperation);
@@ -680,15 +1142,17 @@ public:
             url.setQuery(query);
         }
 
-        QNetworkRequest req(_request);
-        req.setUrl(url);
+        QNetworkRequest req = prepareRequest(url, priority);
 
-        QNetworkReply *reply = networkManager()->get(req);
+        ScheduledRequest request(req);
+        request.retryable = true;
+        request.hedgeable = true;
+        QNetworkReply *reply = schedule(request);
         return reply;
     }
 
     template<class T>
-    QNetworkReply *uploadFile(const ObjectAdaptor<T> &object, const QUrl &fileUrl)
+    QNetworkReply *uploadFile(const ObjectAdaptor<T> &object, const QUrl &fileUrl, const EnginioClient::Priority priority = EnginioClient::BackgroundPriority)
     {
         if (!fileUrl.scheme().isEmpty() && !fileUrl.isLocalFile())
             qWarning() << "Enginio: Upload must be local file.";
@@ -700,17 +1164,17 @@ public:
         Q_ASSERT(file->isOpen());
         QMimeDatabase mimeDb;
         QString mimeType = mimeDb.mimeTypeForFile(path).name();
-        return upload(object, file, mimeType);
+        return upload(object, file, mimeType, priority);
     }
 
     template<class T>
-    QNetworkReply *upload(const ObjectAdaptor<T> &object, QIODevice *device, const QString &mimeType)
+    QNetworkReply *upload(const ObjectAdaptor<T> &object, QIODevice *device, const QString &mimeType, const EnginioClient::Priority priority = EnginioClient::BackgroundPriority)
     {
         QNetworkReply *reply = 0;
         if (!device->isSequential() && device->size() < _uploadChunkSize)
-            reply = uploadAsHttpMultiPart(object, device, mimeType);
+            reply = uploadAsHttpMultiPart(object, device, mimeType, priority);
         else
-            reply = uploadChunked(object, device);
+            reply = uploadChunked(object, device, priority);
 
         if (gEnableEnginioDebugInfo) {
             QByteArray data = object.toJson();
@@ -726,7 +1190,16 @@ public:
     }
 
     void assignNetworkManager();
-    static QNetworkAccessManager *prepareNetworkManagerInThread();
+    static QNetworkAccessManager *prepareNetworkManagerInThread(int index = 0);
+    int chooseNetworkManager(const EnginioClient::Priority priority) const;
+    void setNetworkManagerCount(int count);
+    void setServiceUrl(const QUrl &serviceUrl);
+    void prewarm();
+    QString sessionTicketPath() const;
+    bool usesSessionTicket(const QUrl &url) const;
+    void applySessionTicket(QNetworkRequest &request) const;
+    void loadSessionTicket();
+    void storeSessionTicket(QNetworkReply *nreply);
 
     bool isSignalConnected(const QMetaMethod &signal) const
     {
@@ -762,21 +1235,21 @@ public:
 private:
 
     template<class T>
-    QNetworkReply *uploadAsHttpMultiPart(const ObjectAdaptor<T> &object, QIODevice *device, const QString &mimeType)
+    QNetworkReply *uploadAsHttpMultiPart(const ObjectAdaptor<T> &object, QIODevice *device, const QString &mimeType, const EnginioClient::Priority priority)
     {
         QUrl serviceUrl = _serviceUrl;
         CHECK_AND_SET_PATH(serviceUrl, QJsonObject(), FileOperation);
 
-        QNetworkRequest req(_request);
+        QNetworkRequest req = prepareRequest(serviceUrl, priority);
         req.setHeader(QNetworkRequest::ContentTypeHeader, QByteArray());
-        req.setUrl(serviceUrl);
 
         QHttpMultiPart *multiPart = createHttpMultiPart(object, device, mimeType);
-        QNetworkReply *reply = networkManager()->post(req, multiPart);
-        multiPart->setParent(reply);
         device->setParent(multiPart);
-        _connections.append(QObject::connect(reply, &QNetworkReply::uploadProgress, UploadProgressFunctor(this, reply)));
-        return reply;
+        ScheduledRequest request(req, QNetworkAccessManager::PostOperation);
+        request.multiPart = multiPart;
+        request.size = device->size();
+        request.reportsUploadProgress = true;
+        return schedule(request);
     }
 
 
@@ -809,21 +1282,21 @@ private:
     }
 
     template<class T>
-    QNetworkReply *uploadChunked(const ObjectAdaptor<T> &object, QIODevice *device)
+    QNetworkReply *uploadChunked(const ObjectAdaptor<T> &object, QIODevice *device, const EnginioClient::Priority priority)
     {
         QUrl serviceUrl = _serviceUrl;
         CHECK_AND_SET_PATH(serviceUrl, QJsonObject(), FileOperation);
 
-        QNetworkRequest req(_request);
-        req.setUrl(serviceUrl);
+        QNetworkRequest req = prepareRequest(serviceUrl, priority);
 
-        QNetworkReply *reply = networkManager()->post(req, object.toJson());
+        ScheduledRequest request(req, QNetworkAccessManager::PostOperation, object.toJson());
+        request.reportsUploadProgress = true;
+        QNetworkReply *reply = schedule(request);
         _chunkedUploads.insert(reply, qMakePair(device, static_cast<qint64>(0)));
-        _connections.append(QObject::connect(reply, &QNetworkReply::uploadProgress, UploadProgressFunctor(this, reply)));
         return reply;
     }
 
-    void uploadChunk(EnginioReply *ereply, QIODevice *device, qint64 startPos)
+    void uploadChunk(EnginioReply *ereply, QIODevice *device, qint64 startPos, QNetworkRequest::Priority priority)
     {
         QUrl serviceUrl = _serviceUrl;
         {
@@ -836,6 +1309,7 @@ private:
 
         QNetworkRequest req(_request);
         req.setUrl(serviceUrl);
+        req.setPriority(priority);
         req.setHeader(QNetworkRequest::ContentTypeHeader,
                       QByteArrayLiteral("application/octet-stream"));
 
@@ -854,11 +1328,14 @@ private:
         ChunkDevice *chunkDevice = new ChunkDevice(device, startPos, _uploadChunkSize);
         chunkDevice->open(QIODevice::ReadOnly);
 
-        QNetworkReply *reply = networkManager()->put(req, chunkDevice);
-        chunkDevice->setParent(reply);
+        ScheduledRequest request(req, QNetworkAccessManager::PutOperation);
+        request.device = chunkDevice;
+        request.size = endPos - startPos;
+        request.reportsUploadProgress = true;
+        request.retryable = true;
+        QNetworkReply *reply = schedule(request);
         _chunkedUploads.insert(reply, qMakePair(device, endPos));
         ereply->setNetworkReply(reply);
-        _connections.append(QObject::connect(reply, &QNetworkReply::uploadProgress, UploadProgressFunctor(this, reply)));
     }
 };
 
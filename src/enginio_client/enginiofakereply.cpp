@@ -50,13 +50,13 @@ struct FinishedFunctor
     }
 };
 
-EnginioFakeReply::EnginioFakeReply(EnginioClientPrivate *parent, QByteArray msg)
+EnginioFakeReply::EnginioFakeReply(EnginioClientPrivate *parent, QByteArray msg, NetworkError error, int status)
     : QNetworkReply(parent->q_ptr)
     , _msg(msg)
 {
     QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
-    setError(ContentNotFoundError, QString::fromUtf8(msg));
-    setAttribute(QNetworkRequest::HttpStatusCodeAttribute, 400);
+    setError(error, QString::fromUtf8(msg));
+    setAttribute(QNetworkRequest::HttpStatusCodeAttribute, status);
     QNetworkAccessManager *qnam = parent->networkManager();
     FinishedFunctor fin = {qnam, this};
     QObject::connect(this, &EnginioFakeReply::finished, fin);
@@ -90,3 +90,45 @@ qint64 EnginioFakeReply::writeData(const char *data, qint64 maxSize)
     Q_UNUSED(maxSize);
     return -1;
 }
+
+EnginioDeferredReply::EnginioDeferredReply(EnginioClientPrivate *parent)
+    : QNetworkReply(parent->q_ptr)
+{
+    QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    QNetworkAccessManager *qnam = parent->networkManager();
+    FinishedFunctor fin = {qnam, this};
+    QObject::connect(this, &EnginioDeferredReply::finished, fin);
+}
+
+void EnginioDeferredReply::abort()
+{
+    if (isFinished())
+        return;
+    setError(OperationCanceledError, QStringLiteral("Operation canceled"));
+    setFinished(true);
+    QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+}
+
+bool EnginioDeferredReply::isSequential() const
+{
+    return true;
+}
+
+qint64 EnginioDeferredReply::size() const
+{
+    return 0;
+}
+
+qint64 EnginioDeferredReply::readData(char *dest, qint64 n)
+{
+    Q_UNUSED(dest);
+    Q_UNUSED(n);
+    return -1;
+}
+
+qint64 EnginioDeferredReply::writeData(const char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
@@ -49,7 +49,25 @@ class EnginioFakeReply : public QNetworkReply
     Q_OBJECT
     QByteArray _msg;
 public:
-    explicit EnginioFakeReply(EnginioClientPrivate *parent, QByteArray msg);
+    explicit EnginioFakeReply(EnginioClientPrivate *parent, QByteArray msg, NetworkError error = ContentNotFoundError, int status = 400);
+
+    virtual void abort() Q_DECL_OVERRIDE;
+    virtual bool isSequential() const Q_DECL_OVERRIDE;
+    virtual qint64 size() const Q_DECL_OVERRIDE;
+    virtual qint64 readData(char *dest, qint64 n) Q_DECL_OVERRIDE;
+    virtual qint64 writeData(const char *data, qint64 maxSize) Q_DECL_OVERRIDE;
+};
+
+/*
+  Placeholder for a request which was not sent yet. It allows to return an EnginioReply
+  immediately and to attach the real QNetworkReply later through EnginioReply::setNetworkReply.
+  If it is aborted before that happens it finishes with QNetworkReply::OperationCanceledError.
+*/
+class EnginioDeferredReply : public QNetworkReply
+{
+    Q_OBJECT
+public:
+    explicit EnginioDeferredReply(EnginioClientPrivate *parent);
 
     virtual void abort() Q_DECL_OVERRIDE;
     virtual bool isSequential() const Q_DECL_OVERRIDE;
@@ -41,9 +41,13 @@
 #include "enginiofakereply_p.h"
 
 #include <QtCore/qobject.h>
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qqueue.h>
 #include <QtCore/qvector.h>
 #include <QtCore/qjsonobject.h>
 #include <QtCore/qjsonarray.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qtimer.h>
 
 
 class EnginioModelPrivate {
@@ -55,11 +59,96 @@ class EnginioModelPrivate {
 
     const static int FullModelReset;
     const static int IncrementalModelUpdate;
-    mutable QMap<const EnginioReply*, QPair<int /*row*/, QJsonObject> > _dataChanged;
+    const static int ShardedModelReset;
+    mutable QHash<const EnginioReply*, QPair<int /*row*/, QJsonObject> > _dataChanged;
+    QHash<const EnginioReply*, QMetaObject::Connection> _repliesConnections;
     QSet<int> _rowsToSync;
     int _latestRequestedOffset;
     bool _canFetchMore;
 
+    // Pages are requested ahead of the highest row a view asked for and inserted in order of their offsets.
+    const static int MaxConcurrentPageRequests;
+    int _prefetchPages;
+    int _highestAccessedRow;
+    int _nextPageOffset;
+    bool _fullResetPending;
+    QSet<const EnginioReply*> _pageRequests;
+    QMap<int /*offset*/, QPair<int /*limit*/, QJsonArray> > _fetchedPages;
+    QMap<int /*offset*/, QJsonObject> _failedPages; // requested again before any new page
+    // requests for the rows read by views are sent from the event loop, not from data()
+    QTimer _accessTimer;
+    int _initialLoadShards;
+    bool _loadingShards;
+
+    // Pages of a paged query beyond maxResidentRows are dropped from memory, least recently
+    // used first. Their rows stay in the model and are fetched again by their ids when accessed.
+    const static int PageReload;
+    int _maxResidentRows;
+    QList<int> _residentPages; // most recently used first
+    QSet<QString> _reloadingIds;
+    QSet<int> _evictedRowsRead;
+
+    // In keyset mode a page starts after the sort key value of the last fetched row.
+    EnginioModel::PagingMode _pagingMode;
+    QJsonValue _keysetLastValue;
+    bool _keysetStrict;
+    QSet<QString> _keysetIds;
+
+    // Delta synchronization fetches only objects updated since the newest updatedAt in the cache
+    const static int DeltaSync;
+    const static int DeltaSyncCount;
+    const static int DeltaSyncReconciliation;
+    const EnginioReply *_syncRequest;
+    QTimer _syncTimer;
+    // Deltas and the ids for the reconciliation are fetched in pages, the backend would cut them
+    const static int DeltaSyncPageSize;
+    QString _syncWatermark;
+    int _syncSkip; // objects of the watermark's updatedAt fetched already
+    QSet<QString> _syncIds;
+    int _syncInterval;
+
+    // Changes pushed by the backend through a channel shared by all models of the client.
+    // While the channel is down the model falls back to delta synchronization.
+    const static int FallbackSyncInterval;
+    bool _realtimeUpdates;
+    EnginioNotificationChannel *_channel;
+    QString _subscribedObjectType;
+    QVector<QMetaObject::Connection> _channelConnections;
+
+    // With field projection queries download only the properties which are roles of the model,
+    // the whole object of a row is fetched on demand.
+    const static int FullObjectFetch;
+    bool _fieldProjection;
+
+    struct PendingUpdate
+    {
+        QJsonObject delta;
+        QPointer<EnginioReply> reply;
+        const EnginioReply *key;
+        bool ownReply; // the one returned to the callers was deleted
+        QMetaObject::Connection replyDestroyed;
+    };
+    QHash<QString /*id*/, PendingUpdate> _pendingUpdates;
+    QTimer _writeBehindTimer;
+    int _writeBehindInterval;
+
+    // Bulk operations are queued, at most MaxConcurrentWrites of them are sent at the same time.
+    const static int MaxConcurrentWrites;
+    struct PendingWrite
+    {
+        QPointer<EnginioReply> reply;
+        QJsonObject object;
+        bool remove;
+    };
+    QQueue<PendingWrite> _pendingWrites;
+    QSet<const EnginioReply*> _activeWrites;
+    QHash<const EnginioReply*, QMetaObject::Connection> _writeConnections;
+
+    // Rows removed by removeRows() leave the cache at once, they come back if the backend refuses it.
+    // Writes of rows which left the cache in another way are not reconciled with any row.
+    const static int BulkRemove;
+    const static int DetachedWrite;
+
     enum {
         InvalidRole = -1,
         SyncedRole = Qt::UserRole + 1,
@@ -71,8 +160,15 @@ class EnginioModelPrivate {
     };
     unsigned _rolesCounter;
     QHash<int, QString> _roles;
+    QHash<QString, int> _roleIds;
+    QHash<int, QByteArray> _roleNames;
+
+    // Declared roles are known before any data arrives, they are not discovered from the first object.
+    // A declared type converts the values of a role, roles without a type return QJsonValues.
+    QJsonObject _declaredRoles;
+    QHash<int, int> _roleTypes;
 
-    QJsonArray _data; // TODO replace by a sparse array, and add laziness
+    EnginioObjectRows _data; // rows of evicted pages keep their slots, without the objects
 
     class EnginioDestroyed
     {
@@ -85,6 +181,13 @@ class EnginioModelPrivate {
         }
         void operator ()()
         {
+            // the client is half destroyed, it is too late to send anything
+            model->clearPendingUpdates();
+            model->_pendingWrites.clear();
+            // its notification channels are already gone
+            model->_channel = 0;
+            model->_subscribedObjectType.clear();
+            model->_channelConnections.clear();
             model->setEnginio(0);
         }
     };
@@ -105,6 +208,138 @@ class EnginioModelPrivate {
         }
     };
 
+    class FlushPendingUpdates
+    {
+        EnginioModelPrivate *model;
+    public:
+        FlushPendingUpdates(EnginioModelPrivate *m)
+            : model(m)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()()
+        {
+            model->flushPendingUpdates();
+        }
+    };
+
+    class PendingReplyDestroyed
+    {
+        EnginioModelPrivate *model;
+        QString objectId;
+    public:
+        PendingReplyDestroyed(EnginioModelPrivate *m, const QString &id)
+            : model(m)
+            , objectId(id)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()()
+        {
+            model->pendingReplyDestroyed(objectId);
+        }
+    };
+
+    class WriteDestroyed
+    {
+        EnginioModelPrivate *model;
+        const EnginioReply *reply;
+    public:
+        WriteDestroyed(EnginioModelPrivate *m, const EnginioReply *r)
+            : model(m)
+            , reply(r)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()()
+        {
+            model->writeDestroyed(reply);
+        }
+    };
+
+    class RowsAccessed
+    {
+        EnginioModelPrivate *model;
+    public:
+        RowsAccessed(EnginioModelPrivate *m)
+            : model(m)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()()
+        {
+            model->rowsAccessed();
+        }
+    };
+
+    class Synchronize
+    {
+        EnginioModelPrivate *model;
+    public:
+        Synchronize(EnginioModelPrivate *m)
+            : model(m)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()()
+        {
+            model->synchronize();
+        }
+    };
+
+    class ChannelNotification
+    {
+        EnginioModelPrivate *model;
+    public:
+        ChannelNotification(EnginioModelPrivate *m)
+            : model(m)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()(const QString &event, const QJsonObject &object)
+        {
+            model->applyNotification(event, object);
+        }
+    };
+
+    class ChannelConnectedChanged
+    {
+        EnginioModelPrivate *model;
+    public:
+        ChannelConnectedChanged(EnginioModelPrivate *m)
+            : model(m)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()(bool connected)
+        {
+            model->channelConnectedChanged(connected);
+        }
+    };
+
+    class RecordChanged
+    {
+        EnginioModelPrivate *model;
+    public:
+        RecordChanged(EnginioModelPrivate *m)
+            : model(m)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()(const EnginioObjectRecord *record, const void *origin)
+        {
+            model->recordChanged(record, origin);
+        }
+    };
+
     class QueryChanged
     {
         EnginioModelPrivate *model;
@@ -129,17 +364,50 @@ public:
         , q(q_ptr)
         , _latestRequestedOffset(0)
         , _canFetchMore(false)
+        , _prefetchPages(0)
+        , _highestAccessedRow(-1)
+        , _nextPageOffset(0)
+        , _fullResetPending(false)
+        , _initialLoadShards(0)
+        , _loadingShards(false)
+        , _maxResidentRows(0)
+        , _pagingMode(EnginioModel::OffsetPaging)
+        , _keysetLastValue(QJsonValue::Undefined)
+        , _keysetStrict(false)
+        , _syncRequest(0)
+        , _syncSkip(0)
+        , _syncInterval(0)
+        , _realtimeUpdates(false)
+        , _channel(0)
+        , _fieldProjection(false)
+        , _writeBehindInterval(0)
         , _rolesCounter(SyncedRole)
     {
+        _writeBehindTimer.setSingleShot(true);
+        QObject::connect(&_writeBehindTimer, &QTimer::timeout, FlushPendingUpdates(this));
+        _accessTimer.setSingleShot(true);
+        _accessTimer.setInterval(0);
+        QObject::connect(&_accessTimer, &QTimer::timeout, RowsAccessed(this));
+        QObject::connect(&_syncTimer, &QTimer::timeout, Synchronize(this));
         QObject::connect(q, &EnginioModel::queryChanged, QueryChanged(this));
         QObject::connect(q, &EnginioModel::operationChanged, QueryChanged(this));
+        QObject::connect(q, &EnginioModel::pagingModeChanged, QueryChanged(this));
+        QObject::connect(q, &EnginioModel::fieldProjectionChanged, QueryChanged(this));
         QObject::connect(q, &EnginioModel::enginioChanged, QueryChanged(this));
     }
 
     ~EnginioModelPrivate()
     {
+        // do not lose changes which are waiting for the write-behind timer or in the bulk queue
+        flushPendingUpdates();
+        flushPendingWrites();
+        unsubscribe();
         foreach (const QMetaObject::Connection &connection, _connections)
             QObject::disconnect(connection);
+        foreach (const QMetaObject::Connection &connection, _repliesConnections)
+            QObject::disconnect(connection);
+        foreach (const QMetaObject::Connection &connection, _writeConnections)
+            QObject::disconnect(connection);
     }
 
     EnginioClient *enginio() const
@@ -150,13 +418,29 @@ public:
     void setEnginio(const EnginioClient *enginio)
     {
         if (_enginio) {
+            flushPendingUpdates();
+            flushPendingWrites();
+            unsubscribe();
             foreach(const QMetaObject::Connection &connection, _connections)
                 QObject::disconnect(connection);
             _connections.clear();
+            // replies of the previous client are not interesting anymore
+            foreach (const QMetaObject::Connection &connection, _repliesConnections)
+                QObject::disconnect(connection);
+            _repliesConnections.clear();
+            _dataChanged.clear();
+            _activeWrites.clear();
+            foreach (const QMetaObject::Connection &connection, _writeConnections)
+                QObject::disconnect(connection);
+            _writeConnections.clear();
+            _syncRequest = 0;
+            _reloadingIds.clear();
         }
         _enginio = const_cast<EnginioClient*>(enginio);
+        EnginioObjectStore *store = _enginio ? &EnginioClientPrivate::get(_enginio)->_objectStore : 0;
+        _data.setStore(store);
         if (_enginio) {
-            _connections.append(QObject::connect(_enginio, &EnginioClient::finished, FinishedRequest(this)));
+            _connections.append(QObject::connect(store, &EnginioObjectStore::recordChanged, RecordChanged(this)));
             _connections.append(QObject::connect(_enginio, &QObject::destroyed, EnginioDestroyed(this)));
             _connections.append(QObject::connect(_enginio, &EnginioClient::backendIdChanged, QueryChanged(this)));
             _connections.append(QObject::connect(_enginio, &EnginioClient::backendSecretChanged, QueryChanged(this)));
@@ -177,18 +461,18 @@ public:
         object[EnginioString::objectType] = _query[EnginioString::objectType]; // TODO think about it, it means that not all queries are valid
         EnginioReply* id = _enginio->create(object, _operation);
         const int row = _data.count();
-        if (!row) { // the first item need to update roles
+        if (!row && _declaredRoles.isEmpty()) { // the first item need to update roles
             q->beginResetModel();
             _rowsToSync.insert(row);
             _data.append(value);
             syncRoles();
-            _dataChanged.insert(id, qMakePair(row, object));
+            registerReply(id, row, object);
             q->endResetModel();
         } else {
             q->beginInsertRows(QModelIndex(), _data.count(), _data.count());
             _rowsToSync.insert(row);
             _data.append(value);
-            _dataChanged.insert(id, qMakePair(row, object));
+            registerReply(id, row, object);
             q->endInsertRows();
         }
         return id;
@@ -196,46 +480,220 @@ public:
 
     EnginioReply *remove(int row)
     {
+        if (!_data.isResident(row)) {
+            reloadPage(row);
+            return notResidentError();
+        }
         QJsonObject oldObject = _data.at(row).toObject();
+        if (_pendingUpdates.contains(oldObject[EnginioString::id].toString()))
+            flushPendingUpdates(); // keep the order of operations on the object
         EnginioReply* id = _enginio->remove(oldObject, _operation);
-        _dataChanged.insert(id, qMakePair(row, oldObject));
+        registerReply(id, row, oldObject);
         QVector<int> roles(1);
         roles.append(SyncedRole);
         emit q->dataChanged(q->index(row), q->index(row) , roles);
         return id;
     }
 
+    QList<EnginioReply*> appendRows(const QJsonArray &values)
+    {
+        QList<EnginioReply*> replies;
+        if (values.isEmpty())
+            return replies;
+
+        EnginioClientPrivate *client = EnginioClientPrivate::get(_enginio);
+        const int firstRow = _data.count();
+        const int lastRow = firstRow + values.count() - 1;
+        const bool updateRoles = !firstRow && _declaredRoles.isEmpty(); // the first item need to update roles
+        if (updateRoles)
+            q->beginResetModel();
+        else
+            q->beginInsertRows(QModelIndex(), firstRow, lastRow);
+
+        replies.reserve(values.count());
+        for (int row = firstRow; row <= lastRow; ++row) {
+            const QJsonValue value = values.at(row - firstRow);
+            QJsonObject object(value.toObject());
+            object[EnginioString::objectType] = _query[EnginioString::objectType];
+
+            PendingWrite write;
+            write.reply = client->createDeferredReply();
+            write.object = object;
+            write.remove = false;
+
+            _rowsToSync.insert(row);
+            _data.append(value);
+            registerWrite(write.reply, row, object);
+            _pendingWrites.enqueue(write);
+            replies.append(write.reply);
+        }
+
+        if (updateRoles) {
+            syncRoles();
+            q->endResetModel();
+        } else {
+            q->endInsertRows();
+        }
+
+        dispatchPendingWrites();
+        return replies;
+    }
+
+    QList<EnginioReply*> removeRows(int row, int count)
+    {
+        QList<EnginioReply*> replies;
+        EnginioClientPrivate *client = EnginioClientPrivate::get(_enginio);
+        const int lastRow = row + count - 1;
+
+        for (int i = row; i <= lastRow; ++i) {
+            if (!_data.isResident(i)) {
+                reloadPage(i); // the objects are needed for the requests
+                return replies;
+            }
+        }
+        for (int i = row; i <= lastRow; ++i) {
+            if (_pendingUpdates.contains(_data.value(i, EnginioString::id).toString())) {
+                flushPendingUpdates(); // keep the order of operations on the objects
+                break;
+            }
+        }
+
+        replies.reserve(count);
+        for (int i = row; i <= lastRow; ++i) {
+            QJsonObject oldObject = _data.at(i).toObject();
+
+            PendingWrite write;
+            write.reply = client->createDeferredReply();
+            write.object = oldObject;
+            write.remove = true;
+
+            registerWrite(write.reply, BulkRemove, oldObject);
+            _pendingWrites.enqueue(write);
+            replies.append(write.reply);
+        }
+        removeRowsFromCache(row, lastRow);
+
+        dispatchPendingWrites();
+        return replies;
+    }
+
+    void registerWrite(EnginioReply *reply, int row, const QJsonObject &object)
+    {
+        registerReply(reply, row, object);
+        _writeConnections.insert(reply, QObject::connect(reply, &QObject::destroyed, WriteDestroyed(this, reply)));
+    }
+
+    void dispatchPendingWrites(int maxConcurrentWrites = MaxConcurrentWrites)
+    {
+        EnginioClientPrivate *client = EnginioClientPrivate::get(_enginio);
+        while (_activeWrites.count() < maxConcurrentWrites && !_pendingWrites.isEmpty()) {
+            const PendingWrite write = _pendingWrites.dequeue();
+            if (!write.reply)
+                continue; // deleted by the user before it was sent, it is forgotten already
+            QNetworkReply *nreply = write.remove ? client->remove<QJsonObject>(write.object, _operation)
+                                                 : client->create<QJsonObject>(write.object, _operation);
+            client->setNetworkReply(write.reply, nreply);
+            _activeWrites.insert(write.reply);
+        }
+    }
+
+    void flushPendingWrites()
+    {
+        if (_enginio)
+            dispatchPendingWrites(_activeWrites.count() + _pendingWrites.count());
+    }
+
+    void writeDestroyed(const EnginioReply *reply)
+    {
+        // Nobody waits for the result anymore, a request which was sent is aborted with the reply.
+        // Whether the backend applied it is not known, the next synchronization tells.
+        _writeConnections.remove(reply);
+        QObject::disconnect(_repliesConnections.take(reply));
+        const int row = _dataChanged.take(reply).first;
+        if (row >= 0) {
+            _rowsToSync.remove(row);
+            QVector<int> roles(1, SyncedRole);
+            emit q->dataChanged(q->index(row), q->index(row), roles);
+        }
+        if (_activeWrites.remove(reply))
+            dispatchPendingWrites();
+    }
+
+    void restoreRow(const QJsonObject &object)
+    {
+        // the backend did not remove the object, it comes back at the end of the model
+        q->beginInsertRows(QModelIndex(), _data.count(), _data.count());
+        _data.append(object);
+        q->endInsertRows();
+    }
+
+    void detachPendingWrites()
+    {
+        // the rows are replaced by the data of the backend, results of writes do not belong to any of them
+        for (QHash<const EnginioReply*, QPair<int, QJsonObject> >::iterator i = _dataChanged.begin(); i != _dataChanged.end(); ++i) {
+            if (i->first >= 0 || i->first == BulkRemove)
+                i->first = DetachedWrite;
+        }
+    }
+
+    void removeRowsFromCache(QList<int> rows)
+    {
+        // Rows are removed from the bottom, so indexes of the remaining ones stay valid.
+        // A contiguous range of rows is removed with a single signal.
+        qSort(rows.begin(), rows.end(), qGreater<int>());
+        int i = 0;
+        while (i < rows.count()) {
+            const int last = rows.at(i);
+            int first = last;
+            while (++i < rows.count() && rows.at(i) == first - 1)
+                --first;
+            removeRowsFromCache(first, last);
+        }
+    }
+
+    void removeRowsFromCache(int first, int last)
+    {
+        const int count = last - first + 1;
+        q->beginRemoveRows(QModelIndex(), first, last);
+        _data.remove(first, count);
+        QSet<int> rowsToSync;
+        foreach (int row, _rowsToSync) {
+            if (row < first)
+                rowsToSync.insert(row);
+            else if (row > last)
+                rowsToSync.insert(row - count);
+        }
+        _rowsToSync.swap(rowsToSync);
+        // writes on their way to the backend know their rows by index
+        for (QHash<const EnginioReply*, QPair<int, QJsonObject> >::iterator i = _dataChanged.begin(); i != _dataChanged.end(); ++i) {
+            if (i->first > last)
+                i->first -= count;
+            else if (i->first >= first)
+                i->first = DetachedWrite;
+        }
+        q->endRemoveRows();
+    }
+
     EnginioReply *setValue(int row, const QString &role, const QVariant &value)
     {
-        int key = _roles.key(role, InvalidRole);
+        int key = _roleIds.value(role, InvalidRole);
         return setData(row, value, key);
     }
 
     void setQuery(const QJsonObject &query)
     {
         _query = query;
-
-        if (_query.contains(EnginioString::pageSize)) {
-            const int pageSize = _query[EnginioString::pageSize].toDouble();
-            const QString limitString(EnginioString::limit);
-            const QString offsetString(EnginioString::offset);
-            const unsigned limit = _query[limitString].toDouble();
-            const unsigned offset = _query[offsetString].toDouble();
-            if (limit)
-                qWarning() << "EnginioModel::setQuery()" << "'limit' parameter can not be used together with model pagining feature, the value will be ignored";
-
-            if (offset) {
-                qWarning() << "EnginioModel::setQuery()" << "'offset' parameter can not be used together with model pagining feature, the value will be ignored";
-                _query.remove(offsetString);
-            }
-            _query[limitString] = pageSize;
-            _canFetchMore = true;
-        } else {
-            _canFetchMore = false;
-        }
+        _canFetchMore = preparePagedQuery(_query, "EnginioModel::setQuery()");
+        updatePartial();
         emit q->queryChanged(query);
     }
 
+    void updatePartial()
+    {
+        // projected objects are merged into the records other models share
+        _data.setPartial(_fieldProjection || _query.contains(EnginioString::fields));
+    }
+
     EnginioClient::Operation operation() const
     {
         return _operation;
@@ -250,20 +708,140 @@ public:
 
     void execute()
     {
+        updateSubscription();
         if (!_enginio || _enginio->backendId().isEmpty() || _enginio->backendSecret().isEmpty())
             return;
         if (!_query.isEmpty()) {
-            const EnginioReply *id = _enginio->query(_query, _operation);
-            if (_canFetchMore)
-                _latestRequestedOffset = _query[EnginioString::limit].toDouble();
+            _pageRequests.clear(); // pages of the previous query are not interesting anymore
+            _fetchedPages.clear();
+            _failedPages.clear();
+            _loadingShards = false;
+            _reloadingIds.clear();
+            _evictedRowsRead.clear();
+            _highestAccessedRow = -1;
+            _fullResetPending = true;
+            _keysetLastValue = QJsonValue(QJsonValue::Undefined);
+            _keysetStrict = false;
+            _keysetIds.clear();
+            _syncRequest = 0; // a running synchronization would patch the old data
+            if (_initialLoadShards > 1 && !_canFetchMore)
+                requestCount();
+            else
+                requestFullReset();
+        }
+    }
+
+    void requestFullReset()
+    {
+        const bool keyset = _canFetchMore && _pagingMode == EnginioModel::KeysetPaging;
+        const EnginioReply *id = _enginio->query(projected(keyset ? keysetQuery() : _query), _operation);
+        if (_canFetchMore)
+            _nextPageOffset = _latestRequestedOffset = _query[EnginioString::limit].toDouble();
+        QObject::connect(id, &EnginioReply::finished, id, &EnginioReply::deleteLater);
+        registerReply(id, FullModelReset, QJsonObject());
+    }
+
+    void requestCount()
+    {
+        // the size of the collection is needed to split the initial load into shards
+        QJsonObject query(_query);
+        query[EnginioString::count] = true;
+        query[EnginioString::limit] = 1;
+        const EnginioReply *id = _enginio->query(query, _operation);
+        QObject::connect(id, &EnginioReply::finished, id, &EnginioReply::deleteLater);
+        registerReply(id, ShardedModelReset, QJsonObject());
+    }
+
+    void requestShards(int count)
+    {
+        const int limit = _query[EnginioString::limit].toDouble();
+        const int total = limit > 0 ? qMin(count, limit) : count;
+        const int firstOffset = _query[EnginioString::offset].toDouble();
+        const int shardSize = (total + _initialLoadShards - 1) / _initialLoadShards;
+
+        q->beginResetModel();
+        _rowsToSync.clear();
+        detachPendingWrites();
+        _data = QJsonArray();
+        q->endResetModel();
+
+        // shards of an unsorted query could overlap, the order has to be stable
+        QJsonObject query(_query);
+        ensureSorted(query);
+
+        _nextPageOffset = firstOffset;
+        _loadingShards = true;
+        for (int i = 0; i < total; i += shardSize) {
+            query[EnginioString::offset] = firstOffset + i;
+            query[EnginioString::limit] = qMin(shardSize, total - i);
+            EnginioReply *id = _enginio->query(projected(query), _operation);
             QObject::connect(id, &EnginioReply::finished, id, &EnginioReply::deleteLater);
-            _dataChanged.insert(id, qMakePair(FullModelReset, QJsonObject()));
+            registerReply(id, IncrementalModelUpdate, query);
+            _pageRequests.insert(id);
+        }
+    }
+
+    void shardFailed()
+    {
+        // the rows of the shard would be missing, the whole query is fetched with a single one instead
+        _pageRequests.clear();
+        _fetchedPages.clear();
+        _loadingShards = false;
+        _fullResetPending = true;
+        requestFullReset();
+    }
+
+    QJsonObject projected(const QJsonObject &query) const
+    {
+        // an explicit list of fields in the query wins, roles are known after the first fetch
+        if (!_fieldProjection || query.contains(EnginioString::fields) || _roles.isEmpty())
+            return query;
+        QJsonArray fields;
+        for (QHash<int, QString>::const_iterator i = _roles.constBegin(); i != _roles.constEnd(); ++i) {
+            if (i.key() != SyncedRole)
+                fields.append(i.value());
         }
+        QJsonObject result(query);
+        result[EnginioString::fields] = fields;
+        return result;
+    }
+
+    static void ensureSorted(QJsonObject &query)
+    {
+        if (query.contains(EnginioString::sort))
+            return;
+        QJsonArray sort;
+        sort.append(ascending(EnginioString::createdAt));
+        query[EnginioString::sort] = sort;
+    }
+
+    int initialLoadShards() const
+    {
+        return _initialLoadShards;
+    }
+
+    void setInitialLoadShards(int shards)
+    {
+        _initialLoadShards = qMax(0, shards);
+        emit q->initialLoadShardsChanged(_initialLoadShards);
+    }
+
+    void registerReply(const EnginioReply *reply, int row, const QJsonObject &object)
+    {
+        // The reply notifies only the model which started it, so the cost of a finished
+        // request doesn't depend on how many models are sharing the same client.
+        _dataChanged.insert(reply, qMakePair(row, object));
+        _repliesConnections.insert(reply, QObject::connect(reply, &EnginioReply::finished, FinishedRequest(this)));
     }
 
     void finishedRequest(const EnginioReply *response)
     {
-        // We get all finished requests, check if we started this one
+        QObject::disconnect(_repliesConnections.take(response));
+        QObject::disconnect(_writeConnections.take(response));
+        if (_activeWrites.remove(response))
+            dispatchPendingWrites();
+        if (!_pendingUpdates.isEmpty())
+            dropPendingUpdate(response);
         if (!_dataChanged.contains(response))
             return;
 
@@ -274,30 +852,61 @@ public:
 
         QPair<int, QJsonObject> requestInfo = _dataChanged.take(response);
         int row = requestInfo.first;
-        if (row == FullModelReset) {
+        if (row == DetachedWrite) {
+            return;
+        } else if (row == BulkRemove) {
+            if (response->networkError() != QNetworkReply::NoError)
+                restoreRow(requestInfo.second);
+        } else if (row == FullModelReset) {
+            _fullResetPending = false;
             q->beginResetModel();
             _rowsToSync.clear();
-            _data = response->data()[EnginioString::results].toArray();
+            detachPendingWrites();
+            const QJsonArray results = response->data()[EnginioString::results].toArray();
+            _data = results;
             syncRoles();
             _canFetchMore = _canFetchMore && _data.count() && (_query[EnginioString::limit].toDouble() <= _data.count());
+            if (_canFetchMore && _pagingMode == EnginioModel::KeysetPaging)
+                mergeKeysetPage(results);
+            _residentPages.clear();
+            markPagesResident(0, _data.count() - 1);
             q->endResetModel();
+        } else if (row == ShardedModelReset) {
+            _fullResetPending = false;
+            if (response->networkError() != QNetworkReply::NoError) {
+                requestFullReset(); // fall back to a single query
+                return;
+            }
+            requestShards(response->data()[EnginioString::count].toDouble());
+        } else if (row == PageReload) {
+            finishedPageReload(response, requestInfo.second);
+        } else if (row == FullObjectFetch) {
+            finishedFullObjectFetch(response, requestInfo.second);
+        } else if (row == DeltaSync || row == DeltaSyncCount || row == DeltaSyncReconciliation) {
+            finishedSync(response, row);
         } else if (row == IncrementalModelUpdate) {
-            Q_ASSERT(_canFetchMore);
+            if (!_pageRequests.remove(response))
+                return; // the query was changed in the meantime
             QJsonArray data(response->data()[EnginioString::results].toArray());
             QJsonObject query(requestInfo.second);
             int offset = query[EnginioString::offset].toDouble();
             int limit = query[EnginioString::limit].toDouble();
-            int dataCount = data.count();
-
-            int startingOffset = qMax(offset, _data.count());
 
-            q->beginInsertRows(QModelIndex(), startingOffset, startingOffset + dataCount -1);
-            for (int i = 0; i < dataCount; ++i) {
-                _data.append(data[i]);
+            if (response->networkError() != QNetworkReply::NoError && _loadingShards) {
+                shardFailed();
+                return;
+            }
+            if (response->networkError() != QNetworkReply::NoError) {
+                // the pages after it are not inserted until it is fetched by the next fetchMore() or prefetch
+                _failedPages.insert(offset, query);
+                return;
             }
 
-            _canFetchMore = limit <= dataCount;
-            q->endInsertRows();
+            if (data.count() < limit)
+                _canFetchMore = false; // the end of the collection, pages requested after it are empty
+            _fetchedPages.insert(offset, qMakePair(limit, data));
+            insertFetchedPages();
+            prefetch();
         } else {
             _rowsToSync.remove(row);
             // TODO update, insert and remove
@@ -313,12 +922,19 @@ public:
             }
 
             if (newValue.isEmpty()) {
-                q->beginRemoveRows(QModelIndex(), row, row);
-                _data.removeAt(row);
-                q->endRemoveRows();
+                removeRowsFromCache(row, row);
             } else {
+                if (!oldValue.contains(EnginioString::id)) {
+                    // the created object may have been pushed or synchronized into the cache already
+                    const int duplicate = _data.rowOfId(newValue[EnginioString::id].toString());
+                    if (duplicate != -1 && duplicate != row) {
+                        removeRowsFromCache(duplicate, duplicate);
+                        if (duplicate < row)
+                            --row;
+                    }
+                }
                 _data.replace(row, newValue);
-                if (_data.count() == 1) {
+                if (_data.count() == 1 && _declaredRoles.isEmpty()) {
                     q->beginResetModel();
                     syncRoles();
                     q->endResetModel();
@@ -329,67 +945,571 @@ public:
         }
     }
 
-    EnginioReply *setData(const int row, const QVariant &value, int role)
+    int syncInterval() const
     {
-        if (role > SyncedRole) {
-            _rowsToSync.insert(row);
-            const QString roleName(_roles.value(role));
-            QJsonObject oldObject = _data.at(row).toObject();
-            QJsonObject deltaObject;
-            QJsonObject newObject = oldObject;
-            deltaObject[roleName] = newObject[roleName] = QJsonValue::fromVariant(value);
-            deltaObject[EnginioString::id] = newObject[EnginioString::id];
-            deltaObject[EnginioString::objectType] = newObject[EnginioString::objectType];
-            EnginioReply *id = _enginio->update(deltaObject, _operation);
-            _dataChanged.insert(id, qMakePair(row, oldObject));
-            _data.replace(row, newObject);
-            emit q->dataChanged(q->index(row), q->index(row));
-            return id;
-        }
-        EnginioClientPrivate *client = EnginioClientPrivate::get(_enginio);
-        QNetworkReply *nreply = new EnginioFakeReply(client, constructErrorMessage(QByteArrayLiteral("EnginioModel: Trying to update an object with unknown role")));
-        EnginioReply *ereply = new EnginioReply(client, nreply);
-        return ereply;
+        return _syncInterval;
     }
 
-    void syncRoles()
+    void setSyncInterval(int interval)
     {
-        QJsonObject firstObject(_data.first().toObject()); // TODO it expects certain data structure in all objects, add way to specify roles
+        _syncInterval = interval;
+        updateSyncTimer();
+        emit q->syncIntervalChanged(interval);
+    }
 
-        if (!_roles.count()) {
-            _roles.reserve(firstObject.count());
-            _roles[SyncedRole] = EnginioString::_synced; // TODO Use a proper name, can we make it an attached property in qml? Does it make sense to try?
-            _roles[CreatedAtRole] = EnginioString::createdAt;
-            _roles[UpdatedAtRole] = EnginioString::updatedAt;
-            _roles[IdRole] = EnginioString::id;
-            _roles[ObjectTypeRole] = EnginioString::objectType;
-            _rolesCounter = LastRole;
-        }
+    void updateSyncTimer()
+    {
+        int interval = _syncInterval;
+        if (interval <= 0 && _channel && !_channel->isConnected())
+            interval = FallbackSyncInterval;
+        if (interval <= 0)
+            _syncTimer.stop();
+        else if (!_syncTimer.isActive() || _syncTimer.interval() != interval)
+            _syncTimer.start(interval);
+    }
 
-        // estimate additional dynamic roles:
-        QSet<QString> definedRoles = _roles.values().toSet();
+    bool realtimeUpdates() const
+    {
+        return _realtimeUpdates;
+    }
+
+    void setRealtimeUpdates(bool enabled)
+    {
+        _realtimeUpdates = enabled;
+        updateSubscription();
+        emit q->realtimeUpdatesChanged(enabled);
+    }
+
+    void updateSubscription()
+    {
+        QString objectType;
+        if (_realtimeUpdates && _enginio && _operation == EnginioClient::ObjectOperation)
+            objectType = _query[EnginioString::objectType].toString();
+        if (objectType == _subscribedObjectType)
+            return;
+
+        unsubscribe();
+        if (objectType.isEmpty())
+            return;
+        _subscribedObjectType = objectType;
+        _channel = EnginioClientPrivate::get(_enginio)->subscribe(objectType);
+        _channelConnections.append(QObject::connect(_channel, &EnginioNotificationChannel::notification, ChannelNotification(this)));
+        _channelConnections.append(QObject::connect(_channel, &EnginioNotificationChannel::connectedChanged, ChannelConnectedChanged(this)));
+        updateSyncTimer();
+    }
+
+    void unsubscribe()
+    {
+        if (!_channel)
+            return;
+        foreach (const QMetaObject::Connection &connection, _channelConnections)
+            QObject::disconnect(connection);
+        _channelConnections.clear();
+        EnginioClientPrivate::get(_enginio)->unsubscribe(_subscribedObjectType);
+        _channel = 0;
+        _subscribedObjectType.clear();
+        updateSyncTimer();
+    }
+
+    void channelConnectedChanged(bool connected)
+    {
+        updateSyncTimer();
+        if (connected)
+            synchronize(); // changes made while the channel was down were not pushed
+    }
+
+    void recordChanged(const EnginioObjectRecord *record, const void *origin)
+    {
+        // another model changed an object which may be shown by this one too
+        if (origin == &_data)
+            return;
+        // only objects with an id are shared
+        const int row = _data.rowOfId(record->value(EnginioString::id).toString());
+        if (row != -1 && _data.record(row) == record)
+            emit q->dataChanged(q->index(row), q->index(row));
+    }
+
+    void applyNotification(const QString &event, const QJsonObject &object)
+    {
+        if (_fullResetPending)
+            return; // the whole query is on its way
+        const QString objectId = object[EnginioString::id].toString();
+        if (objectId.isEmpty())
+            return;
+
+        // only the backend knows if an object matches a filter, it is asked by a delta synchronization
+        const bool filtered = !_query[EnginioString::query].toObject().isEmpty();
+        const int row = _data.rowOfId(objectId);
+        if (event == QStringLiteral("delete")) {
+            if (row != -1 && !_rowsToSync.contains(row))
+                removeRowsFromCache(row, row);
+        } else if (row != -1) {
+            if (!_rowsToSync.contains(row) && _data.at(row).toObject() != object) {
+                _data.replace(row, object);
+                emit q->dataChanged(q->index(row), q->index(row));
+            }
+            if (filtered)
+                synchronize(); // the object may not match anymore
+        } else if (filtered || _data.isEmpty()) {
+            synchronize(); // an empty model needs to discover its roles anyway
+        } else if (!_canFetchMore && !_data.hasEvictedRows()) {
+            // objects beyond the fetched pages come with the next page
+            q->beginInsertRows(QModelIndex(), _data.count(), _data.count());
+            _data.append(object);
+            q->endInsertRows();
+        }
+    }
+
+    void synchronize()
+    {
+        if (!_enginio || _enginio->backendId().isEmpty() || _enginio->backendSecret().isEmpty() || _query.isEmpty())
+            return;
+        if (_fullResetPending || _syncRequest)
+            return; // the data is being fetched already
+        if (_data.isEmpty()) {
+            execute();
+            return;
+        }
+
+        // timestamps are ISO 8601 strings, they can be compared as strings
+        QString watermark;
+        for (int row = 0; row < _data.count(); ++row) {
+            const QString updatedAt = _data.value(row, EnginioString::updatedAt).toString();
+            if (updatedAt > watermark)
+                watermark = updatedAt;
+        }
+
+        _syncWatermark = watermark;
+        _syncSkip = 0;
+        requestDeltaPage();
+    }
+
+    void requestDeltaPage()
+    {
+        // Objects updated within the same millisecond as the newest one may have been missed,
+        // so the newest ones are fetched again, patching them is a no-op.
+        QJsonObject query(syncQuery());
+        if (!_syncWatermark.isEmpty()) {
+            QJsonObject filter = query[EnginioString::query].toObject();
+            QJsonObject condition = filter[EnginioString::updatedAt].toObject();
+            condition[QStringLiteral("$gte")] = _syncWatermark;
+            filter[EnginioString::updatedAt] = condition;
+            query[EnginioString::query] = filter;
+        }
+        // the id orders objects updated at the same time, so the pages are stable
+        QJsonArray sort;
+        sort.append(ascending(EnginioString::updatedAt));
+        sort.append(ascending(EnginioString::id));
+        query[EnginioString::sort] = sort;
+        query[EnginioString::limit] = DeltaSyncPageSize;
+        if (_syncSkip)
+            query[EnginioString::offset] = _syncSkip;
+        requestSyncStep(projected(query), DeltaSync);
+    }
+
+    void requestReconciliationPage(const QString &lastId)
+    {
+        // only the ids are needed to find removed objects, a page starts after the last id of the previous one
+        QJsonObject query(syncQuery());
+        QJsonArray fields;
+        fields.append(EnginioString::id);
+        query[EnginioString::fields] = fields;
+        QJsonArray sort;
+        sort.append(ascending(EnginioString::id));
+        query[EnginioString::sort] = sort;
+        if (!lastId.isEmpty()) {
+            QJsonObject filter = query[EnginioString::query].toObject();
+            QJsonObject condition = filter[EnginioString::id].toObject();
+            condition[QStringLiteral("$gt")] = lastId;
+            filter[EnginioString::id] = condition;
+            query[EnginioString::query] = filter;
+        }
+        query[EnginioString::limit] = DeltaSyncPageSize;
+        requestSyncStep(query, DeltaSyncReconciliation);
+    }
+
+    static QJsonObject ascending(const QString &key)
+    {
+        QJsonObject sortBy;
+        sortBy[EnginioString::sortBy] = key;
+        sortBy[EnginioString::direction] = EnginioString::asc;
+        return sortBy;
+    }
+
+    QJsonObject syncQuery() const
+    {
+        QJsonObject query(_query);
+        query.remove(EnginioString::pageSize);
+        query.remove(EnginioString::limit);
+        query.remove(EnginioString::offset);
+        return query;
+    }
+
+    void requestSyncStep(const QJsonObject &query, int step)
+    {
+        EnginioReply *id = _enginio->query(query, _operation, EnginioClient::BackgroundPriority);
+        QObject::connect(id, &EnginioReply::finished, id, &EnginioReply::deleteLater);
+        registerReply(id, step, QJsonObject());
+        _syncRequest = id;
+    }
+
+    void finishedSync(const EnginioReply *response, int step)
+    {
+        if (response != _syncRequest)
+            return; // the query was changed in the meantime
+        _syncRequest = 0;
+        if (response->networkError() != QNetworkReply::NoError)
+            return; // the next synchronization will try again
+
+        if (step == DeltaSync) {
+            const QJsonArray results = response->data()[EnginioString::results].toArray();
+            applyDelta(results);
+            if (results.count() >= DeltaSyncPageSize) {
+                // the next page starts at the updatedAt of the last object, the objects fetched with it are skipped
+                const QString updatedAt = results.last().toObject()[EnginioString::updatedAt].toString();
+                int fetched = 0;
+                for (int i = results.count() - 1; i >= 0 && results.at(i).toObject()[EnginioString::updatedAt].toString() == updatedAt; --i)
+                    ++fetched;
+                _syncSkip = updatedAt == _syncWatermark ? _syncSkip + fetched : fetched;
+                _syncWatermark = updatedAt;
+                requestDeltaPage();
+                return;
+            }
+            if (_canFetchMore)
+                return; // removed objects are detected only if the whole collection is in the cache
+
+            // Patching can not see removed objects, if the backend has less of them than
+            // the cache, the ids of all of them are fetched to find out which ones.
+            QJsonObject query(syncQuery());
+            query[EnginioString::count] = true;
+            query[EnginioString::limit] = 1;
+            requestSyncStep(query, DeltaSyncCount);
+        } else if (step == DeltaSyncCount) {
+            int cachedObjects = 0;
+            for (int row = 0; row < _data.count(); ++row) {
+                if (!_data.value(row, EnginioString::id).toString().isEmpty())
+                    ++cachedObjects;
+            }
+            if (response->data()[EnginioString::count].toDouble() < cachedObjects) {
+                _syncIds.clear();
+                requestReconciliationPage(QString());
+            }
+        } else {
+            const QJsonArray results = response->data()[EnginioString::results].toArray();
+            for (int i = 0; i < results.count(); ++i)
+                _syncIds.insert(results.at(i).toObject()[EnginioString::id].toString());
+            if (results.count() >= DeltaSyncPageSize) {
+                requestReconciliationPage(results.last().toObject()[EnginioString::id].toString());
+                return;
+            }
+            reconcile(_syncIds);
+            _syncIds.clear();
+        }
+    }
+
+    void applyDelta(const QJsonArray &objects)
+    {
+        if (objects.isEmpty())
+            return;
+
+        QJsonArray created;
+        for (int i = 0; i < objects.count(); ++i) {
+            const QJsonObject object = objects.at(i).toObject();
+            const int row = _data.rowOfId(object[EnginioString::id].toString());
+            if (row == -1) {
+                // objects beyond the fetched pages come with the next page,
+                // an object which is not found may be in an evicted row too
+                if (!_canFetchMore && !_data.hasEvictedRows())
+                    created.append(object);
+                continue;
+            }
+            if (_rowsToSync.contains(row) || _data.at(row).toObject() == object)
+                continue; // a local change is on its way to the backend, or nothing changed
+            _data.refresh(row, object);
+            emit q->dataChanged(q->index(row), q->index(row));
+        }
+
+        if (created.isEmpty())
+            return;
+        const int startingRow = _data.count();
+        q->beginInsertRows(QModelIndex(), startingRow, startingRow + created.count() - 1);
+        for (int i = 0; i < created.count(); ++i)
+            _data.append(created.at(i));
+        q->endInsertRows();
+    }
+
+    void reconcile(const QSet<QString> &ids)
+    {
+        QList<int> removedRows;
+        for (int row = 0; row < _data.count(); ++row) {
+            const QString objectId = _data.value(row, EnginioString::id).toString();
+            if (!objectId.isEmpty() && !ids.contains(objectId) && !_rowsToSync.contains(row))
+                removedRows.append(row);
+        }
+        removeRowsFromCache(removedRows);
+    }
+
+    EnginioReply *notResidentError()
+    {
+        EnginioClientPrivate *client = EnginioClientPrivate::get(_enginio);
+        QNetworkReply *nreply = new EnginioFakeReply(client, constructErrorMessage(QByteArrayLiteral("EnginioModel: The row is not in memory, it is being fetched again")));
+        return new EnginioReply(client, nreply);
+    }
+
+    EnginioReply *setData(const int row, const QVariant &value, int role)
+    {
+        if (!_data.isResident(row)) {
+            reloadPage(row);
+            return notResidentError();
+        }
+        if (role > SyncedRole) {
+            _rowsToSync.insert(row);
+            const QString roleName(_roles.value(role));
+            QJsonObject oldObject = _data.at(row).toObject();
+            QJsonObject deltaObject;
+            QJsonObject newObject = oldObject;
+            deltaObject[roleName] = newObject[roleName] = QJsonValue::fromVariant(value);
+            deltaObject[EnginioString::id] = newObject[EnginioString::id];
+            deltaObject[EnginioString::objectType] = newObject[EnginioString::objectType];
+            EnginioReply *id;
+            if (_writeBehindInterval > 0 && !deltaObject[EnginioString::id].toString().isEmpty()) {
+                id = enqueueUpdate(row, oldObject, deltaObject);
+            } else {
+                id = _enginio->update(deltaObject, _operation);
+                registerReply(id, row, oldObject);
+            }
+            _data.replace(row, newObject);
+            emit q->dataChanged(q->index(row), q->index(row));
+            return id;
+        }
+        EnginioClientPrivate *client = EnginioClientPrivate::get(_enginio);
+        QNetworkReply *nreply = new EnginioFakeReply(client, constructErrorMessage(QByteArrayLiteral("EnginioModel: Trying to update an object with unknown role")));
+        EnginioReply *ereply = new EnginioReply(client, nreply);
+        return ereply;
+    }
+
+    int writeBehindInterval() const
+    {
+        return _writeBehindInterval;
+    }
+
+    void setWriteBehindInterval(int interval)
+    {
+        _writeBehindInterval = interval;
+        if (interval <= 0)
+            flushPendingUpdates();
+        emit q->writeBehindIntervalChanged(interval);
+    }
+
+    EnginioReply *enqueueUpdate(int row, const QJsonObject &oldObject, const QJsonObject &deltaObject)
+    {
+        const QString objectId = deltaObject[EnginioString::id].toString();
+        QHash<QString, PendingUpdate>::iterator i = _pendingUpdates.find(objectId);
+        if (i == _pendingUpdates.end()) {
+            // The reply is returned now, the request is attached to it when the delta is flushed.
+            PendingUpdate update;
+            update.delta = deltaObject;
+            update.reply = EnginioClientPrivate::get(_enginio)->createDeferredReply();
+            update.key = update.reply;
+            update.ownReply = false;
+            update.replyDestroyed = QObject::connect(update.reply, &QObject::destroyed, PendingReplyDestroyed(this, objectId));
+            // the old object is kept for the whole batch, so a failure reverts all merged changes
+            registerReply(update.reply, row, oldObject);
+            _pendingUpdates.insert(objectId, update);
+            if (!_writeBehindTimer.isActive())
+                _writeBehindTimer.start(_writeBehindInterval);
+            return update.reply;
+        }
+
+        for (QJsonObject::const_iterator j = deltaObject.constBegin(); j != deltaObject.constEnd(); ++j)
+            i->delta[j.key()] = j.value();
+        if (i->ownReply) {
+            // the merged delta is returned to the new caller, the model does not need its own reply anymore
+            EnginioReply *ownReply = i->reply;
+            i->reply = EnginioClientPrivate::get(_enginio)->createDeferredReply();
+            i->key = i->reply;
+            i->ownReply = false;
+            i->replyDestroyed = QObject::connect(i->reply, &QObject::destroyed, PendingReplyDestroyed(this, objectId));
+            moveReply(ownReply, i->reply);
+            delete ownReply;
+        }
+        return i->reply;
+    }
+
+    void pendingReplyDestroyed(const QString &objectId)
+    {
+        // The change is in the cache already, so it is sent anyway. The model keeps
+        // a reply of its own for it, to synchronize the row when it is finished.
+        QHash<QString, PendingUpdate>::iterator i = _pendingUpdates.find(objectId);
+        if (i == _pendingUpdates.end())
+            return;
+        EnginioReply *ownReply = EnginioClientPrivate::get(_enginio)->createDeferredReply();
+        QObject::connect(ownReply, &EnginioReply::finished, ownReply, &EnginioReply::deleteLater);
+        moveReply(i->key, ownReply);
+        i->reply = ownReply;
+        i->key = ownReply;
+        i->ownReply = true;
+    }
+
+    void moveReply(const EnginioReply *from, const EnginioReply *to)
+    {
+        QObject::disconnect(_repliesConnections.take(from));
+        const QPair<int, QJsonObject> requestInfo = _dataChanged.take(from);
+        registerReply(to, requestInfo.first, requestInfo.second);
+    }
+
+    void dropPendingUpdate(const EnginioReply *reply)
+    {
+        // a reply finished before its delta was sent was aborted or timed out, the row is
+        // reverted and the delta must not be sent anymore
+        for (QHash<QString, PendingUpdate>::iterator i = _pendingUpdates.begin(); i != _pendingUpdates.end(); ++i) {
+            if (i->key == reply) {
+                QObject::disconnect(i->replyDestroyed);
+                _pendingUpdates.erase(i);
+                return;
+            }
+        }
+    }
+
+    void clearPendingUpdates()
+    {
+        foreach (const PendingUpdate &update, _pendingUpdates)
+            QObject::disconnect(update.replyDestroyed);
+        _pendingUpdates.clear();
+    }
+
+    void flushPendingUpdates()
+    {
+        _writeBehindTimer.stop();
+        if (_pendingUpdates.isEmpty() || !_enginio)
+            return;
+
+        QHash<QString, PendingUpdate> pendingUpdates;
+        pendingUpdates.swap(_pendingUpdates);
+
+        EnginioClientPrivate *client = EnginioClientPrivate::get(_enginio);
+        foreach (const PendingUpdate &update, pendingUpdates) {
+            QObject::disconnect(update.replyDestroyed);
+            QNetworkReply *nreply = client->update<QJsonObject>(update.delta, _operation);
+            client->setNetworkReply(update.reply, nreply);
+        }
+    }
+
+    int addRole(const QString &name)
+    {
+        int role = _roleIds.value(name, InvalidRole);
+        if (role != InvalidRole)
+            return role;
+        role = _rolesCounter++;
+        _roles[role] = name;
+        _roleIds[name] = role;
+        _roleNames[role] = name.toUtf8();
+        return role;
+    }
+
+    void addPredefinedRoles()
+    {
+        // TODO Use a proper name for _synced, can we make it an attached property in qml? Does it make sense to try?
+        _rolesCounter = SyncedRole;
+        addRole(EnginioString::_synced);
+        addRole(EnginioString::createdAt);
+        addRole(EnginioString::updatedAt);
+        addRole(EnginioString::id);
+        addRole(EnginioString::objectType);
+        Q_ASSERT(_rolesCounter == LastRole);
+    }
+
+    void syncRoles()
+    {
+        if (!_declaredRoles.isEmpty())
+            return;
+
+        QJsonObject firstObject(_data.first().toObject());
+
+        if (!_roles.count())
+            addPredefinedRoles();
+
+        // estimate additional dynamic roles:
         for (QJsonObject::const_iterator i = firstObject.constBegin(); i != firstObject.constEnd(); ++i) {
             const QString key = i.key();
-            if (definedRoles.contains(key)) {
+            if (_roleIds.contains(key)) {
                 // we skip predefined keys so we can keep constant id for them
                 if (Q_UNLIKELY(key == EnginioString::_synced))
                     qWarning("EnginioModel can not be used with objects having \"_synced\" property. The property will be overriden.");
             } else
-                _roles[_rolesCounter++] = i.key();
+                addRole(key);
         }
     }
 
     QHash<int, QByteArray> roleNames() const
     {
-        // TODO this is not optimal, but happen once, do we want to do something about it?
-        QHash<int, QByteArray> roles;
-        roles.reserve(_roles.count());
-        for (QHash<int, QString>::const_iterator i = _roles.constBegin();
-             i != _roles.constEnd();
-             ++i) {
-            roles.insert(i.key(), i.value().toUtf8());
+        return _roleNames;
+    }
+
+    QJsonObject roles() const
+    {
+        return _declaredRoles;
+    }
+
+    void setRoles(const QJsonObject &roles)
+    {
+        q->beginResetModel();
+        _roles.clear();
+        _roleIds.clear();
+        _roleNames.clear();
+        _roleTypes.clear();
+        _declaredRoles = roles;
+        if (!roles.isEmpty()) {
+            addPredefinedRoles();
+            for (QJsonObject::const_iterator i = roles.constBegin(); i != roles.constEnd(); ++i) {
+                const int role = addRole(i.key());
+                const int type = roleType(i.value().toString());
+                if (type != QMetaType::UnknownType)
+                    _roleTypes.insert(role, type);
+            }
+        } else if (!_data.isEmpty()) {
+            syncRoles();
         }
-        return roles;
+        q->endResetModel();
+        emit q->rolesChanged(_declaredRoles);
+    }
+
+    static int roleType(const QString &typeName)
+    {
+        if (typeName == QStringLiteral("string"))
+            return QMetaType::QString;
+        if (typeName == QStringLiteral("number"))
+            return QMetaType::Double;
+        if (typeName == QStringLiteral("int"))
+            return QMetaType::Int;
+        if (typeName == QStringLiteral("bool"))
+            return QMetaType::Bool;
+        if (typeName == QStringLiteral("object"))
+            return QMetaType::QJsonObject;
+        if (typeName == QStringLiteral("array"))
+            return QMetaType::QJsonArray;
+        if (Q_UNLIKELY(!typeName.isEmpty() && typeName != QStringLiteral("var")))
+            qWarning() << "EnginioModel: unknown role type" << typeName << ", the values are not converted";
+        return QMetaType::UnknownType;
+    }
+
+    static QVariant typedValue(const QJsonValue &value, int type)
+    {
+        switch (type) {
+        case QMetaType::UnknownType:
+            return value;
+        case QMetaType::QJsonObject:
+            return value.toObject();
+        case QMetaType::QJsonArray:
+            return value.toArray();
+        default:
+            break;
+        }
+        // missing properties read as the default value of the type, so bindings do not break
+        QVariant result = value.toVariant();
+        if (!result.convert(type))
+            return QVariant(type, static_cast<const void*>(0));
+        return result;
     }
 
     int rowCount() const
@@ -399,51 +1519,421 @@ public:
 
     QVariant data(unsigned row, int role)
     {
+        if (_prefetchPages && int(row) > _highestAccessedRow) {
+            // views read many rows at once, the pages are requested afterwards
+            _highestAccessedRow = row;
+            _accessTimer.start();
+        }
+
+        if (_maxResidentRows > 0 && _query[EnginioString::limit].toDouble() > 0) {
+            if (!_data.isResident(row)) {
+                _evictedRowsRead.insert(row);
+                _accessTimer.start();
+                return QVariant();
+            }
+            touchPage(row);
+        }
+
+        return cachedData(row, role);
+    }
+
+    QVariant cachedData(int row, int role) const
+    {
+        if (!_data.isResident(row))
+            return QVariant();
+
         if (role == SyncedRole)
             return !_rowsToSync.contains(row);
 
         if (role == Qt::DisplayRole)
             return _data.at(row);
 
-        const QJsonObject object = _data.at(row).toObject();
-        if (!object.isEmpty()) {
-            const QString roleName = _roles.value(role);
-            if (!roleName.isEmpty())
-                return object[roleName];
-        }
+        const QString roleName = _roles.value(role);
+        if (!roleName.isEmpty())
+            return typedValue(_data.value(row, roleName), _roleTypes.value(role, QMetaType::UnknownType));
 
         return QVariant();
     }
 
     bool canFetchMore() const
     {
-        return _canFetchMore;
+        return _canFetchMore || !_failedPages.isEmpty();
     }
 
     void fetchMore(int row)
     {
-        int currentOffset = _data.count();
-        if (!_canFetchMore || currentOffset < _latestRequestedOffset)
-            return; // we do not want to spam the server, lets wait for the last fetch
+        // the view reached the end, the next page is needed together with the prefetch window
+        const int pageSize = _query[EnginioString::limit].toDouble();
+        requestPages(qMax(row, _data.count()) + _prefetchPages * pageSize);
+    }
+
+    void rowsAccessed()
+    {
+        QSet<int> evictedRows;
+        evictedRows.swap(_evictedRowsRead);
+        foreach (int row, evictedRows) {
+            if (row < _data.count() && !_data.isResident(row))
+                reloadPage(row);
+        }
+        prefetch();
+    }
+
+    void prefetch()
+    {
+        if (!_prefetchPages)
+            return;
+        const int pageSize = _query[EnginioString::limit].toDouble();
+        requestPages(_highestAccessedRow + _prefetchPages * pageSize);
+    }
+
+    void requestPages(int lastWantedRow)
+    {
+        // we do not want to spam the server, only a few pages can be requested at the same time
+        const int pageSize = _query[EnginioString::limit].toDouble();
+        if (!_enginio || pageSize <= 0 || _fullResetPending)
+            return;
+
+        while (!_failedPages.isEmpty() && _pageRequests.count() < MaxConcurrentPageRequests)
+            requestPage(_failedPages.take(_failedPages.firstKey()));
+
+        const bool keyset = _pagingMode == EnginioModel::KeysetPaging;
+        while (_canFetchMore && _latestRequestedOffset <= lastWantedRow
+               && _pageRequests.count() < MaxConcurrentPageRequests) {
+            // in keyset mode the next page depends on the last row of the previous one
+            if (keyset && !_pageRequests.isEmpty())
+                break;
+
+            // the offset is kept locally for keyset pages too, it orders the pages in the cache
+            QJsonObject pageInfo(_query);
+            pageInfo[EnginioString::offset] = _latestRequestedOffset;
+            pageInfo[EnginioString::limit] = pageSize;
+            _latestRequestedOffset += pageSize;
+            requestPage(pageInfo);
+        }
+    }
 
+    void requestPage(const QJsonObject &pageInfo)
+    {
+        QJsonObject query(pageInfo);
+        if (_pagingMode == EnginioModel::KeysetPaging) {
+            query = keysetQuery();
+            query[EnginioString::limit] = pageInfo[EnginioString::limit];
+        }
+        EnginioReply *id = _enginio->query(projected(query), _operation);
+        QObject::connect(id, &EnginioReply::finished, id, &EnginioReply::deleteLater);
+        registerReply(id, IncrementalModelUpdate, pageInfo);
+        _pageRequests.insert(id);
+    }
+
+    QString keysetSortKey(bool *ascending = 0) const
+    {
+        // the first sort criterion is the key, without any the query is sorted by creation time
+        const QJsonArray sort = _query[EnginioString::sort].toArray();
+        const QJsonObject sortBy = sort.isEmpty() ? QJsonObject() : sort.first().toObject();
+        if (ascending)
+            *ascending = sortBy[EnginioString::direction].toString() != EnginioString::desc;
+        return sortBy.isEmpty() ? EnginioString::createdAt : sortBy[EnginioString::sortBy].toString();
+    }
+
+    QJsonObject keysetQuery() const
+    {
         QJsonObject query(_query);
+        ensureSorted(query);
+        if (_keysetLastValue.isUndefined())
+            return query; // the first page
+
+        bool ascending;
+        const QString key = keysetSortKey(&ascending);
+        QJsonObject filter = query[EnginioString::query].toObject();
+        // conditions of the user on the sort key are kept, the page boundary is added to them
+        QJsonObject condition = filter[key].toObject();
+        if (ascending)
+            condition[_keysetStrict ? QStringLiteral("$gt") : QStringLiteral("$gte")] = _keysetLastValue;
+        else
+            condition[_keysetStrict ? QStringLiteral("$lt") : QStringLiteral("$lte")] = _keysetLastValue;
+        filter[key] = condition;
+        query[EnginioString::query] = filter;
+        return query;
+    }
 
-        int limit = query[EnginioString::limit].toDouble();
-        limit = qMax(row - currentOffset, limit); // check if default limit is not too small
+    QJsonArray mergeKeysetPage(const QJsonArray &page)
+    {
+        // Rows sharing the sort key value of the page boundary are fetched again with the
+        // next page, they are skipped by id, as are rows which moved since they were fetched.
+        QJsonArray rows;
+        for (int i = 0; i < page.count(); ++i) {
+            const QString objectId = page.at(i).toObject()[EnginioString::id].toString();
+            if (_keysetIds.contains(objectId))
+                continue;
+            _keysetIds.insert(objectId);
+            rows.append(page.at(i));
+        }
+        if (page.isEmpty())
+            return rows;
+
+        _keysetLastValue = page.last().toObject()[keysetSortKey()];
+        if (rows.isEmpty()) {
+            // The whole page shares one key value, the next page has to skip past it.
+            // If even that did not bring anything new the key can not move forward.
+            if (_keysetStrict)
+                _canFetchMore = false;
+            _keysetStrict = true;
+        } else {
+            _keysetStrict = false;
+        }
+        return rows;
+    }
 
-        query[EnginioString::offset] = currentOffset;
-        query[EnginioString::limit] = limit;
+    void insertFetchedPages()
+    {
+        // pages can finish in any order, but they are inserted in the order of offsets
+        while (!_fetchedPages.isEmpty() && _fetchedPages.firstKey() == _nextPageOffset) {
+            QPair<int, QJsonArray> page = _fetchedPages.take(_nextPageOffset);
+            _nextPageOffset += page.first;
+            if (_pagingMode == EnginioModel::KeysetPaging)
+                page.second = mergeKeysetPage(page.second);
+            if (page.second.isEmpty())
+                continue;
+
+            const int startingRow = _data.count();
+            const bool discoverRoles = !startingRow && _declaredRoles.isEmpty();
+            if (discoverRoles) // the first item need to update roles
+                q->beginResetModel();
+            else
+                q->beginInsertRows(QModelIndex(), startingRow, startingRow + page.second.count() - 1);
+            for (int i = 0; i < page.second.count(); ++i)
+                _data.append(page.second[i]);
+            if (discoverRoles) {
+                syncRoles();
+                q->endResetModel();
+            } else {
+                q->endInsertRows();
+            }
+            markPagesResident(startingRow, _data.count() - 1);
+        }
+        evictPages();
+    }
 
-        qDebug() << Q_FUNC_INFO << query;
-        _latestRequestedOffset += limit;
-        EnginioReply *id = _enginio->query(query, _operation);
+    int maxResidentRows() const
+    {
+        return _maxResidentRows;
+    }
+
+    void setMaxResidentRows(int rows)
+    {
+        _maxResidentRows = qMax(0, rows);
+        emit q->maxResidentRowsChanged(_maxResidentRows);
+        evictPages();
+    }
+
+    void markPagesResident(int firstRow, int lastRow)
+    {
+        const int pageSize = _query[EnginioString::limit].toDouble();
+        if (pageSize <= 0 || firstRow > lastRow)
+            return;
+        for (int page = firstRow / pageSize; page <= lastRow / pageSize; ++page) {
+            if (!_residentPages.contains(page))
+                _residentPages.prepend(page);
+        }
+    }
+
+    void touchPage(int row)
+    {
+        const int page = row / int(_query[EnginioString::limit].toDouble());
+        if (!_residentPages.isEmpty() && _residentPages.first() == page)
+            return;
+        _residentPages.removeOne(page);
+        _residentPages.prepend(page);
+    }
+
+    void evictPages()
+    {
+        const int pageSize = _query[EnginioString::limit].toDouble();
+        if (_maxResidentRows <= 0 || pageSize <= 0)
+            return;
+
+        // the most recently used page always stays
+        for (int i = _residentPages.count() - 1; i > 0 && _residentPages.count() * pageSize > _maxResidentRows; --i) {
+            const int page = _residentPages.at(i);
+            const int firstRow = page * pageSize;
+            const int lastRow = qMin(firstRow + pageSize, _data.count()) - 1;
+            bool unsynced = false;
+            for (int row = firstRow; row <= lastRow && !unsynced; ++row)
+                unsynced = _rowsToSync.contains(row) || _data.id(row).isEmpty();
+            if (unsynced)
+                continue; // local changes would be lost, or the rows could not be fetched again
+            for (int row = firstRow; row <= lastRow; ++row)
+                _data.evict(row);
+            _residentPages.removeAt(i);
+        }
+    }
+
+    void reloadPage(int row)
+    {
+        // Rows move when other rows are inserted or removed, and in keyset mode pages do not
+        // start at multiples of the page size, so the evicted rows are fetched by their ids.
+        const int pageSize = _query[EnginioString::limit].toDouble();
+        if (!_enginio || pageSize <= 0)
+            return;
+        const int firstRow = row / pageSize * pageSize;
+        const int lastRow = qMin(firstRow + pageSize, _data.count()) - 1;
+        QJsonArray ids;
+        for (int i = firstRow; i <= lastRow; ++i) {
+            const QString objectId = _data.id(i);
+            if (_data.isResident(i) || objectId.isEmpty() || _reloadingIds.contains(objectId))
+                continue;
+            ids.append(objectId);
+            _reloadingIds.insert(objectId);
+        }
+        if (ids.isEmpty())
+            return;
+
+        QJsonObject in;
+        in[QStringLiteral("$in")] = ids;
+        QJsonObject filter;
+        filter[EnginioString::id] = in;
+        QJsonObject query;
+        query[EnginioString::objectType] = _query[EnginioString::objectType];
+        query[EnginioString::query] = filter;
+        query[EnginioString::limit] = ids.count();
+        EnginioReply *id = _enginio->query(projected(query), _operation);
         QObject::connect(id, &EnginioReply::finished, id, &EnginioReply::deleteLater);
-        _dataChanged.insert(id, qMakePair(IncrementalModelUpdate, query));
+        QJsonObject info;
+        info[QStringLiteral("ids")] = ids;
+        registerReply(id, PageReload, info);
+    }
+
+    void finishedPageReload(const EnginioReply *response, const QJsonObject &info)
+    {
+        const QJsonArray ids = info[QStringLiteral("ids")].toArray();
+        bool current = false;
+        for (int i = 0; i < ids.count(); ++i)
+            current = _reloadingIds.remove(ids.at(i).toString()) || current;
+        if (!current)
+            return; // the query was changed in the meantime
+        if (response->networkError() != QNetworkReply::NoError)
+            return; // it is requested again on the next access
+
+        // rows which are in memory are never overwritten
+        const QJsonArray results = response->data()[EnginioString::results].toArray();
+        QSet<QString> found;
+        int firstRow = _data.count();
+        int lastRow = -1;
+        for (int i = 0; i < results.count(); ++i) {
+            const QString objectId = results.at(i).toObject()[EnginioString::id].toString();
+            found.insert(objectId);
+            const int row = _data.rowOfId(objectId);
+            if (row == -1 || _data.isResident(row))
+                continue;
+            _data.refresh(row, results.at(i));
+            firstRow = qMin(firstRow, row);
+            lastRow = qMax(lastRow, row);
+        }
+        if (lastRow != -1) {
+            touchPage(firstRow);
+            evictPages();
+            emit q->dataChanged(q->index(firstRow), q->index(lastRow));
+        }
+
+        // objects which did not come back were removed from the backend
+        QList<int> removedRows;
+        for (int i = 0; i < ids.count(); ++i) {
+            const QString objectId = ids.at(i).toString();
+            const int row = _data.rowOfId(objectId);
+            if (!found.contains(objectId) && row != -1 && !_data.isResident(row))
+                removedRows.append(row);
+        }
+        removeRowsFromCache(removedRows);
+    }
+
+    int prefetchPages() const
+    {
+        return _prefetchPages;
+    }
+
+    void setPrefetchPages(int pages)
+    {
+        _prefetchPages = qMax(0, pages);
+        emit q->prefetchPagesChanged(_prefetchPages);
+        prefetch();
+    }
+
+    bool fieldProjection() const
+    {
+        return _fieldProjection;
+    }
+
+    void setFieldProjection(bool enabled)
+    {
+        _fieldProjection = enabled;
+        updatePartial();
+        emit q->fieldProjectionChanged(enabled);
+    }
+
+    EnginioReply *fetchFullObject(int row)
+    {
+        if (!_data.isResident(row)) {
+            reloadPage(row);
+            return notResidentError();
+        }
+        const QString objectId = _data.value(row, EnginioString::id).toString();
+        if (objectId.isEmpty()) {
+            EnginioClientPrivate *client = EnginioClientPrivate::get(_enginio);
+            QNetworkReply *nreply = new EnginioFakeReply(client, constructErrorMessage(QByteArrayLiteral("EnginioModel::fetchFullObject: the object was not created in the backend yet")));
+            return new EnginioReply(client, nreply);
+        }
+        QJsonObject filter;
+        filter[EnginioString::id] = objectId;
+        QJsonObject query;
+        query[EnginioString::objectType] = _query[EnginioString::objectType];
+        query[EnginioString::query] = filter;
+        query[EnginioString::limit] = 1;
+        EnginioReply *id = _enginio->query(query, _operation);
+        QJsonObject info;
+        info[EnginioString::id] = objectId;
+        registerReply(id, FullObjectFetch, info);
+        return id;
+    }
+
+    void finishedFullObjectFetch(const EnginioReply *response, const QJsonObject &info)
+    {
+        if (response->networkError() != QNetworkReply::NoError)
+            return;
+        const QJsonArray results = response->data()[EnginioString::results].toArray();
+        // rows may have moved since the request was sent
+        const int row = _data.rowOfId(info[EnginioString::id].toString());
+        if (results.isEmpty() || row == -1 || _rowsToSync.contains(row))
+            return;
+        _data.refresh(row, results.first());
+        emit q->dataChanged(q->index(row), q->index(row));
+    }
+
+    EnginioModel::PagingMode pagingMode() const
+    {
+        return _pagingMode;
+    }
+
+    void setPagingMode(EnginioModel::PagingMode mode)
+    {
+        _pagingMode = mode;
+        emit q->pagingModeChanged(mode);
     }
 };
 
 const int EnginioModelPrivate::FullModelReset = -1;
 const int EnginioModelPrivate::IncrementalModelUpdate = -2;
+const int EnginioModelPrivate::ShardedModelReset = -3;
+const int EnginioModelPrivate::DeltaSync = -4;
+const int EnginioModelPrivate::DeltaSyncCount = -5;
+const int EnginioModelPrivate::DeltaSyncReconciliation = -6;
+const int EnginioModelPrivate::PageReload = -7;
+const int EnginioModelPrivate::FullObjectFetch = -8;
+const int EnginioModelPrivate::BulkRemove = -9;
+const int EnginioModelPrivate::DetachedWrite = -10;
+const int EnginioModelPrivate::DeltaSyncPageSize = 100;
+const int EnginioModelPrivate::FallbackSyncInterval = 5000;
+const int EnginioModelPrivate::MaxConcurrentWrites = 6;
+const int EnginioModelPrivate::MaxConcurrentPageRequests = 4;
 
 
 /*!
@@ -462,6 +1952,7 @@ const int EnginioModelPrivate::IncrementalModelUpdate = -2;
   index
 
   Sorting is done server side, as soon as data is changed locally it will be invalid.
+  To sort and filter the cached rows locally, without new queries, use \l EnginioSortFilterProxyModel.
 
   \note that the EnginioClient does not emit the finished and error signals for the model.
 
@@ -539,6 +2030,294 @@ void EnginioModel::setOperation(EnginioClient::Operation operation)
     d->setOperation(operation);
 }
 
+/*!
+  \property EnginioModel::initialLoadShards
+  \brief The number of parallel queries used to load the data for the model.
+
+  By default the value is 0 and the data is loaded with a single query. With a value
+  greater than 1, the model first asks the backend for the number of objects matching
+  the \l query and then loads them with the given number of \c offset / \c limit
+  queries sent in parallel. The results are inserted in order as they arrive.
+  If the query has no \c sort, the objects are sorted by \c createdAt so the shards
+  do not overlap. If any of the shards fails, the data is fetched again with a single query.
+
+  The property is ignored for queries using the \c pageSize.
+
+  \sa query
+*/
+int EnginioModel::initialLoadShards() const
+{
+    return d->initialLoadShards();
+}
+
+void EnginioModel::setInitialLoadShards(int shards)
+{
+    if (shards == d->initialLoadShards())
+        return;
+    d->setInitialLoadShards(shards);
+}
+
+/*!
+  \property EnginioModel::maxResidentRows
+  \brief The maximum number of rows which are kept in memory.
+
+  It is used only if the \l query contains a \c pageSize. By default the value
+  is 0 and all fetched rows are kept. Otherwise, when the fetched pages exceed the
+  limit, the least recently accessed pages are dropped from memory. Their rows stay in
+  the model, but until the page is fetched again, which is started by accessing any of
+  its rows, the data of the rows is invalid. The objects of the page are fetched again by
+  their ids, so rows inserted or removed in the meantime do not shift them; rows of objects
+  which were removed from the backend are removed from the model. Pages with local changes
+  which were not synchronized yet are never dropped.
+
+  \sa query, prefetchPages
+*/
+int EnginioModel::maxResidentRows() const
+{
+    return d->maxResidentRows();
+}
+
+void EnginioModel::setMaxResidentRows(int rows)
+{
+    if (rows == d->maxResidentRows())
+        return;
+    d->setMaxResidentRows(rows);
+}
+
+/*!
+  \property EnginioModel::prefetchPages
+  \brief The number of pages which are requested ahead of the rows accessed by a view.
+
+  It is used only if the \l query contains a \c pageSize. By default the value is 0
+  and the next page is requested when a view reaches the end of the model. With a positive
+  value the model keeps the given number of pages beyond the highest row accessed so far
+  requested, so scrolling does not stall on page boundaries. A few pages can be
+  requested at the same time; they are inserted in order, even if they arrive out of order.
+  A page which failed to be fetched is requested again first, the pages after it are
+  inserted once it arrives.
+
+  \sa query
+*/
+int EnginioModel::prefetchPages() const
+{
+    return d->prefetchPages();
+}
+
+void EnginioModel::setPrefetchPages(int pages)
+{
+    if (pages == d->prefetchPages())
+        return;
+    d->setPrefetchPages(pages);
+}
+
+/*!
+  \property EnginioModel::writeBehindInterval
+  \brief The time in milliseconds for which property changes are collected before
+  they are sent to the backend.
+
+  By default the value is 0 and every call to \l setProperty() or \l setData() sends
+  an update request immediately. With a positive interval, changes of the same object
+  are merged and sent as a single update once the interval elapses. All calls which
+  contributed to the merged update return the same EnginioReply. The update is sent
+  even if that reply is deleted before the interval elapses. Aborting the reply, or
+  its timeout, before the update is sent drops the merged changes and reverts the row.
+
+  \sa setProperty()
+*/
+int EnginioModel::writeBehindInterval() const
+{
+    return d->writeBehindInterval();
+}
+
+void EnginioModel::setWriteBehindInterval(int interval)
+{
+    if (interval == d->writeBehindInterval())
+        return;
+    d->setWriteBehindInterval(interval);
+}
+
+/*!
+  \property EnginioModel::syncInterval
+  \brief The interval in milliseconds in which the model calls \l synchronize().
+
+  By default the value is 0 and the model is synchronized only on demand.
+
+  \sa synchronize()
+*/
+int EnginioModel::syncInterval() const
+{
+    return d->syncInterval();
+}
+
+void EnginioModel::setSyncInterval(int interval)
+{
+    if (interval == d->syncInterval())
+        return;
+    d->setSyncInterval(interval);
+}
+
+/*!
+  \property EnginioModel::realtimeUpdates
+  \brief Whether the model applies changes pushed by the backend.
+
+  By default the value is false. If it is enabled and the model uses
+  EnginioClient::ObjectOperation, it subscribes to changes of the \c objectType
+  of the \l query. Created, updated and removed objects are applied to the
+  rows as they are notified, without fetching the query again. All models of the
+  same client share one subscription channel for an \c objectType.
+
+  If the query has a filter, whether an object matches it is decided by the backend
+  with \l synchronize(). While the channel is down the model synchronizes
+  periodically instead, and once more when it is connected again.
+
+  \sa synchronize(), syncInterval
+*/
+bool EnginioModel::realtimeUpdates() const
+{
+    return d->realtimeUpdates();
+}
+
+void EnginioModel::setRealtimeUpdates(bool enabled)
+{
+    if (enabled == d->realtimeUpdates())
+        return;
+    d->setRealtimeUpdates(enabled);
+}
+
+/*!
+  Bring the local cache up to date with the backend without fetching the whole \l query again.
+
+  Only objects with an \c updatedAt newer than the newest one in the cache are
+  requested; they are patched into their rows, found by the object id, or appended
+  if the model does not have them yet. Rows with local changes which were not synchronized
+  yet are not touched.
+
+  Afterwards the number of objects matching the query is compared to the number of cached
+  objects. If the backend has less of them, only the ids of the matching objects are requested
+  and the rows of the missing ones are removed. Both the changed objects and the ids are
+  fetched in pages, until all of them have arrived. Removed objects are detected only when
+  all pages of a query with a \c pageSize are fetched.
+
+  \sa syncInterval
+*/
+void EnginioModel::synchronize()
+{
+    d->synchronize();
+}
+
+/*!
+  \property EnginioModel::fieldProjection
+  \brief Whether queries of the model download only the properties used as roles.
+
+  When enabled, the queries which fetch pages, synchronize or reload rows contain a
+  \c fields list with the role names of the model, so other properties of the objects
+  are not transferred. The roles are taken from the first object fetched, so the
+  first query of the model is not projected, unless the \l roles are declared. A \c fields list in the \l query itself
+  is always respected. Use fetchFullObject() to get all properties of a row.
+
+  Changing the property fetches the query again. It is disabled by default.
+  \sa EnginioClient::query()
+*/
+bool EnginioModel::fieldProjection() const
+{
+    return d->fieldProjection();
+}
+
+void EnginioModel::setFieldProjection(bool enabled)
+{
+    if (enabled == d->fieldProjection())
+        return;
+    d->setFieldProjection(enabled);
+}
+
+/*!
+  \property EnginioModel::roles
+  \brief The roles of the model and the types of their values.
+
+  The keys of the object are the property names which are exposed as roles, the values
+  are their types: \c "string", \c "number", \c "int", \c "bool", \c "object",
+  \c "array" or \c "var". Values of a role with a type are converted to it, a missing
+  property gives the default value of the type. Values of \c "var" roles are
+  returned unchanged as QJsonValue.
+
+  The properties \c id, \c objectType, \c createdAt and \c updatedAt are always roles.
+
+  When the roles are declared, views can bind to them before any data arrives,
+  and the model does not look at the first object to discover them. Otherwise, which
+  is the default, the roles are the properties of the first object fetched.
+
+  Changing the roles resets the model.
+  \sa roleNames()
+*/
+QJsonObject EnginioModel::roles() const
+{
+    return d->roles();
+}
+
+void EnginioModel::setRoles(const QJsonObject &roles)
+{
+    if (roles == d->roles())
+        return;
+    d->setRoles(roles);
+}
+
+/*!
+  Fetch all properties of the object in \a row, when the model downloads only
+  some of them because of \l fieldProjection or a \c fields list in the \l query.
+  The row is updated when the reply finishes.
+  \return reply from backend
+*/
+EnginioReply *EnginioModel::fetchFullObject(int row)
+{
+    if (unsigned(row) >= unsigned(d->rowCount())) {
+        EnginioClientPrivate *client = EnginioClientPrivate::get(d->enginio());
+        QNetworkReply *nreply = new EnginioFakeReply(client, constructErrorMessage(QByteArrayLiteral("EnginioModel::fetchFullObject: row is out of range")));
+        EnginioReply *ereply = new EnginioReply(client, nreply);
+        return ereply;
+    }
+
+    return d->fetchFullObject(row);
+}
+
+/*!
+  \enum EnginioModel::PagingMode
+
+  The way the model requests the pages of a query containing a \c pageSize.
+
+  \value OffsetPaging
+    A page is requested with the \c offset of its first row.
+  \value KeysetPaging
+    A page is requested with a condition that the sort key is greater than
+    its value in the last fetched row (smaller for descending sort). The sort
+    key is the first entry of the query's \c sort, or \c createdAt if there is none.
+    The backend does not need to skip over all the previous rows, and rows
+    created or removed in the meantime do not shift the pages.
+*/
+
+/*!
+  \property EnginioModel::pagingMode
+  \brief The way the pages of the \l query are requested.
+
+  By default the value is EnginioModel::OffsetPaging. The property is used only if the
+  \l query contains a \c pageSize. Pages requested with EnginioModel::KeysetPaging depend on
+  each other, so they are requested one at a time. Rows which were already fetched with a
+  previous page are skipped. The sort key should be close to unique, if more rows than a page
+  share the same value of the key only the first page of them is fetched.
+
+  \sa query, prefetchPages
+*/
+EnginioModel::PagingMode EnginioModel::pagingMode() const
+{
+    return d->pagingMode();
+}
+
+void EnginioModel::setPagingMode(EnginioModel::PagingMode mode)
+{
+    if (mode == d->pagingMode())
+        return;
+    d->setPagingMode(mode);
+}
+
 /*!
   Append \a value to this model local cache and send a create request
   to enginio backend.
@@ -568,6 +2347,45 @@ EnginioReply *EnginioModel::remove(int row)
     return d->remove(row);
 }
 
+/*!
+  Append all objects from \a values to this model local cache and send
+  create requests to the Enginio backend.
+
+  The rows are inserted with a single model change. The requests are queued
+  and only a few of them are sent to the backend at the same time. Each
+  row is synchronized separately, as soon as its own request finishes.
+  \return replies from backend, one for each appended object, in the same order
+  \sa append(), EnginioClient::create()
+*/
+QList<EnginioReply*> EnginioModel::appendRows(const QJsonArray &values)
+{
+    if (!d->enginio())
+        return QList<EnginioReply*>();
+    return d->appendRows(values);
+}
+
+/*!
+  \overload
+  Remove \a count objects starting from \a row in this model local cache and
+  send remove requests to the Enginio backend.
+
+  The rows are removed from the model at once, with a single model change. The requests
+  are queued and only a few of them are sent to the backend at the same time. Objects
+  which failed to be removed on the backend are appended to the model again.
+  \return false if the range is invalid or some of its rows are not in memory, see \l maxResidentRows
+  \sa remove()
+*/
+bool EnginioModel::removeRows(int row, int count, const QModelIndex &parent)
+{
+    if (parent.isValid() || row < 0 || count <= 0 || row + count > d->rowCount() || !d->enginio())
+        return false;
+
+    const QList<EnginioReply*> replies = d->removeRows(row, count);
+    foreach (EnginioReply *reply, replies)
+        QObject::connect(reply, &EnginioReply::finished, reply, &EnginioReply::deleteLater);
+    return !replies.isEmpty();
+}
+
 /*!
   Update a value on \a row of this model's local cache
   and send an update request to the Enginio backend.
@@ -612,6 +2430,16 @@ QVariant EnginioModel::data(const QModelIndex &index, int role) const
     return d->data(index.row(), role);
 }
 
+/*!
+    \internal
+    Returns the value of \a role in \a row like data(), but only from memory, without
+    touching the pages or fetching rows. Rows which are not in memory give an invalid QVariant.
+*/
+QVariant EnginioModel::cachedData(int row, int role) const
+{
+    return d->cachedData(row, role);
+}
+
 /*!
     \overload
     \internal
@@ -39,7 +39,9 @@
 #define ENGINIOMODEL_H
 
 #include <QAbstractListModel>
+#include <QtCore/qjsonarray.h>
 #include <QtCore/qjsonobject.h>
+#include <QtCore/qlist.h>
 #include <QtCore/qscopedpointer.h>
 
 #include "enginioclient.h"
@@ -49,12 +51,27 @@ class ENGINIOCLIENT_EXPORT EnginioModel : public QAbstractListModel
 {
     Q_OBJECT
 public:
+    enum PagingMode {
+        OffsetPaging,
+        KeysetPaging
+    };
+    Q_ENUMS(PagingMode)
+
     explicit EnginioModel(QObject *parent = 0);
     ~EnginioModel();
 
     Q_PROPERTY(EnginioClient *enginio READ enginio WRITE setEnginio NOTIFY enginioChanged)
     Q_PROPERTY(QJsonObject query READ query WRITE setQuery NOTIFY queryChanged)
     Q_PROPERTY(EnginioClient::Operation operation READ operation WRITE setOperation NOTIFY operationChanged)
+    Q_PROPERTY(int initialLoadShards READ initialLoadShards WRITE setInitialLoadShards NOTIFY initialLoadShardsChanged)
+    Q_PROPERTY(int prefetchPages READ prefetchPages WRITE setPrefetchPages NOTIFY prefetchPagesChanged)
+    Q_PROPERTY(int maxResidentRows READ maxResidentRows WRITE setMaxResidentRows NOTIFY maxResidentRowsChanged)
+    Q_PROPERTY(int writeBehindInterval READ writeBehindInterval WRITE setWriteBehindInterval NOTIFY writeBehindIntervalChanged)
+    Q_PROPERTY(PagingMode pagingMode READ pagingMode WRITE setPagingMode NOTIFY pagingModeChanged)
+    Q_PROPERTY(int syncInterval READ syncInterval WRITE setSyncInterval NOTIFY syncIntervalChanged)
+    Q_PROPERTY(bool realtimeUpdates READ realtimeUpdates WRITE setRealtimeUpdates NOTIFY realtimeUpdatesChanged)
+    Q_PROPERTY(bool fieldProjection READ fieldProjection WRITE setFieldProjection NOTIFY fieldProjectionChanged)
+    Q_PROPERTY(QJsonObject roles READ roles WRITE setRoles NOTIFY rolesChanged)
 
     // TODO: that is a pretty silly name
     EnginioClient *enginio() const;
@@ -66,10 +83,38 @@ public:
     EnginioClient::Operation operation() const;
     void setOperation(EnginioClient::Operation opertaion);
 
+    int initialLoadShards() const;
+    void setInitialLoadShards(int shards);
+
+    int prefetchPages() const;
+    void setPrefetchPages(int pages);
+
+    int maxResidentRows() const;
+    void setMaxResidentRows(int rows);
+
+    int writeBehindInterval() const;
+    void setWriteBehindInterval(int interval);
+
+    PagingMode pagingMode() const;
+    void setPagingMode(PagingMode mode);
+
+    int syncInterval() const;
+    void setSyncInterval(int interval);
+
+    bool realtimeUpdates() const;
+    void setRealtimeUpdates(bool enabled);
+
+    bool fieldProjection() const;
+    void setFieldProjection(bool enabled);
+
+    QJsonObject roles() const;
+    void setRoles(const QJsonObject &roles);
+
     virtual Qt::ItemFlags flags(const QModelIndex &index) const Q_DECL_OVERRIDE;
     virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
     virtual int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
     virtual bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) Q_DECL_OVERRIDE;
+    virtual bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) Q_DECL_OVERRIDE;
 
     virtual void fetchMore(const QModelIndex &parent) Q_DECL_OVERRIDE;
     virtual bool canFetchMore(const QModelIndex &parent) const Q_DECL_OVERRIDE;
@@ -77,6 +122,10 @@ public:
     Q_INVOKABLE EnginioReply *append(const QJsonObject &value);
     Q_INVOKABLE EnginioReply *remove(int row);
     Q_INVOKABLE EnginioReply *setProperty(int row, const QString &role, const QVariant &value);
+    Q_INVOKABLE void synchronize();
+    Q_INVOKABLE EnginioReply *fetchFullObject(int row);
+
+    QList<EnginioReply*> appendRows(const QJsonArray &values);
 
     virtual QHash<int, QByteArray> roleNames() const Q_DECL_OVERRIDE;
 
@@ -84,11 +133,26 @@ Q_SIGNALS:
     void operationChanged(const EnginioClient::Operation operation);
     void queryChanged(const QJsonObject query);
     void enginioChanged(EnginioClient *enginio);
+    void initialLoadShardsChanged(int shards);
+    void prefetchPagesChanged(int pages);
+    void maxResidentRowsChanged(int rows);
+    void writeBehindIntervalChanged(int interval);
+    void pagingModeChanged(const EnginioModel::PagingMode mode);
+    void syncIntervalChanged(int interval);
+    void realtimeUpdatesChanged(bool enabled);
+    void fieldProjectionChanged(bool enabled);
+    void rolesChanged(const QJsonObject &roles);
 
 private:
     Q_DISABLE_COPY(EnginioModel)
     QScopedPointer<EnginioModelPrivate> d;
     friend class EnginioModelPrivate;
+    friend class EnginioSortFilterProxyModelPrivate;
+
+    QVariant cachedData(int row, int role) const;
 };
 
+Q_DECLARE_TYPEINFO(EnginioModel::PagingMode, Q_PRIMITIVE_TYPE);
+Q_DECLARE_METATYPE(EnginioModel::PagingMode);
+
 #endif // ENGINIOMODEL_H
@@ -0,0 +1,174 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://qt.digia.com/contact-us
+**
+** This file is part of the Enginio Qt Client Library.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+****************************************************************************/
+
+#include "enginionotificationchannel_p.h"
+#include "enginioclient_p.h"
+
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qurlquery.h>
+#include <QtNetwork/qnetworkreply.h>
+
+namespace {
+const int MinReconnectDelay = 1000;
+const int MaxReconnectDelay = 30000;
+}
+
+class EnginioNotificationChannel::PollFinished
+{
+    EnginioNotificationChannel *_channel;
+public:
+    PollFinished(EnginioNotificationChannel *channel)
+        : _channel(channel)
+    {
+        Q_ASSERT(channel);
+    }
+
+    void operator ()()
+    {
+        _channel->pollFinished();
+    }
+};
+
+EnginioNotificationChannel::EnginioNotificationChannel(EnginioClientPrivate *client, const QString &objectType)
+    : _client(client)
+    , _objectType(objectType)
+    , _reply(0)
+    , _networkManager(-1)
+    , _reconnectDelay(MinReconnectDelay)
+    , _connected(false)
+    , _stopped(false)
+{
+    _reconnectTimer.setSingleShot(true);
+    QObject::connect(&_reconnectTimer, &QTimer::timeout, this, &EnginioNotificationChannel::poll);
+    poll();
+}
+
+EnginioNotificationChannel::~EnginioNotificationChannel()
+{
+    stop();
+}
+
+void EnginioNotificationChannel::stop()
+{
+    _stopped = true;
+    _reconnectTimer.stop();
+    if (_reply) {
+        QNetworkReply *reply = _reply;
+        _reply = 0; // pollFinished() ignores the aborted request
+        releaseNetworkManager();
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+void EnginioNotificationChannel::poll()
+{
+    if (_stopped)
+        return;
+    if (_client->_backendId.isEmpty() || _client->_backendSecret.isEmpty()) {
+        // the client is not configured yet
+        _reconnectTimer.start(_reconnectDelay);
+        return;
+    }
+
+    QUrl url(_client->_serviceUrl);
+    url.setPath(QStringLiteral("/v1/stream"));
+    QUrlQuery urlQuery;
+    urlQuery.addQueryItem(EnginioString::objectType, _objectType);
+    if (!_cursor.isEmpty())
+        urlQuery.addQueryItem(QStringLiteral("cursor"), _cursor);
+    url.setQuery(urlQuery);
+
+    QNetworkRequest req(_client->_request);
+    req.setUrl(url);
+    // the request stays open for long, it must not take a connection of the interactive requests
+    _networkManager = _client->chooseNetworkManager(EnginioClient::BackgroundPriority);
+    ++_client->_networkManagerLoad[_networkManager];
+    _reply = _client->_networkManagers[_networkManager]->get(req);
+    QObject::connect(_reply, &QNetworkReply::finished, PollFinished(this));
+}
+
+void EnginioNotificationChannel::pollFinished()
+{
+    QNetworkReply *reply = _reply;
+    _reply = 0;
+    if (!reply)
+        return;
+    releaseNetworkManager();
+    reply->deleteLater();
+
+    // a body which is not an answer of the stream, like a page of a proxy, counts as a failure too
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(reply->readAll(), &parseError);
+    if (reply->error() != QNetworkReply::NoError || parseError.error != QJsonParseError::NoError
+            || !document.isObject() || !document.object()[QStringLiteral("events")].isArray()) {
+        setConnected(false);
+        _reconnectTimer.start(_reconnectDelay);
+        _reconnectDelay = qMin(2 * _reconnectDelay, MaxReconnectDelay);
+        return;
+    }
+
+    const QJsonObject answer = document.object();
+    _reconnectDelay = MinReconnectDelay;
+    if (answer.contains(QStringLiteral("cursor")))
+        _cursor = answer[QStringLiteral("cursor")].toVariant().toString();
+    setConnected(true);
+
+    const QJsonArray events = answer[QStringLiteral("events")].toArray();
+    for (int i = 0; i < events.count(); ++i) {
+        const QJsonObject event = events.at(i).toObject();
+        emit notification(event[QStringLiteral("event")].toString(), event[EnginioString::object].toObject());
+    }
+
+    poll();
+}
+
+void EnginioNotificationChannel::releaseNetworkManager()
+{
+    if (_networkManager != -1)
+        --_client->_networkManagerLoad[_networkManager];
+    _networkManager = -1;
+}
+
+void EnginioNotificationChannel::setConnected(bool connected)
+{
+    if (_connected == connected)
+        return;
+    _connected = connected;
+    emit connectedChanged(connected);
+}
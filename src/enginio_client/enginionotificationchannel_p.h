@@ -0,0 +1,101 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://qt.digia.com/contact-us
+**
+** This file is part of the Enginio Qt Client Library.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+****************************************************************************/
+
+#ifndef ENGINIONOTIFICATIONCHANNEL_P_H
+#define ENGINIONOTIFICATIONCHANNEL_P_H
+
+#include "enginioclient_global.h"
+
+#include <QtCore/qobject.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qtimer.h>
+
+class EnginioClientPrivate;
+QT_BEGIN_NAMESPACE
+class QNetworkReply;
+QT_END_NAMESPACE
+
+/*
+  Long-polling subscription to changes of objects of a single objectType.
+
+  The channel keeps one request "GET /v1/stream?objectType=<type>&cursor=<cursor>" open.
+  The backend answers it as soon as there are changes newer than the cursor, or with an
+  empty list when it times out:
+
+    { "cursor": "<opaque>", "events": [ { "event": "create" | "update" | "delete", "object": {...} } ] }
+
+  The cursor of the answer is used for the next request, so no change is lost between them.
+  If a request fails the channel is disconnected and tries again with growing delays.
+  One channel per objectType is shared by all models of a client, see EnginioClientPrivate::subscribe().
+*/
+class EnginioNotificationChannel : public QObject
+{
+    Q_OBJECT
+public:
+    EnginioNotificationChannel(EnginioClientPrivate *client, const QString &objectType);
+    ~EnginioNotificationChannel();
+
+    QString objectType() const { return _objectType; }
+    bool isConnected() const { return _connected; }
+    void stop();
+
+Q_SIGNALS:
+    void connectedChanged(bool connected);
+    void notification(const QString &event, const QJsonObject &object);
+
+private:
+    class PollFinished;
+    friend class PollFinished;
+
+    void poll();
+    void pollFinished();
+    void releaseNetworkManager();
+    void setConnected(bool connected);
+
+    EnginioClientPrivate *_client;
+    QString _objectType;
+    QString _cursor;
+    QNetworkReply *_reply;
+    int _networkManager; // of the running request, it counts to the load of the manager
+    QTimer _reconnectTimer;
+    int _reconnectDelay;
+    bool _connected;
+    bool _stopped;
+};
+
+#endif // ENGINIONOTIFICATIONCHANNEL_P_H
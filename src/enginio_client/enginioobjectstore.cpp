@@ -0,0 +1,252 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://qt.digia.com/contact-us
+**
+** This file is part of the Enginio Qt Client Library.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+****************************************************************************/
+
+#include "enginioobjectstore_p.h"
+#include "enginioclient_p.h"
+
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qstringlist.h>
+
+namespace {
+const int MinPurgeThreshold = 1024;
+// longer strings are unlikely to repeat
+const int MaxInternedLength = 64;
+// the table is never shrunk, it stops growing instead
+const int MaxInternedStrings = 64 * 1024;
+}
+
+QString EnginioStringTable::intern(const QString &string)
+{
+    if (string.size() > MaxInternedLength)
+        return string;
+    QSet<QString>::const_iterator i = _strings.constFind(string);
+    if (i != _strings.constEnd())
+        return *i;
+    if (_strings.count() < MaxInternedStrings)
+        _strings.insert(string);
+    return string;
+}
+
+EnginioObjectKeysHandle EnginioStringTable::internKeys(const QJsonObject &object)
+{
+    const QStringList names = object.keys();
+    const QString shape = names.join(QChar(0));
+    QHash<QString, EnginioObjectKeysHandle>::const_iterator i = _keys.constFind(shape);
+    if (i != _keys.constEnd())
+        return *i;
+
+    QStringList interned;
+    interned.reserve(names.count());
+    foreach (const QString &name, names)
+        interned.append(intern(name));
+    EnginioObjectKeysHandle result = keys(interned);
+    if (_keys.count() < MaxInternedStrings)
+        _keys.insert(shape, result);
+    return result;
+}
+
+EnginioObjectKeysHandle EnginioStringTable::keys(const QStringList &names)
+{
+    EnginioObjectKeysHandle result(new EnginioObjectKeys);
+    result->names = names.toVector();
+    result->bytes = 0;
+    result->records = 0;
+    foreach (const QString &name, names)
+        result->bytes += name.size() * sizeof(QChar);
+    return result;
+}
+
+qint64 EnginioStringTable::bytesSaved() const
+{
+    // Without the table every record would have own keys, and every holder of a
+    // string its own copy. The holders are counted by the references to the string.
+    qint64 saved = 0;
+    for (QHash<QString, EnginioObjectKeysHandle>::const_iterator i = _keys.constBegin(); i != _keys.constEnd(); ++i)
+        saved += qint64(qMax(0, (*i)->records - 1)) * (*i)->bytes;
+    for (QSet<QString>::const_iterator i = _strings.constBegin(); i != _strings.constEnd(); ++i) {
+        QString::DataPtr data = const_cast<QString &>(*i).data_ptr();
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        const int references = data->ref.atomic.loadRelaxed();
+#else
+        const int references = data->ref.atomic.load();
+#endif
+        // one is the table, one copy would be needed anyway
+        saved += qint64(qMax(0, references - 2)) * i->size() * sizeof(QChar);
+    }
+    return saved;
+}
+
+void EnginioObjectRecord::setObject(const QJsonObject &object, EnginioStringTable *strings)
+{
+    if (_keys)
+        --_keys->records;
+    _keys = strings ? strings->internKeys(object) : EnginioStringTable::keys(object.keys());
+    ++_keys->records;
+    _values.resize(_keys->names.count());
+    int index = 0;
+    for (QJsonObject::const_iterator i = object.constBegin(); i != object.constEnd(); ++i, ++index) {
+        const QJsonValue value = i.value();
+        _values[index] = strings && value.isString() ? QJsonValue(strings->intern(value.toString())) : value;
+    }
+}
+
+QJsonObject EnginioObjectRecord::object() const
+{
+    QJsonObject object;
+    const QVector<QString> &names = _keys->names;
+    for (int i = 0; i < names.count(); ++i)
+        object.insert(names.at(i), _values.at(i));
+    return object;
+}
+
+QJsonValue EnginioObjectRecord::value(const QString &key) const
+{
+    const QVector<QString> &names = _keys->names;
+    QVector<QString>::const_iterator i = qBinaryFind(names.constBegin(), names.constEnd(), key);
+    if (i == names.constEnd())
+        return QJsonValue(QJsonValue::Undefined);
+    return _values.at(i - names.constBegin());
+}
+
+EnginioObjectStore::EnginioObjectStore()
+    : _purgeThreshold(MinPurgeThreshold)
+{}
+
+EnginioObjectHandle EnginioObjectStore::insert(const QJsonObject &object, bool force, bool partial, const void *origin)
+{
+    const QString id = object[EnginioString::id].toString();
+    const QString objectType = object[EnginioString::objectType].toString();
+    if (id.isEmpty() || objectType.isEmpty())
+        return EnginioObjectHandle(new EnginioObjectRecord(object, &_strings));
+
+    QWeakPointer<EnginioObjectRecord> &weakRecord = _records[objectType + QLatin1Char('/') + id];
+    EnginioObjectHandle record = weakRecord.toStrongRef();
+    if (!record) {
+        record = EnginioObjectHandle(new EnginioObjectRecord(object, &_strings));
+        weakRecord = record;
+        if (_records.count() > _purgeThreshold)
+            purge();
+        return record;
+    }
+
+    // timestamps are ISO 8601 strings, they can be compared as strings
+    const QString updatedAt = object[EnginioString::updatedAt].toString();
+    const QString storedUpdatedAt = record->value(EnginioString::updatedAt).toString();
+    if (!force && updatedAt < storedUpdatedAt)
+        return record; // the stored one is newer
+
+    const QJsonObject storedObject = record->object();
+    QJsonObject newObject(object);
+    if (!force && (partial || updatedAt == storedUpdatedAt)) {
+        newObject = storedObject;
+        for (QJsonObject::const_iterator i = object.constBegin(); i != object.constEnd(); ++i)
+            newObject.insert(i.key(), i.value());
+    }
+    if (storedObject == newObject)
+        return record;
+    record->setObject(newObject, &_strings);
+    emit recordChanged(record.data(), origin);
+    return record;
+}
+
+int EnginioObjectStore::count() const
+{
+    int count = 0;
+    foreach (const QWeakPointer<EnginioObjectRecord> &record, _records) {
+        if (!record.isNull())
+            ++count;
+    }
+    return count;
+}
+
+void EnginioObjectStore::purge()
+{
+    // records released by all models leave their keys behind, they are removed in batches
+    QHash<QString, QWeakPointer<EnginioObjectRecord> >::iterator i = _records.begin();
+    while (i != _records.end()) {
+        if (i->isNull())
+            i = _records.erase(i);
+        else
+            ++i;
+    }
+    _purgeThreshold = qMax(MinPurgeThreshold, 2 * _records.count());
+}
+
+void EnginioObjectRows::remove(int first, int count)
+{
+    for (int row = first; row < first + count; ++row) {
+        if (!_rows.at(row))
+            --_evicted;
+        setId(row, QJsonValue());
+    }
+    _rows.remove(first, count);
+    _ids.remove(first, count);
+    for (QHash<QString, int>::iterator i = _rowOfId.begin(); i != _rowOfId.end(); ++i) {
+        if (i.value() >= first + count)
+            i.value() -= count;
+    }
+}
+
+EnginioObjectRows &EnginioObjectRows::operator=(const QJsonArray &array)
+{
+    QVector<EnginioObjectHandle> rows;
+    rows.reserve(array.count());
+    for (int i = 0; i < array.count(); ++i)
+        rows.append(handle(array.at(i), false));
+    _rows.swap(rows);
+    _evicted = 0;
+    _ids.fill(QString(), _rows.count());
+    _rowOfId.clear();
+    _rowOfId.reserve(_rows.count());
+    for (int i = 0; i < array.count(); ++i)
+        setId(i, array.at(i));
+    return *this;
+}
+
+void EnginioObjectRows::setId(int row, const QJsonValue &value)
+{
+    const QString id = value.toObject()[EnginioString::id].toString();
+    QString &oldId = _ids[row];
+    if (oldId == id)
+        return;
+    // of rows sharing an id, which happens only for a moment, the one set last is found
+    if (!oldId.isEmpty() && _rowOfId.value(oldId, -1) == row)
+        _rowOfId.remove(oldId);
+    oldId = id;
+    if (!id.isEmpty())
+        _rowOfId.insert(id, row);
+}
@@ -0,0 +1,239 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://qt.digia.com/contact-us
+**
+** This file is part of the Enginio Qt Client Library.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+****************************************************************************/
+
+#ifndef ENGINIOOBJECTSTORE_P_H
+#define ENGINIOOBJECTSTORE_P_H
+
+#include "enginioclient_global.h"
+
+#include <QtCore/qobject.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qset.h>
+#include <QtCore/qsharedpointer.h>
+#include <QtCore/qstring.h>
+#include <QtCore/qstringlist.h>
+#include <QtCore/qvector.h>
+
+/*
+  Sorted property names, shared by the records of all objects with the same properties.
+*/
+struct EnginioObjectKeys
+{
+    QVector<QString> names;
+    int bytes;
+    int records; // which use them right now
+};
+
+typedef QSharedPointer<EnginioObjectKeys> EnginioObjectKeysHandle;
+
+/*
+  Per client table of strings which repeat in cached objects: property names, objectType
+  and short, enum-like values. Records keep references to the table entries instead of
+  own copies, so each such string is allocated once.
+*/
+class EnginioStringTable
+{
+public:
+    QString intern(const QString &string);
+    EnginioObjectKeysHandle internKeys(const QJsonObject &object);
+    static EnginioObjectKeysHandle keys(const QStringList &names);
+
+    int count() const { return _strings.count(); }
+    // memory which would be taken by own copies of the strings held by records right now
+    qint64 bytesSaved() const;
+
+private:
+    QSet<QString> _strings;
+    QHash<QString, EnginioObjectKeysHandle> _keys; // by keys joined with '\0'
+};
+
+/*
+  Cached object, stored as a vector of keys shared by all objects with the same
+  properties and a vector of values. String values are shared through the string table.
+*/
+class EnginioObjectRecord
+{
+public:
+    explicit EnginioObjectRecord(const QJsonObject &object, EnginioStringTable *strings = 0)
+    {
+        setObject(object, strings);
+    }
+    ~EnginioObjectRecord()
+    {
+        --_keys->records;
+    }
+
+    void setObject(const QJsonObject &object, EnginioStringTable *strings);
+    QJsonObject object() const;
+    QJsonValue value(const QString &key) const;
+
+private:
+    Q_DISABLE_COPY(EnginioObjectRecord)
+
+    EnginioObjectKeysHandle _keys;
+    QVector<QJsonValue> _values;
+};
+
+typedef QSharedPointer<EnginioObjectRecord> EnginioObjectHandle;
+
+/*
+  Identity map of objects fetched by a client, keyed by objectType and id.
+
+  Models keep handles to the records instead of own copies of the objects, so an
+  object shown by several models is stored once, and a change made through one of
+  them is visible in all. The store only keeps weak references, a record lives as long
+  as some model shows it.
+*/
+class EnginioObjectStore : public QObject
+{
+    Q_OBJECT
+public:
+    EnginioObjectStore();
+
+    // Returns the record of the object. A newer object, by updatedAt, or any object if force
+    // is true, replaces the content of the record. The same version of the object, or a newer
+    // one which is partial, fetched with only some of the properties, is merged into it, so
+    // the models showing the other properties do not lose them.
+    // Objects without id or objectType are not shared, they get a record of their own.
+    EnginioObjectHandle insert(const QJsonObject &object, bool force, bool partial, const void *origin);
+    int count() const;
+    const EnginioStringTable &strings() const { return _strings; }
+
+Q_SIGNALS:
+    // content of a shared record was replaced by the owner of origin
+    void recordChanged(const EnginioObjectRecord *record, const void *origin);
+
+private:
+    void purge();
+
+    QHash<QString, QWeakPointer<EnginioObjectRecord> > _records;
+    int _purgeThreshold;
+    EnginioStringTable _strings;
+};
+
+/*
+  Rows of a model, with the subset of the QJsonArray API used by EnginioModel.
+  A row can be evicted from memory, it keeps its slot but reads as an empty object.
+  The ids of all rows, evicted ones too, are indexed, so a row is found without a scan.
+*/
+class EnginioObjectRows
+{
+public:
+    EnginioObjectRows()
+        : _store(0)
+        , _evicted(0)
+        , _partial(false)
+    {}
+
+    // rows which are already stored keep their records
+    void setStore(EnginioObjectStore *store) { _store = store; }
+    // fetched objects may lack properties, they are merged into the shared records
+    void setPartial(bool partial) { _partial = partial; }
+
+    int count() const { return _rows.count(); }
+    bool isEmpty() const { return _rows.isEmpty(); }
+    QJsonValue at(int row) const
+    {
+        const EnginioObjectHandle &record = _rows.at(row);
+        return record ? record->object() : QJsonObject();
+    }
+    QJsonValue value(int row, const QString &key) const
+    {
+        const EnginioObjectHandle &record = _rows.at(row);
+        return record ? record->value(key) : QJsonValue(QJsonValue::Undefined);
+    }
+    QJsonValue first() const { return at(0); }
+    const EnginioObjectRecord *record(int row) const { return _rows.at(row).data(); }
+    int rowOfId(const QString &id) const { return id.isEmpty() ? -1 : _rowOfId.value(id, -1); }
+    QString id(int row) const { return _ids.at(row); }
+
+    void append(const QJsonValue &value)
+    {
+        _rows.append(handle(value, false));
+        _ids.append(QString());
+        setId(_rows.count() - 1, value);
+    }
+    void replace(int row, const QJsonValue &value)
+    {
+        if (!_rows.at(row))
+            --_evicted;
+        _rows[row] = handle(value, true);
+        setId(row, value);
+    }
+    void remove(int first, int count);
+
+    bool isResident(int row) const { return !_rows.at(row).isNull(); }
+    bool hasEvictedRows() const { return _evicted > 0; }
+    void evict(int row)
+    {
+        if (!_rows.at(row))
+            return;
+        _rows[row].clear();
+        ++_evicted;
+    }
+    void refresh(int row, const QJsonValue &value)
+    {
+        // a fetched object does not overwrite a newer one shown by another model
+        if (!_rows.at(row))
+            --_evicted;
+        _rows[row] = handle(value, false);
+        setId(row, value);
+    }
+
+    EnginioObjectRows &operator=(const QJsonArray &array);
+
+private:
+    void setId(int row, const QJsonValue &value);
+
+    EnginioObjectHandle handle(const QJsonValue &value, bool force) const
+    {
+        if (_store)
+            return _store->insert(value.toObject(), force, _partial, this);
+        return EnginioObjectHandle(new EnginioObjectRecord(value.toObject()));
+    }
+
+    EnginioObjectStore *_store;
+    QVector<EnginioObjectHandle> _rows;
+    int _evicted;
+    bool _partial;
+    QVector<QString> _ids; // kept for evicted rows
+    QHash<QString, int> _rowOfId;
+};
+
+#endif // ENGINIOOBJECTSTORE_P_H
@@ -45,6 +45,7 @@
 #include "enginioclient.h"
 #include "enginioclient_p.h"
 #include "enginioobjectadaptor_p.h"
+#include "enginiorequestgroup.h"
 
 /*!
   \class EnginioReply
@@ -78,6 +79,16 @@
   The \a bytesSent is the current progress relative to the total \a bytesTotal.
 */
 
+struct DeadlineFunctor
+{
+    EnginioClientPrivate *_client;
+    EnginioReply *_reply;
+    void operator ()()
+    {
+        _client->finishEarly(_reply, QNetworkReply::TimeoutError, QByteArrayLiteral("EnginioReply: The request did not finish within its timeout"));
+    }
+};
+
 /*!
   \internal
 */
@@ -86,6 +97,10 @@ EnginioReply::EnginioReply(EnginioClientPrivate *p, QNetworkReply *reply)
     , d(new EnginioReplyPrivate(p, reply))
 {
     p->registerReply(reply, this);
+    if (p->_requestTimeout)
+        setTimeout(p->_requestTimeout);
+    if (p->_requestGroup)
+        p->_requestGroup->add(this);
 }
 
 /*!
@@ -97,6 +112,10 @@ EnginioReply::EnginioReply(EnginioClientPrivate *parent, QNetworkReply *reply, E
 {
     parent->registerReply(reply, this);
     reply->setParent(this);
+    if (parent->_requestTimeout)
+        setTimeout(parent->_requestTimeout);
+    if (parent->_requestGroup)
+        parent->_requestGroup->add(this);
 }
 
 
@@ -165,6 +184,61 @@ void EnginioReply::setNetworkReply(QNetworkReply *reply)
     d->_client->registerReply(reply, this);
 }
 
+void EnginioReply::stopDeadline()
+{
+    if (d->_deadline)
+        d->_deadline->stop();
+}
+
+/*!
+  \property EnginioReply::timeout
+  \brief The time in milliseconds, counted from the start of the request, within which it has to finish.
+
+  When the timeout expires the request is aborted and the reply finishes with
+  the network error QNetworkReply::TimeoutError. Retries of the request and all
+  chunks of a file upload have to finish within the same timeout.
+  The default value is EnginioClient::requestTimeout, 0 means no timeout.
+  \sa abort()
+*/
+int EnginioReply::timeout() const
+{
+    return d->_timeout;
+}
+
+void EnginioReply::setTimeout(int msecs)
+{
+    msecs = qMax(0, msecs);
+    if (d->_timeout == msecs)
+        return;
+    d->_timeout = msecs;
+    if (!msecs) {
+        delete d->_deadline;
+        d->_deadline = 0;
+    } else {
+        if (!d->_deadline) {
+            d->_deadline = new QTimer(this);
+            d->_deadline->setSingleShot(true);
+            DeadlineFunctor deadline = {d->_client, this};
+            QObject::connect(d->_deadline, &QTimer::timeout, deadline);
+        }
+        d->_deadline->start(qMax(qint64(0), d->_createdAt + msecs - d->_client->_clock.elapsed()));
+    }
+    emit timeoutChanged(msecs);
+}
+
+/*!
+  \brief Abort the request.
+
+  The reply finishes with the network error QNetworkReply::OperationCanceledError,
+  unless it was already finished. The request is removed from the queue of the client,
+  or its connection is closed if it was sent already.
+  \sa timeout
+*/
+void EnginioReply::abort()
+{
+    d->_client->finishEarly(this, QNetworkReply::OperationCanceledError, QByteArrayLiteral("EnginioReply: The request was aborted"));
+}
+
 void EnginioReply::dumpDebugInfo() const
 {
     d->dumpDebugInfo();
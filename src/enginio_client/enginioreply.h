@@ -68,6 +68,7 @@ public:
     Q_PROPERTY(QNetworkReply::NetworkError networkError READ networkError NOTIFY errorChanged)
     Q_PROPERTY(QString errorString READ errorString NOTIFY errorChanged)
     Q_PROPERTY(int backendStatus READ backendStatus NOTIFY errorChanged)
+    Q_PROPERTY(int timeout READ timeout WRITE setTimeout NOTIFY timeoutChanged)
 
     explicit EnginioReply(EnginioClientPrivate *parent, QNetworkReply *reply);
     virtual ~EnginioReply();
@@ -80,6 +81,10 @@ public:
 
     bool isError() const;
 
+    int timeout() const;
+    void setTimeout(int msecs);
+    Q_INVOKABLE void abort();
+
     Q_SLOT void dumpDebugInfo() const;
 
 Q_SIGNALS:
@@ -87,6 +92,7 @@ Q_SIGNALS:
     void dataChanged();
     void errorChanged();
     void progress(qint64 bytesSent, qint64 bytesTotal);
+    void timeoutChanged(int msecs);
 
 protected:
     explicit EnginioReply(EnginioClientPrivate *parent, QNetworkReply *reply, EnginioReplyPrivate *priv);
@@ -96,9 +102,11 @@ protected:
 private:
     Q_DISABLE_COPY(EnginioReply)
     void setNetworkReply(QNetworkReply *reply);
+    void stopDeadline();
 
     friend class EnginioClient;
     friend class EnginioClientPrivate;
+    friend class EnginioRequestGroupPrivate;
 };
 
 Q_DECLARE_TYPEINFO(const EnginioReply*, Q_PRIMITIVE_TYPE);
@@ -42,6 +42,7 @@
 #include <QtCore/qstring.h>
 #include <QtCore/qjsonobject.h>
 #include <QtCore/qjsondocument.h>
+#include <QtCore/qtimer.h>
 #include <QtNetwork/qnetworkreply.h>
 
 #include "enginioclient_p.h"
@@ -52,9 +53,15 @@ public:
     EnginioClientPrivate *_client;
     QNetworkReply *_nreply;
     mutable QJsonObject _data;
+    QTimer *_deadline;
+    int _timeout;
+    qint64 _createdAt;
     EnginioReplyPrivate(EnginioClientPrivate *p, QNetworkReply *reply)
         : _client(p)
         , _nreply(reply)
+        , _deadline(0)
+        , _timeout(0)
+        , _createdAt(p->_clock.elapsed())
     {
         Q_ASSERT(reply);
     }
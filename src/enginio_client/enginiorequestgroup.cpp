@@ -0,0 +1,302 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://qt.digia.com/contact-us
+**
+** This file is part of the Enginio Qt Client Library.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+****************************************************************************/
+
+
+#include "enginiorequestgroup.h"
+#include "enginioclient.h"
+#include "enginioclient_p.h"
+#include "enginioreply.h"
+#include "enginioreply_p.h"
+
+#include <QtCore/qhash.h>
+
+class EnginioRequestGroupPrivate {
+public:
+    struct Member
+    {
+        qint64 bytesDone;
+        qint64 bytesTotal;
+        QMetaObject::Connection progressConnection;
+        QMetaObject::Connection destroyedConnection;
+
+        Member()
+            : bytesDone(0)
+            , bytesTotal(0)
+        {}
+    };
+
+    class ProgressFunctor
+    {
+        EnginioRequestGroupPrivate *d;
+        EnginioReply *_reply;
+    public:
+        ProgressFunctor(EnginioRequestGroupPrivate *group, EnginioReply *reply)
+            : d(group)
+            , _reply(reply)
+        {}
+        void operator ()(qint64 bytesDone, qint64 bytesTotal)
+        {
+            d->setProgress(_reply, bytesDone, bytesTotal);
+        }
+    };
+
+    class MemberDestroyedFunctor
+    {
+        EnginioRequestGroupPrivate *d;
+        EnginioReply *_reply;
+    public:
+        MemberDestroyedFunctor(EnginioRequestGroupPrivate *group, EnginioReply *reply)
+            : d(group)
+            , _reply(reply)
+        {}
+        void operator ()()
+        {
+            d->memberFinished(_reply);
+        }
+    };
+
+    class ClientFinishedFunctor
+    {
+        EnginioRequestGroupPrivate *d;
+    public:
+        ClientFinishedFunctor(EnginioRequestGroupPrivate *group)
+            : d(group)
+        {}
+        void operator ()(EnginioReply *reply)
+        {
+            d->memberFinished(reply);
+        }
+    };
+
+    EnginioRequestGroup *q;
+    QHash<EnginioReply*, Member> _members; // the unfinished ones
+    QHash<EnginioClient*, QMetaObject::Connection> _clients;
+    int _count;
+    int _finishedCount;
+    qint64 _finishedBytes;
+
+    EnginioRequestGroupPrivate(EnginioRequestGroup *group)
+        : q(group)
+        , _count(0)
+        , _finishedCount(0)
+        , _finishedBytes(0)
+    {}
+
+    ~EnginioRequestGroupPrivate()
+    {
+        foreach (const Member &member, _members) {
+            QObject::disconnect(member.progressConnection);
+            QObject::disconnect(member.destroyedConnection);
+        }
+        foreach (const QMetaObject::Connection &connection, _clients)
+            QObject::disconnect(connection);
+    }
+
+    void add(EnginioReply *reply)
+    {
+        EnginioClientPrivate *client = reply->d->_client;
+        if (_members.contains(reply) || !client->isPending(reply))
+            return;
+
+        if (_members.isEmpty()) {
+            // a new batch of requests
+            _count = 0;
+            _finishedBytes = 0;
+            if (_finishedCount) {
+                _finishedCount = 0;
+                emit q->finishedCountChanged(0);
+            }
+            emit q->activeChanged(true);
+        }
+
+        EnginioClient *enginio = static_cast<EnginioClient*>(client->q_ptr);
+        if (!_clients.value(enginio))
+            _clients.insert(enginio, QObject::connect(enginio, &EnginioClient::finished, ClientFinishedFunctor(this)));
+
+        Member &member = _members[reply];
+        member.progressConnection = QObject::connect(reply, &EnginioReply::progress, ProgressFunctor(this, reply));
+        member.destroyedConnection = QObject::connect(reply, &QObject::destroyed, MemberDestroyedFunctor(this, reply));
+        emit q->countChanged(++_count);
+    }
+
+    void memberFinished(EnginioReply *reply)
+    {
+        QHash<EnginioReply*, Member>::iterator i = _members.find(reply);
+        if (i == _members.end())
+            return;
+        QObject::disconnect(i->progressConnection);
+        QObject::disconnect(i->destroyedConnection);
+        _finishedBytes += i->bytesTotal;
+        _members.erase(i);
+
+        emit q->finishedCountChanged(++_finishedCount);
+        emitProgress();
+        if (_members.isEmpty()) {
+            emit q->activeChanged(false);
+            emit q->finished();
+        }
+    }
+
+    void setProgress(EnginioReply *reply, qint64 bytesDone, qint64 bytesTotal)
+    {
+        QHash<EnginioReply*, Member>::iterator i = _members.find(reply);
+        if (i == _members.end())
+            return;
+        i->bytesDone = bytesDone;
+        i->bytesTotal = bytesTotal;
+        emitProgress();
+    }
+
+    void emitProgress()
+    {
+        // finished members count as completely transferred
+        qint64 done = _finishedBytes;
+        qint64 total = _finishedBytes;
+        foreach (const Member &member, _members) {
+            done += member.bytesDone;
+            total += member.bytesTotal;
+        }
+        if (total)
+            emit q->progress(done, total);
+    }
+};
+
+/*!
+  \class EnginioRequestGroup
+  \inmodule enginio-qt
+  \ingroup enginio-client
+  \brief EnginioRequestGroup tracks a set of requests which belong together.
+
+  Requests are added to a group with \l add(), or implicitly by setting the group as
+  EnginioClient::requestGroup while they are made. That includes the requests an
+  EnginioModel sends for a client. When a screen is left, \l cancelAll() aborts all
+  requests of the group which are still queued or in flight.
+
+  The \l finished() signal is emitted when the last unfinished request of the group
+  finished. Requests added after that start a new batch, \l count and \l finishedCount
+  only cover the current batch. The \l progress() signal combines the progress of the
+  file transfers in the group.
+
+  \sa EnginioReply::abort()
+*/
+
+/*!
+  \qmltype EnginioRequestGroup
+  \instantiates EnginioRequestGroup
+  \inqmlmodule Enginio 1
+  \ingroup engino-qml
+  \brief Tracks and cancels a set of requests which belong together.
+
+  Assign the group to \l {Enginio1::Enginio::requestGroup}{Enginio.requestGroup}
+  to add all requests made while it is set, or add single replies with \c add().
+  \c cancelAll() aborts all unfinished requests of the group.
+*/
+
+/*!
+  \fn EnginioRequestGroup::finished()
+  This signal is emitted when all requests of the group finished.
+*/
+
+/*!
+  \fn EnginioRequestGroup::progress(qint64 bytesDone, qint64 bytesTotal)
+  This signal is emitted when a file transfer of the group progressed. \a bytesDone is the
+  sum of the transferred bytes of all transfers in the current batch, relative to \a bytesTotal.
+*/
+
+/*!
+    Constructs a new request group with \a parent as QObject parent.
+*/
+EnginioRequestGroup::EnginioRequestGroup(QObject *parent)
+    : QObject(parent)
+    , d(new EnginioRequestGroupPrivate(this))
+{}
+
+/*!
+    Destroys the group, its requests are not affected.
+*/
+EnginioRequestGroup::~EnginioRequestGroup()
+{}
+
+/*!
+  \property EnginioRequestGroup::count
+  \brief The number of requests in the current batch.
+*/
+int EnginioRequestGroup::count() const
+{
+    return d->_count;
+}
+
+/*!
+  \property EnginioRequestGroup::finishedCount
+  \brief The number of finished requests in the current batch.
+*/
+int EnginioRequestGroup::finishedCount() const
+{
+    return d->_finishedCount;
+}
+
+/*!
+  \property EnginioRequestGroup::active
+  \brief Whether some requests of the group are not finished.
+*/
+bool EnginioRequestGroup::isActive() const
+{
+    return !d->_members.isEmpty();
+}
+
+/*!
+  \brief Add the \a reply to the group.
+
+  Replies which are finished already are ignored.
+*/
+void EnginioRequestGroup::add(EnginioReply *reply)
+{
+    if (reply)
+        d->add(reply);
+}
+
+/*!
+  \brief Abort all unfinished requests of the group.
+
+  The replies finish with QNetworkReply::OperationCanceledError, afterwards
+  \l finished() is emitted.
+*/
+void EnginioRequestGroup::cancelAll()
+{
+    foreach (EnginioReply *reply, d->_members.keys())
+        reply->abort();
+}
@@ -0,0 +1,80 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://qt.digia.com/contact-us
+**
+** This file is part of the Enginio Qt Client Library.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+****************************************************************************/
+
+
+#ifndef ENGINIOREQUESTGROUP_H
+#define ENGINIOREQUESTGROUP_H
+
+#include <QtCore/qobject.h>
+#include <QtCore/qscopedpointer.h>
+
+#include "enginioclient_global.h"
+
+class EnginioReply;
+class EnginioRequestGroupPrivate;
+class ENGINIOCLIENT_EXPORT EnginioRequestGroup : public QObject
+{
+    Q_OBJECT
+public:
+    explicit EnginioRequestGroup(QObject *parent = 0);
+    ~EnginioRequestGroup();
+
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(int finishedCount READ finishedCount NOTIFY finishedCountChanged)
+    Q_PROPERTY(bool active READ isActive NOTIFY activeChanged)
+
+    int count() const;
+    int finishedCount() const;
+    bool isActive() const;
+
+    Q_INVOKABLE void add(EnginioReply *reply);
+    Q_INVOKABLE void cancelAll();
+
+Q_SIGNALS:
+    void finished();
+    void progress(qint64 bytesDone, qint64 bytesTotal);
+    void countChanged(int count);
+    void finishedCountChanged(int count);
+    void activeChanged(bool active);
+
+private:
+    Q_DISABLE_COPY(EnginioRequestGroup)
+    QScopedPointer<EnginioRequestGroupPrivate> d;
+    friend class EnginioRequestGroupPrivate;
+};
+
+#endif // ENGINIOREQUESTGROUP_H
@@ -0,0 +1,884 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://qt.digia.com/contact-us
+**
+** This file is part of the Enginio Qt Client Library.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+****************************************************************************/
+
+
+#include "enginiosortfilterproxymodel.h"
+#include "enginiomodel.h"
+
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qbitarray.h>
+#include <QtCore/qhash.h>
+#include <QtCore/qjsonvalue.h>
+#include <QtCore/qvector.h>
+
+class EnginioSortFilterProxyModelPrivate {
+    EnginioSortFilterProxyModel *q;
+    QAbstractItemModel *_source;
+    EnginioModel *_enginioSource; // read without fetching the rows which are not in memory
+    QVector<QMetaObject::Connection> _connections;
+    QString _sortProperty;
+    Qt::SortOrder _sortOrder;
+    QJsonObject _filter;
+
+    // Changes of more rows at once are not applied one by one, the indexes are built again.
+    const static int MaxIncrementalRows;
+
+    struct SortKey
+    {
+        enum Type { Undefined, Bool, Number, String, Composed };
+        int type;
+        double number;
+        QString string;
+
+        SortKey()
+            : type(Undefined)
+            , number(0)
+        {}
+
+        bool operator <(const SortKey &other) const
+        {
+            if (type != other.type)
+                return type < other.type;
+            if (type == String)
+                return string < other.string;
+            return number < other.number;
+        }
+    };
+
+    // Source rows ordered by the value of a property, equal values by the row. Indexes of
+    // all properties used for sorting are kept up to date, switching between them is cheap.
+    struct SortIndex
+    {
+        int role;
+        QVector<SortKey> keys; // by source row
+        QVector<int> rows; // ascending
+    };
+    QHash<QString, SortIndex> _sortIndexes;
+
+    class KeyLessThan
+    {
+        const QVector<SortKey> &keys;
+    public:
+        KeyLessThan(const QVector<SortKey> &k)
+            : keys(k)
+        {}
+
+        bool operator ()(int left, int right) const
+        {
+            const SortKey &leftKey = keys.at(left);
+            const SortKey &rightKey = keys.at(right);
+            if (leftKey < rightKey)
+                return true;
+            if (rightKey < leftKey)
+                return false;
+            return left < right;
+        }
+    };
+
+    // One bit per source row for each condition of the filter
+    struct FilterIndex
+    {
+        QString property;
+        QJsonValue value;
+        int role;
+        QBitArray matches;
+    };
+    QVector<FilterIndex> _filters;
+
+    QVector<int> _proxyToSource;
+    QVector<int> _sourceToProxy; // -1 for filtered out rows
+    bool _resetting;
+
+    class ResetSlot
+    {
+        EnginioSortFilterProxyModelPrivate *model;
+        void (EnginioSortFilterProxyModelPrivate::*slot)();
+    public:
+        ResetSlot(EnginioSortFilterProxyModelPrivate *m, void (EnginioSortFilterProxyModelPrivate::*s)())
+            : model(m)
+            , slot(s)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()()
+        {
+            (model->*slot)();
+        }
+    };
+
+    class RowsSlot
+    {
+        EnginioSortFilterProxyModelPrivate *model;
+        void (EnginioSortFilterProxyModelPrivate::*slot)(int, int);
+    public:
+        RowsSlot(EnginioSortFilterProxyModelPrivate *m, void (EnginioSortFilterProxyModelPrivate::*s)(int, int))
+            : model(m)
+            , slot(s)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()(const QModelIndex &parent, int first, int last)
+        {
+            if (!parent.isValid())
+                (model->*slot)(first, last);
+        }
+    };
+
+    class SourceDataChanged
+    {
+        EnginioSortFilterProxyModelPrivate *model;
+    public:
+        SourceDataChanged(EnginioSortFilterProxyModelPrivate *m)
+            : model(m)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+        {
+            model->sourceDataChanged(topLeft, bottomRight, roles);
+        }
+    };
+
+public:
+    EnginioSortFilterProxyModelPrivate(EnginioSortFilterProxyModel *q_ptr)
+        : q(q_ptr)
+        , _source(0)
+        , _enginioSource(0)
+        , _sortOrder(Qt::AscendingOrder)
+        , _resetting(false)
+    {}
+
+    ~EnginioSortFilterProxyModelPrivate()
+    {
+        foreach (const QMetaObject::Connection &connection, _connections)
+            QObject::disconnect(connection);
+    }
+
+    int rowCount() const
+    {
+        return _proxyToSource.count();
+    }
+
+    int sourceRow(int proxyRow) const
+    {
+        return _proxyToSource.at(proxyRow);
+    }
+
+    int proxyRow(int sourceRow) const
+    {
+        return _sourceToProxy.value(sourceRow, -1);
+    }
+
+    void setSource(QAbstractItemModel *source)
+    {
+        foreach (const QMetaObject::Connection &connection, _connections)
+            QObject::disconnect(connection);
+        _connections.clear();
+        _source = source;
+        _enginioSource = qobject_cast<EnginioModel*>(source);
+        clearIndexes();
+        if (_source) {
+            typedef EnginioSortFilterProxyModelPrivate P;
+            _connections.append(QObject::connect(_source, &QAbstractItemModel::modelAboutToBeReset, ResetSlot(this, &P::sourceAboutToBeReset)));
+            _connections.append(QObject::connect(_source, &QAbstractItemModel::modelReset, ResetSlot(this, &P::sourceReset)));
+            _connections.append(QObject::connect(_source, &QAbstractItemModel::layoutAboutToBeChanged, ResetSlot(this, &P::sourceAboutToBeReset)));
+            _connections.append(QObject::connect(_source, &QAbstractItemModel::layoutChanged, ResetSlot(this, &P::sourceReset)));
+            _connections.append(QObject::connect(_source, &QAbstractItemModel::rowsInserted, RowsSlot(this, &P::sourceRowsInserted)));
+            _connections.append(QObject::connect(_source, &QAbstractItemModel::rowsAboutToBeRemoved, RowsSlot(this, &P::sourceRowsAboutToBeRemoved)));
+            _connections.append(QObject::connect(_source, &QAbstractItemModel::rowsRemoved, RowsSlot(this, &P::sourceRowsRemoved)));
+            _connections.append(QObject::connect(_source, &QAbstractItemModel::dataChanged, SourceDataChanged(this)));
+        }
+        rebuildMapping();
+    }
+
+    QString sortProperty() const
+    {
+        return _sortProperty;
+    }
+
+    void setSortProperty(const QString &property)
+    {
+        _sortProperty = property;
+        resort();
+        emit q->sortPropertyChanged(property);
+    }
+
+    Qt::SortOrder sortOrder() const
+    {
+        return _sortOrder;
+    }
+
+    void setSortOrder(Qt::SortOrder order)
+    {
+        _sortOrder = order;
+        resort();
+        emit q->sortOrderChanged(order);
+    }
+
+    QJsonObject filter() const
+    {
+        return _filter;
+    }
+
+    void setFilter(const QJsonObject &filter)
+    {
+        _filter = filter;
+        QVector<FilterIndex> filters;
+        for (QJsonObject::const_iterator i = filter.constBegin(); i != filter.constEnd(); ++i) {
+            int cached = -1;
+            for (int j = 0; j < _filters.count() && cached == -1; ++j) {
+                if (_filters.at(j).property == i.key() && _filters.at(j).value == i.value())
+                    cached = j;
+            }
+            if (cached != -1) {
+                filters.append(_filters.at(cached));
+            } else {
+                FilterIndex index;
+                index.property = i.key();
+                index.value = i.value();
+                index.role = roleOf(i.key());
+                buildFilterIndex(index);
+                filters.append(index);
+            }
+        }
+        _filters.swap(filters);
+
+        // the order stays, rows which do not match anymore leave, then the new ones come in
+        int last = _proxyToSource.count() - 1;
+        while (last >= 0) {
+            if (isAccepted(_proxyToSource.at(last))) {
+                --last;
+                continue;
+            }
+            int first = last;
+            while (first > 0 && !isAccepted(_proxyToSource.at(first - 1)))
+                --first;
+            removeProxyRows(first, last);
+            last = first - 1;
+        }
+        const QVector<int> accepted = acceptedRows();
+        int i = 0;
+        while (i < accepted.count()) {
+            if (_sourceToProxy.at(accepted.at(i)) != -1) {
+                ++i;
+                continue;
+            }
+            const int position = i;
+            QVector<int> rows;
+            while (i < accepted.count() && _sourceToProxy.at(accepted.at(i)) == -1)
+                rows.append(accepted.at(i++));
+            insertProxyRows(position, rows);
+        }
+        emit q->filterChanged(filter);
+    }
+
+private:
+    int sourceCount() const
+    {
+        return _source ? _source->rowCount() : 0;
+    }
+
+    int roleOf(const QString &property) const
+    {
+        if (!_source || property.isEmpty())
+            return -1;
+        return _source->roleNames().key(property.toUtf8(), -1);
+    }
+
+    QVariant sourceData(int row, int role) const
+    {
+        // data() of EnginioModel would fetch evicted rows again
+        if (_enginioSource)
+            return _enginioSource->cachedData(row, role);
+        return _source->data(_source->index(row, 0), role);
+    }
+
+    static QJsonValue jsonValue(const QVariant &variant)
+    {
+        // EnginioModel returns QJsonValues unless its roles are typed
+        if (variant.userType() == QMetaType::QJsonValue)
+            return variant.value<QJsonValue>();
+        return QJsonValue::fromVariant(variant);
+    }
+
+    static SortKey sortKey(const QVariant &variant)
+    {
+        const QJsonValue value = jsonValue(variant);
+        SortKey key;
+        switch (value.type()) {
+        case QJsonValue::Bool:
+            key.type = SortKey::Bool;
+            key.number = value.toBool();
+            break;
+        case QJsonValue::Double:
+            key.type = SortKey::Number;
+            key.number = value.toDouble();
+            break;
+        case QJsonValue::String:
+            key.type = SortKey::String;
+            key.string = value.toString();
+            break;
+        case QJsonValue::Array:
+        case QJsonValue::Object:
+            key.type = SortKey::Composed;
+            break;
+        default:
+            break;
+        }
+        return key;
+    }
+
+    void clearIndexes()
+    {
+        _sortIndexes.clear();
+        for (int i = 0; i < _filters.count(); ++i) {
+            _filters[i].role = roleOf(_filters.at(i).property);
+            buildFilterIndex(_filters[i]);
+        }
+    }
+
+    void buildFilterIndex(FilterIndex &index) const
+    {
+        const int count = sourceCount();
+        index.matches = QBitArray(count);
+        if (index.role == -1)
+            return; // no row has the property
+        for (int row = 0; row < count; ++row)
+            index.matches.setBit(row, jsonValue(sourceData(row, index.role)) == index.value);
+    }
+
+    SortIndex *activeSortIndex()
+    {
+        if (_sortProperty.isEmpty() || !_source)
+            return 0;
+        QHash<QString, SortIndex>::iterator i = _sortIndexes.find(_sortProperty);
+        if (i == _sortIndexes.end()) {
+            SortIndex index;
+            index.role = roleOf(_sortProperty);
+            const int count = sourceCount();
+            index.keys.resize(count);
+            index.rows.resize(count);
+            for (int row = 0; row < count; ++row) {
+                if (index.role != -1)
+                    index.keys[row] = sortKey(sourceData(row, index.role));
+                index.rows[row] = row;
+            }
+            qSort(index.rows.begin(), index.rows.end(), KeyLessThan(index.keys));
+            i = _sortIndexes.insert(_sortProperty, index);
+        }
+        return &i.value();
+    }
+
+    bool isAccepted(int sourceRow) const
+    {
+        for (int i = 0; i < _filters.count(); ++i) {
+            if (!_filters.at(i).matches.testBit(sourceRow))
+                return false;
+        }
+        return true;
+    }
+
+    // the order of the proxy, descending is the exact reverse of ascending
+    bool lessThan(const SortIndex *index, int left, int right) const
+    {
+        if (!index)
+            return left < right;
+        if (_sortOrder == Qt::DescendingOrder)
+            qSwap(left, right);
+        return KeyLessThan(index->keys)(left, right);
+    }
+
+    // the position of sourceRow among the proxy rows, not counting the one at skippedRow
+    int insertPosition(const SortIndex *index, int sourceRow, int skippedRow = -1) const
+    {
+        int begin = 0;
+        int end = _proxyToSource.count() - (skippedRow == -1 ? 0 : 1);
+        while (begin < end) {
+            const int middle = (begin + end) / 2;
+            const int row = _proxyToSource.at(skippedRow != -1 && middle >= skippedRow ? middle + 1 : middle);
+            if (lessThan(index, row, sourceRow))
+                begin = middle + 1;
+            else
+                end = middle;
+        }
+        return begin;
+    }
+
+    // the proxy positions of the rows from position on, after rows were inserted or removed before them
+    void renumber(int position)
+    {
+        for (int i = position; i < _proxyToSource.count(); ++i)
+            _sourceToProxy[_proxyToSource.at(i)] = i;
+    }
+
+    void insertProxyRows(int position, const QVector<int> &rows)
+    {
+        q->beginInsertRows(QModelIndex(), position, position + rows.count() - 1);
+        _proxyToSource.insert(position, rows.count(), -1);
+        for (int i = 0; i < rows.count(); ++i)
+            _proxyToSource[position + i] = rows.at(i);
+        renumber(position);
+        q->endInsertRows();
+    }
+
+    void removeProxyRows(int first, int last)
+    {
+        q->beginRemoveRows(QModelIndex(), first, last);
+        for (int i = first; i <= last; ++i)
+            _sourceToProxy[_proxyToSource.at(i)] = -1;
+        _proxyToSource.remove(first, last - first + 1);
+        renumber(first);
+        q->endRemoveRows();
+    }
+
+    // the source rows which pass the filter, in the order of the proxy
+    QVector<int> acceptedRows()
+    {
+        const int count = sourceCount();
+        QVector<int> rows;
+        rows.reserve(count);
+        const SortIndex *index = activeSortIndex();
+        for (int i = 0; i < count; ++i) {
+            int row = i;
+            if (index)
+                row = index->rows.at(_sortOrder == Qt::AscendingOrder ? i : count - 1 - i);
+            if (isAccepted(row))
+                rows.append(row);
+        }
+        return rows;
+    }
+
+    void rebuildMapping()
+    {
+        _proxyToSource = acceptedRows();
+        _sourceToProxy.fill(-1, sourceCount());
+        renumber(0);
+    }
+
+    void resort()
+    {
+        // the same rows in another order, persistent indexes follow their rows
+        emit q->layoutAboutToBeChanged();
+        const QModelIndexList from = q->persistentIndexList();
+        QVector<int> sourceRows;
+        sourceRows.reserve(from.count());
+        foreach (const QModelIndex &index, from)
+            sourceRows.append(sourceRow(index.row()));
+
+        rebuildMapping();
+
+        QModelIndexList to;
+        to.reserve(from.count());
+        for (int i = 0; i < from.count(); ++i)
+            to.append(q->index(proxyRow(sourceRows.at(i)), from.at(i).column()));
+        q->changePersistentIndexList(from, to);
+        emit q->layoutChanged();
+    }
+
+    void sourceAboutToBeReset()
+    {
+        if (!_resetting)
+            q->beginResetModel();
+        _resetting = true;
+    }
+
+    void sourceReset()
+    {
+        // roles may have changed too
+        clearIndexes();
+        rebuildMapping();
+        if (_resetting)
+            q->endResetModel();
+        _resetting = false;
+    }
+
+    void sourceRowsInserted(int first, int last)
+    {
+        const int count = last - first + 1;
+        if (count > MaxIncrementalRows) {
+            q->beginResetModel();
+            clearIndexes();
+            rebuildMapping();
+            q->endResetModel();
+            return;
+        }
+
+        // shift the rows after the inserted ones, then put the new rows into place
+        for (QHash<QString, SortIndex>::iterator i = _sortIndexes.begin(); i != _sortIndexes.end(); ++i) {
+            SortIndex &index = i.value();
+            for (int j = 0; j < index.rows.count(); ++j) {
+                if (index.rows.at(j) >= first)
+                    index.rows[j] += count;
+            }
+            index.keys.insert(first, count, SortKey());
+            for (int row = first; row <= last; ++row) {
+                if (index.role != -1)
+                    index.keys[row] = sortKey(sourceData(row, index.role));
+                index.rows.insert(qLowerBound(index.rows.begin(), index.rows.end(), row, KeyLessThan(index.keys)), row);
+            }
+        }
+        for (int i = 0; i < _filters.count(); ++i) {
+            FilterIndex &filter = _filters[i];
+            QBitArray matches(filter.matches.size() + count);
+            for (int row = 0; row < filter.matches.size(); ++row)
+                matches.setBit(row < first ? row : row + count, filter.matches.testBit(row));
+            for (int row = first; row <= last && filter.role != -1; ++row)
+                matches.setBit(row, jsonValue(sourceData(row, filter.role)) == filter.value);
+            filter.matches.swap(matches);
+        }
+        for (int i = 0; i < _proxyToSource.count(); ++i) {
+            if (_proxyToSource.at(i) >= first)
+                _proxyToSource[i] += count;
+        }
+        _sourceToProxy.insert(first, count, -1);
+
+        const SortIndex *index = activeSortIndex();
+        for (int row = first; row <= last; ++row) {
+            if (isAccepted(row))
+                insertProxyRows(insertPosition(index, row), QVector<int>(1, row));
+        }
+    }
+
+    void sourceRowsAboutToBeRemoved(int first, int last)
+    {
+        if (last - first + 1 > MaxIncrementalRows) {
+            sourceAboutToBeReset();
+            return;
+        }
+
+        // the rows leave the proxy while the source still has them, views may look at them
+        for (int row = last; row >= first; --row) {
+            const int position = _sourceToProxy.at(row);
+            if (position != -1)
+                removeProxyRows(position, position);
+        }
+    }
+
+    void sourceRowsRemoved(int first, int last)
+    {
+        if (_resetting) {
+            sourceReset();
+            return;
+        }
+
+        const int count = last - first + 1;
+        for (QHash<QString, SortIndex>::iterator i = _sortIndexes.begin(); i != _sortIndexes.end(); ++i) {
+            SortIndex &index = i.value();
+            for (int row = last; row >= first; --row)
+                index.rows.erase(qLowerBound(index.rows.begin(), index.rows.end(), row, KeyLessThan(index.keys)));
+            index.keys.remove(first, count);
+            for (int j = 0; j < index.rows.count(); ++j) {
+                if (index.rows.at(j) > last)
+                    index.rows[j] -= count;
+            }
+        }
+        for (int i = 0; i < _filters.count(); ++i) {
+            FilterIndex &filter = _filters[i];
+            QBitArray matches(filter.matches.size() - count);
+            for (int row = 0; row < matches.size(); ++row)
+                matches.setBit(row, filter.matches.testBit(row < first ? row : row + count));
+            filter.matches.swap(matches);
+        }
+        for (int i = 0; i < _proxyToSource.count(); ++i) {
+            if (_proxyToSource.at(i) > last)
+                _proxyToSource[i] -= count;
+        }
+        _sourceToProxy.remove(first, count); // the removed rows already left the proxy
+    }
+
+    void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+    {
+        if (topLeft.parent().isValid())
+            return;
+        const int first = topLeft.row();
+        const int last = bottomRight.row();
+        if (last - first + 1 > MaxIncrementalRows) {
+            q->beginResetModel();
+            clearIndexes();
+            rebuildMapping();
+            q->endResetModel();
+            return;
+        }
+
+        for (int row = first; row <= last; ++row) {
+            // every index is repositioned with two binary searches
+            for (QHash<QString, SortIndex>::iterator i = _sortIndexes.begin(); i != _sortIndexes.end(); ++i) {
+                SortIndex &index = i.value();
+                if (index.role == -1 || (!roles.isEmpty() && !roles.contains(index.role)))
+                    continue;
+                const SortKey key = sortKey(sourceData(row, index.role));
+                if (!(key < index.keys.at(row)) && !(index.keys.at(row) < key))
+                    continue;
+                index.rows.erase(qLowerBound(index.rows.begin(), index.rows.end(), row, KeyLessThan(index.keys)));
+                index.keys[row] = key;
+                index.rows.insert(qLowerBound(index.rows.begin(), index.rows.end(), row, KeyLessThan(index.keys)), row);
+            }
+            for (int i = 0; i < _filters.count(); ++i) {
+                FilterIndex &filter = _filters[i];
+                if (filter.role != -1 && (roles.isEmpty() || roles.contains(filter.role)))
+                    filter.matches.setBit(row, jsonValue(sourceData(row, filter.role)) == filter.value);
+            }
+            updateProxyRow(row, roles);
+        }
+    }
+
+    void updateProxyRow(int row, const QVector<int> &roles)
+    {
+        const int oldPosition = _sourceToProxy.at(row);
+        const bool accepted = isAccepted(row);
+        const SortIndex *index = activeSortIndex();
+
+        if (oldPosition == -1) {
+            if (accepted)
+                insertProxyRows(insertPosition(index, row), QVector<int>(1, row));
+            return;
+        }
+
+        if (!accepted) {
+            removeProxyRows(oldPosition, oldPosition);
+            return;
+        }
+
+        int position = insertPosition(index, row, oldPosition);
+        if (position != oldPosition) {
+            // beginMoveRows() takes the destination in the numbering before the move
+            q->beginMoveRows(QModelIndex(), oldPosition, oldPosition, QModelIndex(), position > oldPosition ? position + 1 : position);
+            _proxyToSource.remove(oldPosition);
+            _proxyToSource.insert(position, row);
+            const int from = qMin(position, oldPosition);
+            const int to = qMax(position, oldPosition);
+            for (int i = from; i <= to; ++i)
+                _sourceToProxy[_proxyToSource.at(i)] = i;
+            q->endMoveRows();
+        }
+        const int lastColumn = qMax(0, q->columnCount() - 1);
+        emit q->dataChanged(q->index(position, 0), q->index(position, lastColumn), roles);
+    }
+};
+
+const int EnginioSortFilterProxyModelPrivate::MaxIncrementalRows = 64;
+
+
+/*!
+  \class EnginioSortFilterProxyModel
+  \inmodule enginio-qt
+  \ingroup enginio-client
+  \brief EnginioSortFilterProxyModel sorts and filters the rows of a model locally.
+
+  The proxy works on the data which is already in the source model, usually an
+  \l EnginioModel, and never sends queries to the backend. Properties are referred
+  to by their role names, see QAbstractItemModel::roleNames().
+
+  For each property used for sorting the proxy keeps the source rows ordered by its
+  value, so switching between properties or orders which were used before only
+  rebuilds the mapping of rows. Each condition of the \l filter keeps one bit per row.
+  When a row of the source changes, it is moved to its new place using binary searches
+  instead of sorting again; inserted and removed rows are handled the same way.
+
+  Rows which are not in memory, for example rows evicted by \l EnginioModel::maxResidentRows,
+  are sorted and filtered as if they had no properties.
+
+  \sa EnginioModel
+*/
+
+/*!
+    Constructs a new proxy model with \a parent as QObject parent.
+*/
+EnginioSortFilterProxyModel::EnginioSortFilterProxyModel(QObject *parent)
+    : QAbstractProxyModel(parent)
+    , d(new EnginioSortFilterProxyModelPrivate(this))
+{}
+
+/*!
+    Destroys the proxy model.
+*/
+EnginioSortFilterProxyModel::~EnginioSortFilterProxyModel()
+{}
+
+/*!
+  \property EnginioSortFilterProxyModel::sortProperty
+  \brief The property by which the rows are sorted.
+
+  Values are ordered by type first: missing values, booleans, numbers, strings and
+  then arrays and objects. Strings are compared by their UTF-16 code units, not
+  locale aware. Rows with equal values keep the order of the source model.
+
+  By default it is empty and the rows are in the order of the source model.
+  \sa sortOrder
+*/
+QString EnginioSortFilterProxyModel::sortProperty() const
+{
+    return d->sortProperty();
+}
+
+void EnginioSortFilterProxyModel::setSortProperty(const QString &property)
+{
+    if (property == d->sortProperty())
+        return;
+    d->setSortProperty(property);
+}
+
+/*!
+  \property EnginioSortFilterProxyModel::sortOrder
+  \brief The order of the rows sorted by \l sortProperty, Qt::AscendingOrder by default.
+*/
+Qt::SortOrder EnginioSortFilterProxyModel::sortOrder() const
+{
+    return d->sortOrder();
+}
+
+void EnginioSortFilterProxyModel::setSortOrder(Qt::SortOrder order)
+{
+    if (order == d->sortOrder())
+        return;
+    d->setSortOrder(order);
+}
+
+/*!
+  \property EnginioSortFilterProxyModel::filter
+  \brief The values which the properties of the accepted rows must have.
+
+  Each key of the object is a property name and its value the JSON value which the
+  property has to be equal to. All conditions have to match. An empty filter, which
+  is the default, accepts all rows.
+
+  Changing the filter removes and inserts only the rows which leave or enter the proxy,
+  the model is not reset.
+*/
+QJsonObject EnginioSortFilterProxyModel::filter() const
+{
+    return d->filter();
+}
+
+void EnginioSortFilterProxyModel::setFilter(const QJsonObject &filter)
+{
+    if (filter == d->filter())
+        return;
+    d->setFilter(filter);
+}
+
+/*!
+    \overload
+    \internal
+*/
+void EnginioSortFilterProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    beginResetModel();
+    QAbstractProxyModel::setSourceModel(sourceModel);
+    d->setSource(sourceModel);
+    endResetModel();
+}
+
+/*!
+    \overload
+    \internal
+*/
+QModelIndex EnginioSortFilterProxyModel::mapToSource(const QModelIndex &proxyIndex) const
+{
+    if (!proxyIndex.isValid() || !sourceModel() || proxyIndex.row() >= d->rowCount())
+        return QModelIndex();
+    return sourceModel()->index(d->sourceRow(proxyIndex.row()), proxyIndex.column());
+}
+
+/*!
+    \overload
+    \internal
+*/
+QModelIndex EnginioSortFilterProxyModel::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    if (!sourceIndex.isValid() || sourceIndex.parent().isValid())
+        return QModelIndex();
+    const int row = d->proxyRow(sourceIndex.row());
+    if (row == -1)
+        return QModelIndex();
+    return index(row, sourceIndex.column());
+}
+
+/*!
+    \overload
+    \internal
+*/
+QModelIndex EnginioSortFilterProxyModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (parent.isValid() || row < 0 || row >= d->rowCount() || column < 0 || column >= columnCount())
+        return QModelIndex();
+    return createIndex(row, column);
+}
+
+/*!
+    \overload
+    \internal
+*/
+QModelIndex EnginioSortFilterProxyModel::parent(const QModelIndex &child) const
+{
+    Q_UNUSED(child);
+    return QModelIndex();
+}
+
+/*!
+    \overload
+    \internal
+*/
+int EnginioSortFilterProxyModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : d->rowCount();
+}
+
+/*!
+    \overload
+    \internal
+*/
+int EnginioSortFilterProxyModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || !sourceModel())
+        return 0;
+    return sourceModel()->columnCount();
+}
+
+/*!
+    \overload
+    Returns the role names of the source model.
+*/
+QHash<int, QByteArray> EnginioSortFilterProxyModel::roleNames() const
+{
+    if (!sourceModel())
+        return QAbstractProxyModel::roleNames();
+    return sourceModel()->roleNames();
+}
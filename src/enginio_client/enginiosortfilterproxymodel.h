@@ -0,0 +1,90 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://qt.digia.com/contact-us
+**
+** This file is part of the Enginio Qt Client Library.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+****************************************************************************/
+
+
+#ifndef ENGINIOSORTFILTERPROXYMODEL_H
+#define ENGINIOSORTFILTERPROXYMODEL_H
+
+#include <QtCore/qabstractproxymodel.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qscopedpointer.h>
+
+#include "enginioclient_global.h"
+
+class EnginioSortFilterProxyModelPrivate;
+class ENGINIOCLIENT_EXPORT EnginioSortFilterProxyModel : public QAbstractProxyModel
+{
+    Q_OBJECT
+public:
+    explicit EnginioSortFilterProxyModel(QObject *parent = 0);
+    ~EnginioSortFilterProxyModel();
+
+    Q_PROPERTY(QString sortProperty READ sortProperty WRITE setSortProperty NOTIFY sortPropertyChanged)
+    Q_PROPERTY(Qt::SortOrder sortOrder READ sortOrder WRITE setSortOrder NOTIFY sortOrderChanged)
+    Q_PROPERTY(QJsonObject filter READ filter WRITE setFilter NOTIFY filterChanged)
+
+    QString sortProperty() const;
+    void setSortProperty(const QString &property);
+
+    Qt::SortOrder sortOrder() const;
+    void setSortOrder(Qt::SortOrder order);
+
+    QJsonObject filter() const;
+    void setFilter(const QJsonObject &filter);
+
+    virtual void setSourceModel(QAbstractItemModel *sourceModel) Q_DECL_OVERRIDE;
+    virtual QModelIndex mapToSource(const QModelIndex &proxyIndex) const Q_DECL_OVERRIDE;
+    virtual QModelIndex mapFromSource(const QModelIndex &sourceIndex) const Q_DECL_OVERRIDE;
+
+    virtual QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    virtual QModelIndex parent(const QModelIndex &child) const Q_DECL_OVERRIDE;
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    virtual int columnCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    virtual QHash<int, QByteArray> roleNames() const Q_DECL_OVERRIDE;
+
+Q_SIGNALS:
+    void sortPropertyChanged(const QString &property);
+    void sortOrderChanged(Qt::SortOrder order);
+    void filterChanged(const QJsonObject &filter);
+
+private:
+    Q_DISABLE_COPY(EnginioSortFilterProxyModel)
+    QScopedPointer<EnginioSortFilterProxyModelPrivate> d;
+    friend class EnginioSortFilterProxyModelPrivate;
+};
+
+#endif // ENGINIOSORTFILTERPROXYMODEL_H
@@ -0,0 +1,971 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://qt.digia.com/contact-us
+**
+** This file is part of the Enginio Qt Client Library.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+****************************************************************************/
+
+
+#include "enginiotablemodel.h"
+#include "enginioreply.h"
+#include "enginioclient_p.h"
+#include "enginiofakereply_p.h"
+
+#include <QtCore/qobject.h>
+#include <QtCore/qvector.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qjsonarray.h>
+
+class EnginioTableModelPrivate {
+    EnginioTableModel *q;
+    EnginioClient *_enginio;
+    EnginioClient::Operation _operation;
+    QJsonObject _query;
+    QJsonArray _declaredColumns;
+    QVector<QMetaObject::Connection> _connections;
+    QHash<const EnginioReply*, QMetaObject::Connection> _repliesConnections;
+
+    enum ColumnType {
+        VarColumn,
+        StringColumn,
+        NumberColumn,
+        BoolColumn
+    };
+
+    // A column keeps one property of all rows in a single array of its type. The values
+    // are decoded from JSON once, when the rows arrive, and read from there by the views.
+    struct Column
+    {
+        QString name;
+        QString title;
+        ColumnType type;
+        QVector<QString> strings;
+        QVector<double> numbers;
+        QVector<bool> booleans;
+        QVector<QJsonValue> values;
+        QVector<bool> defined;
+
+        Column(const QString &columnName = QString(), const QString &columnTitle = QString(), ColumnType columnType = VarColumn)
+            : name(columnName)
+            , title(columnTitle)
+            , type(columnType)
+        {}
+
+        void reserve(int count)
+        {
+            defined.reserve(count);
+            switch (type) {
+            case StringColumn: strings.reserve(count); break;
+            case NumberColumn: numbers.reserve(count); break;
+            case BoolColumn: booleans.reserve(count); break;
+            case VarColumn: values.reserve(count); break;
+            }
+        }
+
+        void append(const QJsonValue &value)
+        {
+            defined.append(false);
+            switch (type) {
+            case StringColumn: strings.append(QString()); break;
+            case NumberColumn: numbers.append(0); break;
+            case BoolColumn: booleans.append(false); break;
+            case VarColumn: values.append(QJsonValue(QJsonValue::Undefined)); break;
+            }
+            set(defined.count() - 1, value);
+        }
+
+        void set(int row, const QJsonValue &value)
+        {
+            defined[row] = !value.isUndefined() && !value.isNull();
+            switch (type) {
+            case StringColumn:
+                strings[row] = value.isString() ? value.toString() : value.toVariant().toString();
+                break;
+            case NumberColumn:
+                numbers[row] = value.isDouble() ? value.toDouble() : value.toVariant().toDouble();
+                break;
+            case BoolColumn:
+                booleans[row] = value.isBool() ? value.toBool() : value.toVariant().toBool();
+                break;
+            case VarColumn:
+                values[row] = value;
+                break;
+            }
+        }
+
+        void remove(int row)
+        {
+            defined.remove(row);
+            switch (type) {
+            case StringColumn: strings.remove(row); break;
+            case NumberColumn: numbers.remove(row); break;
+            case BoolColumn: booleans.remove(row); break;
+            case VarColumn: values.remove(row); break;
+            }
+        }
+
+        void clear()
+        {
+            defined.clear();
+            strings.clear();
+            numbers.clear();
+            booleans.clear();
+            values.clear();
+        }
+
+        QVariant value(int row) const
+        {
+            if (!defined.at(row))
+                return QVariant();
+            switch (type) {
+            case StringColumn: return strings.at(row);
+            case NumberColumn: return numbers.at(row);
+            case BoolColumn: return booleans.at(row);
+            case VarColumn: break;
+            }
+            return values.at(row).toVariant();
+        }
+
+        QJsonValue json(int row) const
+        {
+            if (!defined.at(row))
+                return QJsonValue(QJsonValue::Undefined);
+            switch (type) {
+            case StringColumn: return strings.at(row);
+            case NumberColumn: return numbers.at(row);
+            case BoolColumn: return booleans.at(row);
+            case VarColumn: break;
+            }
+            return values.at(row);
+        }
+    };
+    QVector<Column> _columns;
+    QHash<QString, int> _columnOfProperty;
+
+    // per row data which is not shown in columns
+    QVector<QString> _ids;
+    QVector<int> _pendingWrites; // rows with writes on their way are not synced
+
+    const static int FullModelReset;
+    const static int IncrementalModelUpdate;
+    enum WriteKind {
+        CreateWrite,
+        UpdateWrite,
+        RemoveWrite
+    };
+    struct Request
+    {
+        int kind; // FullModelReset, IncrementalModelUpdate or a WriteKind
+        int row; // of a created object, updates and removals find their rows by id
+        QString id;
+        QJsonObject oldValues;
+    };
+    QHash<const EnginioReply*, Request> _requests;
+    const EnginioReply *_resetRequest;
+    const EnginioReply *_pageRequest;
+    int _nextPageOffset;
+    bool _canFetchMore;
+
+    class EnginioDestroyed
+    {
+        EnginioTableModelPrivate *model;
+    public:
+        EnginioDestroyed(EnginioTableModelPrivate *m)
+            : model(m)
+        {
+            Q_ASSERT(m);
+        }
+        void operator ()()
+        {
+            model->setEnginio(0);
+        }
+    };
+
+    class FinishedRequest
+    {
+        EnginioTableModelPrivate *model;
+    public:
+        FinishedRequest(EnginioTableModelPrivate *m)
+            : model(m)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()(const EnginioReply *response)
+        {
+            model->finishedRequest(response);
+        }
+    };
+
+    class QueryChanged
+    {
+        EnginioTableModelPrivate *model;
+    public:
+        QueryChanged(EnginioTableModelPrivate *m)
+            : model(m)
+        {
+            Q_ASSERT(m);
+        }
+
+        void operator ()()
+        {
+            model->execute();
+        }
+    };
+
+public:
+    EnginioTableModelPrivate(EnginioTableModel *q_ptr)
+        : q(q_ptr)
+        , _enginio(0)
+        , _operation()
+        , _resetRequest(0)
+        , _pageRequest(0)
+        , _nextPageOffset(0)
+        , _canFetchMore(false)
+    {
+        QObject::connect(q, &EnginioTableModel::queryChanged, QueryChanged(this));
+        QObject::connect(q, &EnginioTableModel::operationChanged, QueryChanged(this));
+        QObject::connect(q, &EnginioTableModel::enginioChanged, QueryChanged(this));
+    }
+
+    ~EnginioTableModelPrivate()
+    {
+        foreach (const QMetaObject::Connection &connection, _connections)
+            QObject::disconnect(connection);
+        foreach (const QMetaObject::Connection &connection, _repliesConnections)
+            QObject::disconnect(connection);
+    }
+
+    EnginioClient *enginio() const
+    {
+        return _enginio;
+    }
+
+    void setEnginio(const EnginioClient *enginio)
+    {
+        if (_enginio) {
+            foreach (const QMetaObject::Connection &connection, _connections)
+                QObject::disconnect(connection);
+            _connections.clear();
+            // replies of the previous client are not interesting anymore
+            foreach (const QMetaObject::Connection &connection, _repliesConnections)
+                QObject::disconnect(connection);
+            _repliesConnections.clear();
+            _requests.clear();
+            _resetRequest = _pageRequest = 0;
+        }
+        _enginio = const_cast<EnginioClient*>(enginio);
+        if (_enginio) {
+            _connections.append(QObject::connect(_enginio, &QObject::destroyed, EnginioDestroyed(this)));
+            _connections.append(QObject::connect(_enginio, &EnginioClient::backendIdChanged, QueryChanged(this)));
+            _connections.append(QObject::connect(_enginio, &EnginioClient::backendSecretChanged, QueryChanged(this)));
+        }
+        emit q->enginioChanged(_enginio);
+    }
+
+    QJsonObject query() const
+    {
+        return _query;
+    }
+
+    void setQuery(const QJsonObject &query)
+    {
+        _query = query;
+        _canFetchMore = preparePagedQuery(_query, "EnginioTableModel::setQuery()");
+        emit q->queryChanged(query);
+    }
+
+    EnginioClient::Operation operation() const
+    {
+        return _operation;
+    }
+
+    void setOperation(const int operation)
+    {
+        Q_ASSERT_X(operation >= EnginioClient::ObjectOperation, "setOperation", "Invalid operation specified.");
+        _operation = static_cast<EnginioClient::Operation>(operation);
+        emit q->operationChanged(_operation);
+    }
+
+    QJsonArray columns() const
+    {
+        return _declaredColumns;
+    }
+
+    void setColumns(const QJsonArray &columns)
+    {
+        _declaredColumns = columns;
+        // the values of the rows are stored only in the columns, so they are fetched again
+        q->beginResetModel();
+        clearRows();
+        _columns.clear();
+        _columnOfProperty.clear();
+        for (int i = 0; i < columns.count(); ++i) {
+            const QJsonValue column = columns.at(i);
+            if (column.isString()) {
+                addColumn(column.toString(), QString(), VarColumn);
+            } else {
+                const QJsonObject declaration = column.toObject();
+                addColumn(declaration[QStringLiteral("name")].toString(),
+                          declaration[QStringLiteral("title")].toString(),
+                          columnType(declaration[QStringLiteral("type")].toString()));
+            }
+        }
+        q->endResetModel();
+        emit q->columnsChanged(columns);
+        execute();
+    }
+
+    static ColumnType columnType(const QString &typeName)
+    {
+        if (typeName == QStringLiteral("string"))
+            return StringColumn;
+        if (typeName == QStringLiteral("number"))
+            return NumberColumn;
+        if (typeName == QStringLiteral("bool"))
+            return BoolColumn;
+        if (Q_UNLIKELY(!typeName.isEmpty() && typeName != QStringLiteral("var")))
+            qWarning() << "EnginioTableModel: unknown column type" << typeName << ", the values are not converted";
+        return VarColumn;
+    }
+
+    static QString columnTypeName(ColumnType type)
+    {
+        switch (type) {
+        case StringColumn: return QStringLiteral("string");
+        case NumberColumn: return QStringLiteral("number");
+        case BoolColumn: return QStringLiteral("bool");
+        case VarColumn: break;
+        }
+        return QStringLiteral("var");
+    }
+
+    void addColumn(const QString &name, const QString &title, ColumnType type)
+    {
+        if (Q_UNLIKELY(name.isEmpty() || _columnOfProperty.contains(name))) {
+            qWarning() << "EnginioTableModel: invalid or duplicated column" << name << ", it is ignored";
+            return;
+        }
+        _columnOfProperty.insert(name, _columns.count());
+        _columns.append(Column(name, title, type));
+    }
+
+    void discoverColumns(const QJsonObject &firstObject)
+    {
+        // without a declaration every property of the first object is a column, typed by its value
+        for (QJsonObject::const_iterator i = firstObject.constBegin(); i != firstObject.constEnd(); ++i) {
+            ColumnType type = VarColumn;
+            if (i.value().isString())
+                type = StringColumn;
+            else if (i.value().isDouble())
+                type = NumberColumn;
+            else if (i.value().isBool())
+                type = BoolColumn;
+            addColumn(i.key(), QString(), type);
+        }
+    }
+
+    void execute()
+    {
+        if (!_enginio || _enginio->backendId().isEmpty() || _enginio->backendSecret().isEmpty() || _query.isEmpty())
+            return;
+        _pageRequest = 0; // pages of the previous query are not interesting anymore
+        const EnginioReply *id = _enginio->query(_query, _operation);
+        QObject::connect(id, &EnginioReply::finished, id, &EnginioReply::deleteLater);
+        registerReply(id, FullModelReset, -1, QString(), QJsonObject());
+        _resetRequest = id;
+    }
+
+    void registerReply(const EnginioReply *reply, int kind, int row, const QString &objectId, const QJsonObject &oldValues)
+    {
+        Request request;
+        request.kind = kind;
+        request.row = row;
+        request.id = objectId;
+        request.oldValues = oldValues;
+        _requests.insert(reply, request);
+        _repliesConnections.insert(reply, QObject::connect(reply, &EnginioReply::finished, FinishedRequest(this)));
+    }
+
+    void clearRows()
+    {
+        for (int column = 0; column < _columns.count(); ++column)
+            _columns[column].clear();
+        _ids.clear();
+        _pendingWrites.clear();
+        // created objects are not in the model anymore
+        for (QHash<const EnginioReply*, Request>::iterator i = _requests.begin(); i != _requests.end(); ++i) {
+            if (i->kind == CreateWrite)
+                i->row = -1;
+        }
+    }
+
+    void appendRows(const QJsonArray &objects)
+    {
+        const int count = _ids.count() + objects.count();
+        for (int column = 0; column < _columns.count(); ++column)
+            _columns[column].reserve(count);
+        _ids.reserve(count);
+        _pendingWrites.reserve(count);
+
+        for (int i = 0; i < objects.count(); ++i) {
+            const QJsonObject object = objects.at(i).toObject();
+            for (int column = 0; column < _columns.count(); ++column)
+                _columns[column].append(object[_columns.at(column).name]);
+            _ids.append(object[EnginioString::id].toString());
+            _pendingWrites.append(0);
+        }
+    }
+
+    void setRowValues(int row, const QJsonObject &object)
+    {
+        // only the properties contained in the object are changed
+        for (QJsonObject::const_iterator i = object.constBegin(); i != object.constEnd(); ++i) {
+            const int column = _columnOfProperty.value(i.key(), -1);
+            if (column != -1)
+                _columns[column].set(row, i.value());
+        }
+        if (object.contains(EnginioString::id))
+            _ids[row] = object[EnginioString::id].toString();
+    }
+
+    void removeRow(int row)
+    {
+        q->beginRemoveRows(QModelIndex(), row, row);
+        for (int column = 0; column < _columns.count(); ++column)
+            _columns[column].remove(row);
+        _ids.remove(row);
+        _pendingWrites.remove(row);
+        // created objects which are on their way to the backend move up
+        for (QHash<const EnginioReply*, Request>::iterator i = _requests.begin(); i != _requests.end(); ++i) {
+            if (i->kind == CreateWrite && i->row > row)
+                --i->row;
+        }
+        q->endRemoveRows();
+    }
+
+    int rowOfId(const QString &objectId) const
+    {
+        return objectId.isEmpty() ? -1 : _ids.indexOf(objectId);
+    }
+
+    void emitRowChanged(int row)
+    {
+        if (!_columns.isEmpty())
+            emit q->dataChanged(q->index(row, 0), q->index(row, _columns.count() - 1));
+    }
+
+    void finishedRequest(const EnginioReply *response)
+    {
+        QObject::disconnect(_repliesConnections.take(response));
+        if (!_requests.contains(response))
+            return;
+        const Request request = _requests.take(response);
+        const bool failed = response->networkError() != QNetworkReply::NoError;
+
+        if (request.kind == FullModelReset) {
+            if (response != _resetRequest)
+                return; // the query was changed in the meantime
+            _resetRequest = 0;
+            const QJsonArray results = response->data()[EnginioString::results].toArray();
+            q->beginResetModel();
+            clearRows();
+            if (_declaredColumns.isEmpty() && !results.isEmpty()) {
+                _columns.clear();
+                _columnOfProperty.clear();
+                discoverColumns(results.first().toObject());
+            }
+            appendRows(results);
+            _nextPageOffset = results.count();
+            _canFetchMore = _canFetchMore && !failed && results.count() >= _query[EnginioString::limit].toDouble();
+            q->endResetModel();
+        } else if (request.kind == IncrementalModelUpdate) {
+            if (response != _pageRequest)
+                return; // the query was changed in the meantime
+            _pageRequest = 0;
+            if (failed)
+                return; // it is requested again by the next fetchMore()
+            const QJsonArray results = response->data()[EnginioString::results].toArray();
+            if (results.count() < _query[EnginioString::limit].toDouble())
+                _canFetchMore = false; // the end of the collection
+            _nextPageOffset += results.count();
+            if (results.isEmpty())
+                return;
+            q->beginInsertRows(QModelIndex(), _ids.count(), _ids.count() + results.count() - 1);
+            appendRows(results);
+            q->endInsertRows();
+        } else if (request.kind == CreateWrite) {
+            const int row = request.row;
+            if (row < 0 || row >= _ids.count())
+                return; // the model was reset in the meantime
+            --_pendingWrites[row];
+            if (failed) {
+                removeRow(row); // nothing was created
+                return;
+            }
+            setRowValues(row, response->data());
+            emitRowChanged(row);
+        } else {
+            const int row = rowOfId(request.id);
+            if (row == -1)
+                return;
+            --_pendingWrites[row];
+            if (request.kind == UpdateWrite)
+                setRowValues(row, failed ? request.oldValues : response->data());
+            if (request.kind == RemoveWrite && !failed)
+                removeRow(row);
+            else
+                emitRowChanged(row);
+        }
+    }
+
+    int rowCount() const
+    {
+        return _ids.count();
+    }
+
+    int columnCount() const
+    {
+        return _columns.count();
+    }
+
+    QVariant data(int row, int column) const
+    {
+        return _columns.at(column).value(row);
+    }
+
+    bool isSynced(int row) const
+    {
+        return !_pendingWrites.at(row);
+    }
+
+    QVariant headerData(int section, int role) const
+    {
+        const Column &column = _columns.at(section);
+        switch (role) {
+        case Qt::DisplayRole:
+            return column.title.isEmpty() ? column.name : column.title;
+        case EnginioTableModel::PropertyNameRole:
+            return column.name;
+        case EnginioTableModel::PropertyTypeRole:
+            return columnTypeName(column.type);
+        default:
+            break;
+        }
+        return QVariant();
+    }
+
+    bool canFetchMore() const
+    {
+        return _canFetchMore;
+    }
+
+    void fetchMore()
+    {
+        if (!_canFetchMore || _resetRequest || _pageRequest || !_enginio)
+            return;
+        QJsonObject query(_query);
+        query[EnginioString::offset] = _nextPageOffset;
+        const EnginioReply *id = _enginio->query(query, _operation);
+        QObject::connect(id, &EnginioReply::finished, id, &EnginioReply::deleteLater);
+        registerReply(id, IncrementalModelUpdate, -1, QString(), QJsonObject());
+        _pageRequest = id;
+    }
+
+    EnginioReply *errorReply(const QByteArray &message) const
+    {
+        EnginioClientPrivate *client = EnginioClientPrivate::get(_enginio);
+        QNetworkReply *nreply = new EnginioFakeReply(client, constructErrorMessage(message));
+        return new EnginioReply(client, nreply);
+    }
+
+    EnginioReply *append(const QJsonObject &value)
+    {
+        QJsonObject object(value);
+        object[EnginioString::objectType] = _query[EnginioString::objectType];
+        EnginioReply *id = _enginio->create(object, _operation);
+        const int row = _ids.count();
+        const bool discover = _declaredColumns.isEmpty() && _columns.isEmpty();
+        if (discover) {
+            q->beginResetModel();
+            discoverColumns(value);
+        } else {
+            q->beginInsertRows(QModelIndex(), row, row);
+        }
+        QJsonArray rows;
+        rows.append(value);
+        appendRows(rows);
+        ++_pendingWrites[row];
+        registerReply(id, CreateWrite, row, QString(), QJsonObject());
+        if (discover)
+            q->endResetModel();
+        else
+            q->endInsertRows();
+        return id;
+    }
+
+    EnginioReply *remove(int row)
+    {
+        const QString objectId = _ids.at(row);
+        if (objectId.isEmpty())
+            return errorReply(QByteArrayLiteral("EnginioTableModel::remove: the object was not created in the backend yet"));
+        QJsonObject object;
+        object[EnginioString::id] = objectId;
+        object[EnginioString::objectType] = _query[EnginioString::objectType];
+        EnginioReply *id = _enginio->remove(object, _operation);
+        ++_pendingWrites[row];
+        registerReply(id, RemoveWrite, row, objectId, QJsonObject());
+        emitRowChanged(row);
+        return id;
+    }
+
+    bool isWritable(int row) const
+    {
+        return _enginio && !_ids.at(row).isEmpty();
+    }
+
+    EnginioReply *setValue(int row, const QString &property, const QVariant &value)
+    {
+        const QString objectId = _ids.at(row);
+        if (objectId.isEmpty())
+            return errorReply(QByteArrayLiteral("EnginioTableModel::setProperty: the object was not created in the backend yet"));
+
+        const QJsonValue newValue = QJsonValue::fromVariant(value);
+        QJsonObject delta;
+        delta[EnginioString::id] = objectId;
+        delta[EnginioString::objectType] = _query[EnginioString::objectType];
+        delta[property] = newValue;
+
+        // the change is shown immediately and reverted if the backend rejects it
+        QJsonObject oldValues;
+        const int column = _columnOfProperty.value(property, -1);
+        if (column != -1) {
+            oldValues[property] = _columns.at(column).json(row);
+            _columns[column].set(row, newValue);
+        }
+        EnginioReply *id = _enginio->update(delta, _operation);
+        ++_pendingWrites[row];
+        registerReply(id, UpdateWrite, row, objectId, oldValues);
+        emitRowChanged(row);
+        return id;
+    }
+
+    QString columnName(int column) const
+    {
+        return _columns.at(column).name;
+    }
+};
+
+const int EnginioTableModelPrivate::FullModelReset = -1;
+const int EnginioTableModelPrivate::IncrementalModelUpdate = -2;
+
+
+/*!
+  \class EnginioTableModel
+  \inmodule enginio-qt
+  \ingroup enginio-client
+  \brief EnginioTableModel represents data from Enginio as a \l QAbstractTableModel.
+
+  Every object of the \l query is a row and every property listed in \l columns is a
+  column, which makes the model suitable for views showing many properties at once,
+  like QTableView.
+
+  The values of a column are kept in a single array of the column's type, decoded from
+  JSON once when the rows arrive, so reading them costs no JSON lookups.
+
+  Like \l EnginioModel, the model fetches the next page when a view asks for it if the
+  \l query contains a \c pageSize, and changes made through setData(), setProperty(),
+  append() and remove() are shown immediately and sent to the backend.
+
+  \sa EnginioModel
+*/
+
+/*!
+  \enum EnginioTableModel::HeaderRole
+
+  Roles of headerData() describing the horizontal header.
+
+  \value PropertyNameRole
+    The name of the property shown in the column.
+  \value PropertyTypeRole
+    The type of the column: \c "string", \c "number", \c "bool" or \c "var".
+*/
+
+/*!
+  \enum EnginioTableModel::DataRole
+
+  Roles of data() besides the display and edit roles.
+
+  \value SyncedRole
+    \c false while a change of the object made through the model is on its way to
+    the backend, \c true otherwise.
+*/
+
+/*!
+    Constructs a new model with \a parent as QObject parent.
+*/
+EnginioTableModel::EnginioTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+    , d(new EnginioTableModelPrivate(this))
+{}
+
+/*!
+    Destroys the model.
+*/
+EnginioTableModel::~EnginioTableModel()
+{}
+
+/*!
+  \property EnginioTableModel::enginio
+  \brief The EnginioClient used by the model.
+
+  \sa EnginioClient
+*/
+EnginioClient *EnginioTableModel::enginio() const
+{
+    return d->enginio();
+}
+
+void EnginioTableModel::setEnginio(const EnginioClient *enginio)
+{
+    if (enginio == d->enginio())
+        return;
+    d->setEnginio(enginio);
+}
+
+/*!
+  \property EnginioTableModel::query
+  \brief The query which returns the data for the model.
+
+  A \c pageSize in the query fetches the objects page by page, as in \l EnginioModel.
+
+  \sa EnginioClient::query()
+*/
+QJsonObject EnginioTableModel::query() const
+{
+    return d->query();
+}
+
+void EnginioTableModel::setQuery(const QJsonObject &query)
+{
+    if (query == d->query())
+        return;
+    d->setQuery(query);
+}
+
+/*!
+  \property EnginioTableModel::operation
+  \brief The operation type of the query
+  \sa EnginioClient::Operation, query()
+*/
+EnginioClient::Operation EnginioTableModel::operation() const
+{
+    return d->operation();
+}
+
+void EnginioTableModel::setOperation(EnginioClient::Operation operation)
+{
+    if (operation == d->operation())
+        return;
+    d->setOperation(operation);
+}
+
+/*!
+  \property EnginioTableModel::columns
+  \brief The properties shown as columns.
+
+  Each entry is either the name of a property or an object with the \c name of the
+  property, an optional \c title for the header and an optional \c type: \c "string",
+  \c "number", \c "bool" or \c "var". Values of a typed column are converted to the type,
+  \c "var" columns keep any JSON value.
+
+  If the list is empty, which is the default, every property of the first fetched object
+  becomes a column, typed by its value.
+
+  Changing the columns fetches the query again.
+*/
+QJsonArray EnginioTableModel::columns() const
+{
+    return d->columns();
+}
+
+void EnginioTableModel::setColumns(const QJsonArray &columns)
+{
+    if (columns == d->columns())
+        return;
+    d->setColumns(columns);
+}
+
+/*!
+  Create a new object in the backend from \a value and append it to the model.
+  \return reply from backend
+  \sa EnginioClient::create()
+*/
+EnginioReply *EnginioTableModel::append(const QJsonObject &value)
+{
+    if (!d->enginio()) {
+        qWarning("EnginioTableModel::append(): Enginio client is not set");
+        return 0;
+    }
+
+    return d->append(value);
+}
+
+/*!
+  Remove the object in \a row from the backend, the row is removed when the reply finishes.
+  \return reply from backend
+  \sa EnginioClient::remove()
+*/
+EnginioReply *EnginioTableModel::remove(int row)
+{
+    if (!d->enginio()) {
+        qWarning("EnginioTableModel::remove(): Enginio client is not set");
+        return 0;
+    }
+
+    if (unsigned(row) >= unsigned(d->rowCount()))
+        return d->errorReply(QByteArrayLiteral("EnginioTableModel::remove: row is out of range"));
+
+    return d->remove(row);
+}
+
+/*!
+  Change the \a property of the object in \a row to \a value. The column of the
+  property shows the new value immediately, the update is sent to the backend.
+  \return reply from backend
+  \sa EnginioClient::update()
+*/
+EnginioReply *EnginioTableModel::setProperty(int row, const QString &property, const QVariant &value)
+{
+    if (!d->enginio()) {
+        qWarning("EnginioTableModel::setProperty(): Enginio client is not set");
+        return 0;
+    }
+
+    if (unsigned(row) >= unsigned(d->rowCount()))
+        return d->errorReply(QByteArrayLiteral("EnginioTableModel::setProperty: row is out of range"));
+
+    return d->setValue(row, property, value);
+}
+
+/*!
+    \overload
+    \internal
+*/
+Qt::ItemFlags EnginioTableModel::flags(const QModelIndex &index) const
+{
+    return QAbstractTableModel::flags(index) | Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsEditable;
+}
+
+/*!
+    \overload
+    Returns the value of the column's property of the object in the row of \a index,
+    for the display and edit \a role. A missing property gives an invalid QVariant.
+    For the SyncedRole it returns whether all changes of the object reached the backend.
+*/
+QVariant EnginioTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= d->rowCount() || index.column() >= d->columnCount())
+        return QVariant();
+    if (role == SyncedRole)
+        return d->isSynced(index.row());
+    if (role != Qt::DisplayRole && role != Qt::EditRole)
+        return QVariant();
+
+    return d->data(index.row(), index.column());
+}
+
+/*!
+    \overload
+    Returns the title of the column in \a section of the horizontal header, or the name
+    and the type of its property for the \l HeaderRole values of \a role.
+*/
+QVariant EnginioTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || section < 0 || section >= d->columnCount())
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    return d->headerData(section, role);
+}
+
+/*!
+    \overload
+    \internal
+*/
+int EnginioTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : d->rowCount();
+}
+
+/*!
+    \overload
+    \internal
+*/
+int EnginioTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : d->columnCount();
+}
+
+/*!
+    \overload
+    \internal
+*/
+bool EnginioTableModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || index.row() >= d->rowCount() || index.column() >= d->columnCount())
+        return false;
+    if (role != Qt::EditRole || !d->isWritable(index.row()))
+        return false;
+
+    d->setValue(index.row(), d->columnName(index.column()), value);
+    return true;
+}
+
+/*!
+    \overload
+    \internal
+*/
+void EnginioTableModel::fetchMore(const QModelIndex &parent)
+{
+    Q_UNUSED(parent);
+    d->fetchMore();
+}
+
+/*!
+    \overload
+    \internal
+*/
+bool EnginioTableModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && d->canFetchMore();
+}
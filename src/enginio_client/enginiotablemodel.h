@@ -0,0 +1,109 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://qt.digia.com/contact-us
+**
+** This file is part of the Enginio Qt Client Library.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+****************************************************************************/
+
+
+#ifndef ENGINIOTABLEMODEL_H
+#define ENGINIOTABLEMODEL_H
+
+#include <QtCore/qabstractitemmodel.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qscopedpointer.h>
+
+#include "enginioclient.h"
+
+class EnginioTableModelPrivate;
+class ENGINIOCLIENT_EXPORT EnginioTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum HeaderRole {
+        PropertyNameRole = Qt::UserRole + 1,
+        PropertyTypeRole
+    };
+
+    enum DataRole {
+        SyncedRole = Qt::UserRole + 1
+    };
+
+    explicit EnginioTableModel(QObject *parent = 0);
+    ~EnginioTableModel();
+
+    Q_PROPERTY(EnginioClient *enginio READ enginio WRITE setEnginio NOTIFY enginioChanged)
+    Q_PROPERTY(QJsonObject query READ query WRITE setQuery NOTIFY queryChanged)
+    Q_PROPERTY(EnginioClient::Operation operation READ operation WRITE setOperation NOTIFY operationChanged)
+    Q_PROPERTY(QJsonArray columns READ columns WRITE setColumns NOTIFY columnsChanged)
+
+    EnginioClient *enginio() const;
+    void setEnginio(const EnginioClient *enginio);
+
+    QJsonObject query() const;
+    void setQuery(const QJsonObject &query);
+
+    EnginioClient::Operation operation() const;
+    void setOperation(EnginioClient::Operation operation);
+
+    QJsonArray columns() const;
+    void setColumns(const QJsonArray &columns);
+
+    virtual Qt::ItemFlags flags(const QModelIndex &index) const Q_DECL_OVERRIDE;
+    virtual QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+    virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const Q_DECL_OVERRIDE;
+    virtual int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    virtual int columnCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    virtual bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) Q_DECL_OVERRIDE;
+
+    virtual void fetchMore(const QModelIndex &parent) Q_DECL_OVERRIDE;
+    virtual bool canFetchMore(const QModelIndex &parent) const Q_DECL_OVERRIDE;
+
+    Q_INVOKABLE EnginioReply *append(const QJsonObject &value);
+    Q_INVOKABLE EnginioReply *remove(int row);
+    Q_INVOKABLE EnginioReply *setProperty(int row, const QString &property, const QVariant &value);
+
+Q_SIGNALS:
+    void enginioChanged(EnginioClient *enginio);
+    void queryChanged(const QJsonObject query);
+    void operationChanged(const EnginioClient::Operation operation);
+    void columnsChanged(const QJsonArray &columns);
+
+private:
+    Q_DISABLE_COPY(EnginioTableModel)
+    QScopedPointer<EnginioTableModelPrivate> d;
+    friend class EnginioTableModelPrivate;
+};
+
+#endif // ENGINIOTABLEMODEL_H
@@ -42,6 +42,7 @@
 #include "enginioreply.h"
 #include "enginioqmlreply.h"
 #include "enginioidentity.h"
+#include "enginiorequestgroup.h"
 #include <Enginio/private/enginioclient_p.h>
 
 #include <qqml.h>
@@ -90,4 +91,5 @@ void EnginioPlugin::registerTypes(const char *uri)
     qmlRegisterUncreatableType<EnginioQmlReply>(uri, 1, 0, "EnginioReply", "EnginioReply cannot be instantiated.");
     qmlRegisterUncreatableType<EnginioIdentity>(uri, 1, 0, "EnginioIdentity", "EnginioIdentity can not be instantiated directly");
     qmlRegisterType<EnginioAuthentication>(uri, 1, 0, "EnginioAuthentication");
+    qmlRegisterType<EnginioRequestGroup>(uri, 1, 0, "EnginioRequestGroup");
 }
@@ -86,6 +86,84 @@
   Usually there is no need to change the default URL.
 */
 
+/*!
+  \qmlproperty real Enginio1::Enginio::maxRequestsPerSecond
+  The maximum number of requests sent to the backend per second. Requests above the
+  rate wait until they can be sent. The default value 0 disables the limit.
+*/
+
+/*!
+  \qmlproperty int Enginio1::Enginio::maxBytesPerSecond
+  The maximum number of bytes of request data sent to the backend per second.
+  The default value 0 disables the limit.
+*/
+
+/*!
+  \qmlproperty int Enginio1::Enginio::queueDepth
+  The number of requests waiting to be sent because of the rate limit or the limit
+  of requests running at the same time.
+*/
+
+/*!
+  \qmlproperty bool Enginio1::Enginio::saturated
+  Whether new requests have to wait before they are sent.
+*/
+
+/*!
+  \qmlproperty bool Enginio1::Enginio::hedgedReads
+  Whether a query or file download which is slower than most recent ones is sent a second
+  time, using the reply which arrives first. The default value is false.
+*/
+
+/*!
+  \qmlproperty real Enginio1::Enginio::maxHedgeRatio
+  The maximum number of duplicate reads relative to the number of sent reads. The default value is 0.1.
+*/
+
+/*!
+  \qmlproperty real Enginio1::Enginio::circuitBreakerThreshold
+  The rate of failed requests to an endpoint at which further requests fail fast with the
+  backend status 503, instead of waiting for the degraded backend. The default value is 0.5,
+  the value 0 disables it.
+*/
+
+/*!
+  \qmlproperty int Enginio1::Enginio::circuitBreakerTimeout
+  The time in milliseconds after which a single probe request is sent to an endpoint which
+  fails fast. The default value is 5000.
+*/
+
+/*!
+  \qmlproperty int Enginio1::Enginio::requestTimeout
+  The default timeout in milliseconds of new replies. The default value 0 means that
+  requests do not time out.
+  \sa EnginioReply::timeout
+*/
+
+/*!
+  \qmlproperty EnginioRequestGroup Enginio1::Enginio::requestGroup
+  The group to which all requests are added while it is set, so that they can be
+  aborted together with EnginioRequestGroup::cancelAll().
+*/
+
+/*!
+  \qmlproperty int Enginio1::Enginio::networkManagerCount
+  The number of network access managers over which requests are spread, each of them
+  opens up to six connections to the backend. The default value is 1.
+*/
+
+/*!
+  \qmlproperty bool Enginio1::Enginio::reserveInteractiveManager
+  Whether the first network access manager is kept for requests of the interactive
+  priority when there is more than one. The default value is true.
+*/
+
+/*!
+  \qmlproperty bool Enginio1::Enginio::tlsSessionCache
+  Whether the TLS session of the backend connection is stored on disk, so that the first
+  request of a new process resumes it instead of a full handshake. The default value is true.
+*/
+
 /*!
   \qmlmethod EnginioReply Enginio1::Enginio::search(QJsonObject query)
   \brief Perform a full text search on the database
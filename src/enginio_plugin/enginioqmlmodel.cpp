@@ -80,6 +80,80 @@
   The operation used for the \l query.
 */
 
+/*!
+  \qmlproperty int Enginio1::EnginioModel::initialLoadShards
+  The number of parallel queries used to load the data of the model. The default value 0
+  loads everything with a single query.
+*/
+
+/*!
+  \qmlproperty int Enginio1::EnginioModel::prefetchPages
+  The number of pages requested ahead of the rows shown by a view, when
+  the \l query contains a \c pageSize. The default value 0 requests the next
+  page only when the view reaches the end of the model.
+*/
+
+/*!
+  \qmlproperty int Enginio1::EnginioModel::maxResidentRows
+  The maximum number of rows of a \l query with a \c pageSize kept in memory.
+  Least recently accessed pages beyond it are dropped and fetched again when
+  one of their rows is accessed. The default value 0 keeps all rows.
+*/
+
+/*!
+  \qmlproperty enumeration Enginio1::EnginioModel::pagingMode
+  The way pages of a \l query containing a \c pageSize are requested.
+  \list
+  \li EnginioModel.OffsetPaging - a page is requested by the \c offset of its first row (default).
+  \li EnginioModel.KeysetPaging - a page is requested by the value of the sort key in the last fetched row.
+  \endlist
+*/
+
+/*!
+  \qmlproperty int Enginio1::EnginioModel::syncInterval
+  The interval in milliseconds in which the model is synchronized with the backend
+  by fetching only the objects changed since the last update. The default value 0
+  disables the periodic synchronization.
+*/
+
+/*!
+  \qmlproperty bool Enginio1::EnginioModel::realtimeUpdates
+  Whether changes of objects of the query's \c objectType are pushed by the backend
+  and applied to the model as they happen. While the connection is down, the model
+  polls for changes instead.
+*/
+
+/*!
+  \qmlmethod void Enginio1::EnginioModel::synchronize()
+  Fetch the objects which were changed since the newest one in the model and update
+  the rows in place. Removed objects are detected by comparing the number of objects.
+*/
+
+/*!
+  \qmlproperty bool Enginio1::EnginioModel::fieldProjection
+  Whether the queries of the model download only the properties used as roles.
+  Other properties of a row are fetched with fetchFullObject().
+*/
+
+/*!
+  \qmlproperty QJsonObject Enginio1::EnginioModel::roles
+  The roles of the model, declared up front as pairs of a property name and its type,
+  for example \c {{"title": "string", "done": "bool"}}. Delegates can bind to the roles
+  before any data arrives. If it is empty, the roles are taken from the first object.
+*/
+
+/*!
+  \qmlmethod EnginioReply Enginio1::EnginioModel::fetchFullObject(int row)
+  \brief Fetch all properties of the object at \a row and update the row
+*/
+
+/*!
+  \qmlproperty int Enginio1::EnginioModel::writeBehindInterval
+  The time in milliseconds for which property changes of an object are merged
+  before a single update is sent to the backend. The default value 0 sends every
+  change immediately.
+*/
+
 /*!
   \qmlmethod EnginioReply Enginio1::EnginioModel::append(QJsonObject value)
   \brief Add a new object to the model and database.
@@ -42,6 +42,17 @@
   The backend status code.
 */
 
+/*!
+  \qmlproperty int Enginio1::EnginioReply::timeout
+  The time in milliseconds within which the request has to finish, otherwise it is
+  aborted with a timeout error. The value 0 means no timeout.
+*/
+
+/*!
+  \qmlmethod void Enginio1::EnginioReply::abort()
+  Abort the request, the reply finishes with an error unless it was finished already.
+*/
+
 class EnginioQmlReplyPrivate : public EnginioReplyPrivate
 {
     EnginioQmlReply *q;
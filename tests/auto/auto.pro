@@ -3,6 +3,8 @@ TEMPLATE = subdirs
 SUBDIRS += \
     enginioclient \
     enginiomodel \
+    enginiotablemodel \
+    enginiosortfilterproxymodel \
     files \
 
 qtHaveModule(quick) {
@@ -0,0 +1,364 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://qt.digia.com/contact-us
+**
+** This file is part of the Enginio Qt Client Library.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+****************************************************************************/
+
+#include <QtCore/qdatetime.h>
+#include <QtCore/qjsondocument.h>
+#include <QtCore/qtimer.h>
+#include <QtCore/qurlquery.h>
+#include <QtNetwork/qtcpsocket.h>
+
+#include "mockserver.h"
+
+namespace EnginioTests {
+
+static const int StreamTimeout = 1000;
+
+MockServer::MockServer(QObject *parent)
+    : QTcpServer(parent)
+    , _holdResponses(false)
+    , _failures(0)
+    , _failureStatus(0)
+    , _lostResponses(0)
+    , _streamEnabled(true)
+    , _lastId(0)
+{
+    connect(this, SIGNAL(newConnection()), this, SLOT(newConnectionAvailable()));
+    QTimer *timer = new QTimer(this);
+    connect(timer, SIGNAL(timeout()), this, SLOT(streamTimeout()));
+    timer->start(StreamTimeout / 10);
+    listen(QHostAddress::LocalHost);
+}
+
+MockServer::~MockServer()
+{}
+
+QUrl MockServer::url() const
+{
+    return QUrl(QStringLiteral("http://127.0.0.1:") + QString::number(serverPort()));
+}
+
+void MockServer::setStreamEnabled(bool enabled)
+{
+    _streamEnabled = enabled;
+    if (enabled)
+        return;
+    // drop the requests which are waiting for changes
+    foreach (const PendingStream &stream, _pendingStreams)
+        respond(stream.socket, 503, QJsonObject());
+    _pendingStreams.clear();
+}
+
+void MockServer::newConnectionAvailable()
+{
+    while (QTcpSocket *socket = nextPendingConnection()) {
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readRequests()));
+        connect(socket, SIGNAL(disconnected()), this, SLOT(socketDisconnected()));
+    }
+}
+
+void MockServer::socketDisconnected()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    _buffers.remove(socket);
+    for (int i = _pendingStreams.count() - 1; i >= 0; --i) {
+        if (_pendingStreams.at(i).socket == socket)
+            _pendingStreams.removeAt(i);
+    }
+    socket->deleteLater();
+}
+
+void MockServer::readRequests()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    QByteArray &buffer = _buffers[socket];
+    buffer.append(socket->readAll());
+
+    forever {
+        const int headerEnd = buffer.indexOf("\r\n\r\n");
+        if (headerEnd == -1)
+            return;
+
+        Request request;
+        QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+        QList<QByteArray> requestLine = lines.takeFirst().trimmed().split(' ');
+        if (requestLine.count() < 2)
+            return;
+        request.method = requestLine.at(0);
+        request.url = QUrl::fromEncoded(requestLine.at(1));
+        foreach (const QByteArray &line, lines) {
+            const int colon = line.indexOf(':');
+            if (colon > 0)
+                request.headers.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+        }
+
+        const int contentLength = request.headers.value("content-length").toInt();
+        if (buffer.size() < headerEnd + 4 + contentLength)
+            return; // wait for the rest of the body
+        request.body = buffer.mid(headerEnd + 4, contentLength);
+        buffer.remove(0, headerEnd + 4 + contentLength);
+
+        ++_requestCounts[request.method];
+        handle(socket, request);
+    }
+}
+
+int MockServer::indexOf(const QString &objectType, const QString &id) const
+{
+    const QList<QJsonObject> objects = _objects.value(objectType);
+    for (int i = 0; i < objects.count(); ++i) {
+        if (objects.at(i)["id"].toString() == id)
+            return i;
+    }
+    return -1;
+}
+
+QJsonObject MockServer::project(const QJsonObject &object, const QJsonArray &fields)
+{
+    // like the backend, the system properties are always there
+    QJsonObject result;
+    result["id"] = object["id"];
+    result["objectType"] = object["objectType"];
+    result["createdAt"] = object["createdAt"];
+    result["updatedAt"] = object["updatedAt"];
+    for (int i = 0; i < fields.count(); ++i) {
+        const QString field = fields.at(i).toString();
+        if (object.contains(field))
+            result[field] = object[field];
+    }
+    return result;
+}
+
+void MockServer::handle(QTcpSocket *socket, const Request &request)
+{
+    // /v1/objects/<type>[/<id>]
+    const QStringList path = request.url.path().split(QLatin1Char('/'), QString::SkipEmptyParts);
+    if (path.count() == 2 && path.at(1) == QStringLiteral("stream") && request.method == "GET") {
+        handleStream(socket, request);
+        return;
+    }
+    if (_failures > 0) {
+        --_failures;
+        respond(socket, _failureStatus, QJsonObject());
+        return;
+    }
+    if (_lostResponses > 0) {
+        --_lostResponses;
+        handle(0, request); // the response of the handled request goes nowhere
+        respond(socket, 504, QJsonObject());
+        return;
+    }
+    if (path.count() < 3 || path.at(0) != QStringLiteral("v1") || path.at(1) != QStringLiteral("objects")) {
+        respond(socket, 404, QJsonObject());
+        return;
+    }
+
+    const QString objectType = QStringLiteral("objects.") + path.at(2);
+    const QString id = path.value(3);
+    const QJsonObject data = QJsonDocument::fromJson(request.body).object();
+
+    if (request.method == "GET" && id.isEmpty()) {
+        const QUrlQuery query(request.url);
+        QList<QJsonObject> objects = _objects.value(objectType);
+        QJsonObject result;
+
+        // only equality of plain values and $in are understood, operators like $gte are ignored
+        const QJsonObject filter = QJsonDocument::fromJson(query.queryItemValue(QStringLiteral("q"), QUrl::FullyDecoded).toUtf8()).object();
+        for (QJsonObject::const_iterator i = filter.constBegin(); i != filter.constEnd(); ++i) {
+            const QJsonObject condition = i.value().toObject();
+            if (i.value().isObject() && !condition.contains(QStringLiteral("$in")))
+                continue;
+            const QJsonArray in = condition[QStringLiteral("$in")].toArray();
+            for (int j = objects.count() - 1; j >= 0; --j) {
+                const QJsonValue value = objects.at(j)[i.key()];
+                if (i.value().isObject() ? !in.contains(value) : value != i.value())
+                    objects.removeAt(j);
+            }
+        }
+
+        if (query.hasQueryItem(QStringLiteral("count"))) {
+            result["count"] = objects.count();
+        } else {
+            const int offset = query.queryItemValue(QStringLiteral("offset")).toInt();
+            int limit = query.queryItemValue(QStringLiteral("limit")).toInt();
+            if (!limit)
+                limit = objects.count();
+            const QJsonArray fields = QJsonDocument::fromJson(query.queryItemValue(QStringLiteral("fields"), QUrl::FullyDecoded).toUtf8()).array();
+            QJsonArray results;
+            for (int i = offset; i < objects.count() && i < offset + limit; ++i)
+                results.append(fields.isEmpty() ? objects.at(i) : project(objects.at(i), fields));
+            result["results"] = results;
+        }
+        respond(socket, 200, result);
+    } else if (request.method == "POST" && id.isEmpty()) {
+        const QByteArray key = request.headers.value("idempotency-key");
+        if (key.isEmpty())
+            respond(socket, 201, createObject(objectType, data));
+        else if (_idempotentResults.contains(key))
+            respond(socket, 201, _idempotentResults.value(key));
+        else
+            respond(socket, 201, _idempotentResults[key] = createObject(objectType, data));
+    } else if (request.method == "PUT" && !id.isEmpty()) {
+        const QJsonObject object = updateObject(objectType, id, data);
+        respond(socket, object.isEmpty() ? 404 : 200, object);
+    } else if (request.method == "DELETE" && !id.isEmpty()) {
+        respond(socket, removeObject(objectType, id) ? 200 : 404, QJsonObject());
+    } else {
+        respond(socket, 400, QJsonObject());
+    }
+}
+
+void MockServer::handleStream(QTcpSocket *socket, const Request &request)
+{
+    if (!_streamEnabled) {
+        respond(socket, 503, QJsonObject());
+        return;
+    }
+
+    const QUrlQuery query(request.url);
+    PendingStream stream;
+    stream.socket = socket;
+    stream.objectType = query.queryItemValue(QStringLiteral("objectType"));
+    // without a cursor only changes made from now on are interesting
+    stream.cursor = query.hasQueryItem(QStringLiteral("cursor")) ? query.queryItemValue(QStringLiteral("cursor")).toInt()
+                                                                 : _events.count();
+    stream.deadline = QDateTime::currentMSecsSinceEpoch() + StreamTimeout;
+    _pendingStreams.append(stream);
+    answerStreams(false);
+}
+
+void MockServer::streamTimeout()
+{
+    answerStreams(true);
+}
+
+void MockServer::answerStreams(bool timeout)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (int i = _pendingStreams.count() - 1; i >= 0; --i) {
+        const PendingStream stream = _pendingStreams.at(i);
+        QJsonArray events;
+        for (int j = stream.cursor; j < _events.count(); ++j) {
+            if (_events.at(j)["object"].toObject()["objectType"].toString() == stream.objectType)
+                events.append(_events.at(j));
+        }
+        if (events.isEmpty() && !(timeout && now >= stream.deadline))
+            continue;
+
+        QJsonObject answer;
+        answer["cursor"] = QString::number(_events.count());
+        answer["events"] = events;
+        _pendingStreams.removeAt(i);
+        respond(stream.socket, 200, answer);
+    }
+}
+
+void MockServer::respond(QTcpSocket *socket, int status, const QJsonObject &body)
+{
+    if (!socket)
+        return;
+    const QByteArray content = QJsonDocument(body).toJson(QJsonDocument::Compact);
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + (status < 400 ? " OK" : " Error") + "\r\n";
+    response += "Content-Type: application/json\r\n";
+    response += "Content-Length: " + QByteArray::number(content.size()) + "\r\n\r\n";
+    response += content;
+    if (_holdResponses)
+        _heldResponses.append(qMakePair(QPointer<QTcpSocket>(socket), response));
+    else
+        socket->write(response);
+}
+
+void MockServer::releaseResponses()
+{
+    typedef QPair<QPointer<QTcpSocket>, QByteArray> Response;
+    foreach (const Response &response, _heldResponses) {
+        if (response.first)
+            response.first->write(response.second);
+    }
+    _heldResponses.clear();
+}
+
+void MockServer::releaseResponse(int index)
+{
+    const QPair<QPointer<QTcpSocket>, QByteArray> response = _heldResponses.takeAt(index);
+    if (response.first)
+        response.first->write(response.second);
+}
+
+void MockServer::publish(const QString &event, const QJsonObject &object)
+{
+    QJsonObject notification;
+    notification["event"] = event;
+    notification["object"] = object;
+    _events.append(notification);
+    answerStreams(false);
+}
+
+QJsonObject MockServer::createObject(const QString &objectType, QJsonObject object)
+{
+    const QString now = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    object["id"] = QString::number(++_lastId);
+    object["objectType"] = objectType;
+    object["createdAt"] = now;
+    object["updatedAt"] = now;
+    _objects[objectType].append(object);
+    publish(QStringLiteral("create"), object);
+    return object;
+}
+
+QJsonObject MockServer::updateObject(const QString &objectType, const QString &id, const QJsonObject &delta)
+{
+    const int index = indexOf(objectType, id);
+    if (index == -1)
+        return QJsonObject();
+    QJsonObject &object = _objects[objectType][index];
+    for (QJsonObject::const_iterator i = delta.constBegin(); i != delta.constEnd(); ++i)
+        object[i.key()] = i.value();
+    object["updatedAt"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    publish(QStringLiteral("update"), object);
+    return object;
+}
+
+bool MockServer::removeObject(const QString &objectType, const QString &id)
+{
+    const int index = indexOf(objectType, id);
+    if (index == -1)
+        return false;
+    publish(QStringLiteral("delete"), _objects[objectType].takeAt(index));
+    return true;
+}
+
+}
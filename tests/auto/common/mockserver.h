@@ -0,0 +1,106 @@
+#ifndef ENGINIOTESTSMOCKSERVER_H
+#define ENGINIOTESTSMOCKSERVER_H
+
+#include <QtCore/qhash.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qjsonarray.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qpair.h>
+#include <QtCore/qpointer.h>
+#include <QtCore/qurl.h>
+#include <QtNetwork/qtcpserver.h>
+
+QT_BEGIN_NAMESPACE
+class QTcpSocket;
+QT_END_NAMESPACE
+
+namespace EnginioTests
+{
+
+/*
+  Local stand-in for the Enginio backend, for tests which need to control the backend.
+
+  It keeps objects in memory and implements the subset of the REST API used by
+  EnginioClient object operations (query, create, update, remove), and the long-polling
+  notification stream "GET /v1/stream?objectType=&cursor=". Query filters are ignored.
+*/
+class MockServer: public QTcpServer
+{
+    Q_OBJECT
+
+    struct Request
+    {
+        QByteArray method;
+        QUrl url;
+        QHash<QByteArray, QByteArray> headers;
+        QByteArray body;
+    };
+
+    struct PendingStream
+    {
+        QTcpSocket *socket;
+        QString objectType;
+        int cursor;
+        qint64 deadline;
+    };
+
+    QHash<QTcpSocket*, QByteArray> _buffers;
+    QHash<QString, QList<QJsonObject> > _objects;
+    QList<QJsonObject> _events;
+    QList<PendingStream> _pendingStreams;
+    QHash<QByteArray, int> _requestCounts;
+    QList<QPair<QPointer<QTcpSocket>, QByteArray> > _heldResponses;
+    bool _holdResponses;
+    int _failures;
+    int _failureStatus;
+    int _lostResponses;
+    // created objects by the Idempotency-Key header of the request
+    QHash<QByteArray, QJsonObject> _idempotentResults;
+    bool _streamEnabled;
+    int _lastId;
+
+    void handle(QTcpSocket *socket, const Request &request);
+    void handleStream(QTcpSocket *socket, const Request &request);
+    void respond(QTcpSocket *socket, int status, const QJsonObject &body);
+    void publish(const QString &event, const QJsonObject &object);
+    void answerStreams(bool timeout);
+    int indexOf(const QString &objectType, const QString &id) const;
+    static QJsonObject project(const QJsonObject &object, const QJsonArray &fields);
+
+private slots:
+    void newConnectionAvailable();
+    void readRequests();
+    void socketDisconnected();
+    void streamTimeout();
+
+public:
+    explicit MockServer(QObject *parent = 0);
+    virtual ~MockServer();
+
+    QUrl url() const;
+
+    void setStreamEnabled(bool enabled);
+    int requestCount(const QByteArray &method) const { return _requestCounts.value(method); }
+    int waitingStreams() const { return _pendingStreams.count(); }
+
+    // keep the responses until releaseResponses() is called, to control the requests in flight
+    void setHoldResponses(bool hold) { _holdResponses = hold; }
+    int heldResponses() const { return _heldResponses.count(); }
+    void releaseResponses();
+    void releaseResponse(int index);
+
+    // answer the next object requests with the error status
+    void failNextRequests(int count, int status) { _failures = count; _failureStatus = status; }
+    // handle the next object requests but answer with 504, as if the response got lost
+    void loseNextResponses(int count) { _lostResponses = count; }
+    QList<QJsonObject> objects(const QString &objectType) const { return _objects.value(objectType); }
+
+    // modify the data behind the back of the clients, the changes are pushed to the stream
+    QJsonObject createObject(const QString &objectType, QJsonObject object);
+    QJsonObject updateObject(const QString &objectType, const QString &id, const QJsonObject &delta);
+    bool removeObject(const QString &objectType, const QString &id);
+};
+
+}
+
+#endif // ENGINIOTESTSMOCKSERVER_H
@@ -1,4 +1,4 @@
-QT       += testlib enginio
+QT       += testlib enginio network
 QT       -= gui
 
 DEFINES += TEST_FILE_PATH=\\\"$$_PRO_FILE_PWD_/../common/enginio.png\\\"
@@ -11,6 +11,9 @@ TEMPLATE = app
 
 SOURCES += \
     tst_enginioclient.cpp \
-    ../common/common.cpp
+    ../common/common.cpp \
+    ../common/mockserver.cpp
 
-HEADERS += ../common/common.h
+HEADERS += \
+    ../common/common.h \
+    ../common/mockserver.h
@@ -45,8 +45,10 @@
 #include <Enginio/enginioclient.h>
 #include <Enginio/enginioreply.h>
 #include <Enginio/enginioidentity.h>
+#include <Enginio/enginiorequestgroup.h>
 
 #include "../common/common.h"
+#include "../common/mockserver.h"
 
 #define CHECK_NO_ERROR(response) \
     QVERIFY(!response->isError()); \
@@ -102,6 +104,15 @@ private slots:
     void acl();
     void sharingNetworkManager();
     void search();
+    void requestPriorities();
+    void rateLimit();
+    void retry();
+    void idempotentCreate();
+    void hedgedReads();
+    void circuitBreaker();
+    void abortAndTimeout();
+    void requestGroup();
+    void networkManagerPool();
 
 private:
     QString usergroupId(EnginioClient *client)
@@ -1662,5 +1673,462 @@ void tst_EnginioClient::prepareForSearch()
     }
 }
 
+void tst_EnginioClient::requestPriorities()
+{
+    EnginioTests::MockServer server;
+    QVERIFY(server.isListening());
+    server.setHoldResponses(true);
+
+    EnginioClient client;
+    client.setBackendId("mockBackendId");
+    client.setBackendSecret("mockBackendSecret");
+    client.setServiceUrl(server.url());
+    client.setMaxConcurrentRequests(EnginioClient::BackgroundPriority, 1);
+    QCOMPARE(client.maxConcurrentRequests(EnginioClient::BackgroundPriority), 1);
+    QSignalSpy spy(&client, SIGNAL(finished(EnginioReply*)));
+
+    QJsonObject query;
+    query["objectType"] = QStringLiteral("objects.todos");
+    EnginioReply *bulk1 = client.query(query, EnginioClient::ObjectOperation, EnginioClient::BackgroundPriority);
+    EnginioReply *bulk2 = client.query(query, EnginioClient::ObjectOperation, EnginioClient::BackgroundPriority);
+    EnginioReply *bulk3 = client.query(query, EnginioClient::ObjectOperation, EnginioClient::BackgroundPriority);
+
+    // only one background request is sent, the others wait
+    QTRY_COMPARE(server.heldResponses(), 1);
+    QCOMPARE(client.metrics()["activeRequests"].toDouble(), 1.0);
+    QCOMPARE(client.metrics()["queuedRequests"].toDouble(), 2.0);
+
+    // an interactive request does not wait for them
+    EnginioReply *interactive = client.query(query, EnginioClient::ObjectOperation, EnginioClient::InteractivePriority);
+    QTRY_COMPARE(server.heldResponses(), 2);
+
+    // waiting requests can be dropped or moved to another priority
+    QVERIFY(client.cancelQueued(bulk3));
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(bulk3->networkError(), QNetworkReply::OperationCanceledError);
+    QVERIFY(client.setPriority(bulk2, EnginioClient::InteractivePriority));
+    QTRY_COMPARE(server.heldResponses(), 3);
+    QCOMPARE(client.metrics()["queuedRequests"].toDouble(), 0.0);
+
+    // sent requests can not be changed anymore
+    QVERIFY(!client.cancelQueued(bulk1));
+    QVERIFY(!client.setPriority(interactive, EnginioClient::BackgroundPriority));
+
+    server.setHoldResponses(false);
+    server.releaseResponses();
+    QTRY_COMPARE(spy.count(), 4);
+    CHECK_NO_ERROR(bulk1);
+    CHECK_NO_ERROR(bulk2);
+    CHECK_NO_ERROR(interactive);
+    QCOMPARE(client.metrics()["activeRequests"].toDouble(), 0.0);
+}
+
+void tst_EnginioClient::rateLimit()
+{
+    EnginioTests::MockServer server;
+    QVERIFY(server.isListening());
+
+    EnginioClient client;
+    client.setBackendId("mockBackendId");
+    client.setBackendSecret("mockBackendSecret");
+    client.setServiceUrl(server.url());
+    client.setMaxConcurrentRequests(EnginioClient::NormalPriority, 0);
+    QSignalSpy spy(&client, SIGNAL(finished(EnginioReply*)));
+    QSignalSpy saturatedSpy(&client, SIGNAL(saturatedChanged(bool)));
+    QSignalSpy rateSpy(&client, SIGNAL(maxRequestsPerSecondChanged(double)));
+
+    client.setMaxRequestsPerSecond(10);
+    QCOMPARE(client.maxRequestsPerSecond(), 10.0);
+    QCOMPARE(rateSpy.count(), 1);
+    QVERIFY(!client.isSaturated());
+
+    QElapsedTimer timer;
+    timer.start();
+    QJsonObject object;
+    object["objectType"] = QStringLiteral("objects.todos");
+    for (int i = 0; i < 20; ++i) {
+        object["title"] = QString::number(i);
+        client.create(object);
+    }
+
+    // a burst of one second worth of requests is sent, the rest waits
+    QCOMPARE(client.queueDepth(), 10);
+    QVERIFY(client.isSaturated());
+    QCOMPARE(saturatedSpy.count(), 1);
+
+    QTRY_COMPARE_WITH_TIMEOUT(spy.count(), 20, 5000);
+    QVERIFY(timer.elapsed() >= 900);
+    QCOMPARE(server.objects(QStringLiteral("objects.todos")).count(), 20);
+    QCOMPARE(client.queueDepth(), 0);
+    QVERIFY(!client.isSaturated());
+    QCOMPARE(saturatedSpy.count(), 2);
+    foreach (const QList<QVariant> &arguments, spy) {
+        EnginioReply *reply = arguments.at(0).value<EnginioReply*>();
+        CHECK_NO_ERROR(reply);
+    }
+}
+
+void tst_EnginioClient::retry()
+{
+    EnginioTests::MockServer server;
+    QVERIFY(server.isListening());
+
+    EnginioClient client;
+    client.setBackendId("mockBackendId");
+    client.setBackendSecret("mockBackendSecret");
+    client.setServiceUrl(server.url());
+    QCOMPARE(client.maxAttempts(), 3);
+    QVERIFY(client.retryStatusCodes().contains(503));
+    client.setRetryDelay(10);
+    QCOMPARE(client.retryDelay(), 10);
+    QSignalSpy spy(&client, SIGNAL(finished(EnginioReply*)));
+
+    QJsonObject query;
+    query["objectType"] = QStringLiteral("objects.todos");
+
+    // a query succeeding within the attempts finishes once, without an error
+    server.failNextRequests(2, 503);
+    EnginioReply *reply = client.query(query);
+    QTRY_COMPARE(spy.count(), 1);
+    CHECK_NO_ERROR(reply);
+    QCOMPARE(server.requestCount("GET"), 3);
+    QCOMPARE(client.metrics()["retries"].toDouble(), 2.0);
+
+    // the error of the last attempt is reported
+    server.failNextRequests(5, 503);
+    reply = client.query(query);
+    QTRY_COMPARE(spy.count(), 2);
+    QVERIFY(reply->isError());
+    QCOMPARE(reply->backendStatus(), 503);
+    QCOMPARE(server.requestCount("GET"), 6);
+    QCOMPARE(client.metrics()["retries"].toDouble(), 4.0);
+
+    // statuses which are not listed are not retried
+    server.failNextRequests(1, 400);
+    reply = client.query(query);
+    QTRY_COMPARE(spy.count(), 3);
+    QCOMPARE(reply->backendStatus(), 400);
+    QCOMPARE(server.requestCount("GET"), 7);
+
+    // creates carry an idempotency key, they are retried without creating the object twice
+    server.failNextRequests(1, 503);
+    reply = client.create(query);
+    QTRY_COMPARE(spy.count(), 4);
+    CHECK_NO_ERROR(reply);
+    QCOMPARE(server.requestCount("POST"), 2);
+    QCOMPARE(server.objects(query["objectType"].toString()).count(), 1);
+    QCOMPARE(client.metrics()["retries"].toDouble(), 5.0);
+
+    // requests which are not idempotent are not retried
+    QJsonObject object(query);
+    object["id"] = reply->data()["id"];
+    object["title"] = QStringLiteral("changed");
+    server.failNextRequests(1, 503);
+    reply = client.update(object);
+    QTRY_COMPARE(spy.count(), 5);
+    QCOMPARE(reply->backendStatus(), 503);
+    QCOMPARE(server.requestCount("PUT"), 1);
+    QCOMPARE(client.metrics()["retries"].toDouble(), 5.0);
+    server.failNextRequests(0, 0);
+}
+
+void tst_EnginioClient::idempotentCreate()
+{
+    EnginioTests::MockServer server;
+    QVERIFY(server.isListening());
+
+    EnginioClient client;
+    client.setBackendId("mockBackendId");
+    client.setBackendSecret("mockBackendSecret");
+    client.setServiceUrl(server.url());
+    client.setRetryDelay(10);
+    QSignalSpy spy(&client, SIGNAL(finished(EnginioReply*)));
+
+    const QString objectType = QStringLiteral("objects.todos");
+    QJsonObject object;
+    object["objectType"] = objectType;
+    object["title"] = QStringLiteral("once");
+
+    // the object was created, but the answer got lost
+    server.loseNextResponses(1);
+    EnginioReply *reply = client.create(object);
+    QTRY_COMPARE(spy.count(), 1);
+    CHECK_NO_ERROR(reply);
+    QCOMPARE(server.requestCount("POST"), 2);
+    QCOMPARE(server.objects(objectType).count(), 1);
+    QCOMPARE(reply->data()["id"].toString(), server.objects(objectType).first()["id"].toString());
+
+    // every create is a new object
+    reply = client.create(object);
+    QTRY_COMPARE(spy.count(), 2);
+    CHECK_NO_ERROR(reply);
+    QCOMPARE(server.objects(objectType).count(), 2);
+}
+
+void tst_EnginioClient::hedgedReads()
+{
+    EnginioTests::MockServer server;
+    QVERIFY(server.isListening());
+
+    EnginioClient client;
+    client.setBackendId("mockBackendId");
+    client.setBackendSecret("mockBackendSecret");
+    client.setServiceUrl(server.url());
+    QVERIFY(!client.hedgedReads());
+    client.setHedgedReads(true);
+    QSignalSpy spy(&client, SIGNAL(finished(EnginioReply*)));
+
+    QJsonObject query;
+    query["objectType"] = QStringLiteral("objects.todos");
+
+    // without enough samples of the response time no duplicate is sent
+    for (int i = 1; i <= 20; ++i) {
+        EnginioReply *reply = client.query(query);
+        QTRY_COMPARE(spy.count(), i);
+        CHECK_NO_ERROR(reply);
+    }
+    QCOMPARE(server.requestCount("GET"), 20);
+    QCOMPARE(client.metrics()["hedges"].toDouble(), 0.0);
+    QVERIFY(client.metrics()["readLatencyP95"].toDouble() > 0);
+
+    // a slow query is sent again and the duplicate which answers first is used
+    server.setHoldResponses(true);
+    EnginioReply *reply = client.query(query);
+    QTRY_COMPARE(server.heldResponses(), 2);
+    QCOMPARE(client.metrics()["hedges"].toDouble(), 1.0);
+    server.releaseResponse(1);
+    QTRY_COMPARE(spy.count(), 21);
+    CHECK_NO_ERROR(reply);
+    QCOMPARE(client.metrics()["hedgeWins"].toDouble(), 1.0);
+
+    server.releaseResponses();
+    QTest::qWait(50);
+    QCOMPARE(spy.count(), 21);
+    QCOMPARE(client.metrics()["activeRequests"].toDouble(), 0.0);
+    server.setHoldResponses(false);
+}
+
+void tst_EnginioClient::circuitBreaker()
+{
+    EnginioTests::MockServer server;
+    QVERIFY(server.isListening());
+
+    EnginioClient client;
+    client.setBackendId("mockBackendId");
+    client.setBackendSecret("mockBackendSecret");
+    client.setServiceUrl(server.url());
+    client.setMaxAttempts(1);
+    QCOMPARE(client.circuitBreakerThreshold(), 0.5);
+    client.setCircuitBreakerTimeout(200);
+    QSignalSpy spy(&client, SIGNAL(finished(EnginioReply*)));
+
+    QJsonObject query;
+    query["objectType"] = QStringLiteral("objects.todos");
+
+    // the circuit opens after enough failed requests
+    server.failNextRequests(10, 503);
+    for (int i = 1; i <= 10; ++i) {
+        client.query(query);
+        QTRY_COMPARE(spy.count(), i);
+    }
+    QCOMPARE(server.requestCount("GET"), 10);
+    QCOMPARE(client.metrics()["openCircuits"].toDouble(), 1.0);
+
+    // while it is open requests fail without being sent
+    EnginioReply *reply = client.query(query);
+    QTRY_COMPARE(spy.count(), 11);
+    QVERIFY(reply->isError());
+    QCOMPARE(reply->backendStatus(), 503);
+    QCOMPARE(server.requestCount("GET"), 10);
+    QCOMPARE(client.metrics()["rejectedRequests"].toDouble(), 1.0);
+
+    // a failing probe keeps it open
+    QTest::qWait(250);
+    server.failNextRequests(1, 503);
+    client.query(query);
+    reply = client.query(query);
+    QTRY_COMPARE(spy.count(), 13);
+    QCOMPARE(server.requestCount("GET"), 11);
+    QCOMPARE(reply->backendStatus(), 503);
+    QCOMPARE(client.metrics()["rejectedRequests"].toDouble(), 2.0);
+
+    // a successful probe closes it
+    QTest::qWait(250);
+    reply = client.query(query);
+    QTRY_COMPARE(spy.count(), 14);
+    CHECK_NO_ERROR(reply);
+    QCOMPARE(client.metrics()["openCircuits"].toDouble(), 0.0);
+    reply = client.query(query);
+    QTRY_COMPARE(spy.count(), 15);
+    CHECK_NO_ERROR(reply);
+    QCOMPARE(server.requestCount("GET"), 13);
+}
+
+void tst_EnginioClient::abortAndTimeout()
+{
+    EnginioTests::MockServer server;
+    QVERIFY(server.isListening());
+
+    EnginioClient client;
+    client.setBackendId("mockBackendId");
+    client.setBackendSecret("mockBackendSecret");
+    client.setServiceUrl(server.url());
+    client.setMaxConcurrentRequests(EnginioClient::NormalPriority, 1);
+    QSignalSpy spy(&client, SIGNAL(finished(EnginioReply*)));
+    QSignalSpy errorSpy(&client, SIGNAL(error(EnginioReply*)));
+
+    QJsonObject query;
+    query["objectType"] = QStringLiteral("objects.todos");
+
+    // aborting a sent request frees its slot for the queued one
+    server.setHoldResponses(true);
+    EnginioReply *sent = client.query(query);
+    EnginioReply *queued = client.query(query);
+    QTRY_COMPARE(server.heldResponses(), 1);
+    QCOMPARE(client.queueDepth(), 1);
+    sent->abort();
+    QCOMPARE(client.queueDepth(), 0);
+    QTRY_COMPARE(spy.count(), 1);
+    QCOMPARE(sent->networkError(), QNetworkReply::OperationCanceledError);
+    QCOMPARE(errorSpy.count(), 1);
+
+    // so is the request sent in its place
+    QTRY_COMPARE(server.heldResponses(), 2);
+    queued->abort();
+    QTRY_COMPARE(spy.count(), 2);
+    QCOMPARE(queued->networkError(), QNetworkReply::OperationCanceledError);
+
+    // the deadline covers the whole request
+    client.setRequestTimeout(50);
+    EnginioReply *reply = client.query(query);
+    QCOMPARE(reply->timeout(), 50);
+    QTRY_COMPARE(spy.count(), 3);
+    QCOMPARE(reply->networkError(), QNetworkReply::TimeoutError);
+    QCOMPARE(reply->errorType(), EnginioReply::NetworkError);
+    QCOMPARE(client.metrics()["timedOutRequests"].toDouble(), 1.0);
+    QCOMPARE(client.metrics()["activeRequests"].toDouble(), 0.0);
+
+    // late answers and aborts of finished replies are ignored
+    server.releaseResponses();
+    server.setHoldResponses(false);
+    reply->abort();
+    reply = client.query(query);
+    QTRY_COMPARE(spy.count(), 4);
+    CHECK_NO_ERROR(reply);
+    reply->abort();
+    QTest::qWait(100);
+    QCOMPARE(spy.count(), 4);
+    CHECK_NO_ERROR(reply);
+}
+
+void tst_EnginioClient::requestGroup()
+{
+    EnginioTests::MockServer server;
+    QVERIFY(server.isListening());
+
+    EnginioClient client;
+    client.setBackendId("mockBackendId");
+    client.setBackendSecret("mockBackendSecret");
+    client.setServiceUrl(server.url());
+    QSignalSpy spy(&client, SIGNAL(finished(EnginioReply*)));
+
+    EnginioRequestGroup group;
+    QSignalSpy groupSpy(&group, SIGNAL(finished()));
+
+    QJsonObject query;
+    query["objectType"] = QStringLiteral("objects.todos");
+
+    // requests made while the group is set belong to it
+    client.setRequestGroup(&group);
+    client.query(query);
+    client.query(query);
+    client.setRequestGroup(0);
+    EnginioReply *other = client.query(query);
+    QCOMPARE(group.count(), 2);
+    QVERIFY(group.isActive());
+    QTRY_COMPARE(spy.count(), 3);
+    QCOMPARE(groupSpy.count(), 1);
+    QCOMPARE(group.finishedCount(), 2);
+    QVERIFY(!group.isActive());
+
+    // finished replies are not added
+    group.add(other);
+    QCOMPARE(group.count(), 2);
+
+    // cancelling drops the queued and sent requests
+    server.setHoldResponses(true);
+    client.setMaxConcurrentRequests(EnginioClient::NormalPriority, 1);
+    EnginioReply *sent = client.query(query);
+    EnginioReply *queued = client.query(query);
+    group.add(sent);
+    group.add(queued);
+    QCOMPARE(group.count(), 2);
+    QCOMPARE(group.finishedCount(), 0);
+    QTRY_COMPARE(server.heldResponses(), 1);
+    group.cancelAll();
+    QTRY_COMPARE(groupSpy.count(), 2);
+    QCOMPARE(spy.count(), 5);
+    QCOMPARE(sent->networkError(), QNetworkReply::OperationCanceledError);
+    QCOMPARE(queued->networkError(), QNetworkReply::OperationCanceledError);
+    QCOMPARE(client.metrics()["activeRequests"].toDouble(), 0.0);
+    QCOMPARE(client.queueDepth(), 0);
+    server.setHoldResponses(false);
+    server.releaseResponses();
+}
+
+void tst_EnginioClient::networkManagerPool()
+{
+    EnginioTests::MockServer server;
+    QVERIFY(server.isListening());
+
+    EnginioClient client;
+    client.setBackendId("mockBackendId");
+    client.setBackendSecret("mockBackendSecret");
+    client.setServiceUrl(server.url());
+    client.setMaxConcurrentRequests(EnginioClient::NormalPriority, 0);
+    QCOMPARE(client.networkManagerCount(), 1);
+    QVERIFY(client.reserveInteractiveManager());
+    QSignalSpy spy(&client, SIGNAL(finished(EnginioReply*)));
+
+    QJsonObject query;
+    query["objectType"] = QStringLiteral("objects.todos");
+
+    // a single manager opens six connections to the server
+    server.setHoldResponses(true);
+    for (int i = 0; i < 8; ++i)
+        client.query(query);
+    QTRY_COMPARE(server.heldResponses(), 6);
+    QTest::qWait(50);
+    QCOMPARE(server.heldResponses(), 6);
+    server.releaseResponses();
+    QTRY_COMPARE(server.heldResponses(), 2);
+    server.releaseResponses();
+    QTRY_COMPARE(spy.count(), 8);
+
+    // the first of two managers is kept for interactive requests
+    client.setNetworkManagerCount(2);
+    QCOMPARE(client.networkManagerCount(), 2);
+    QVERIFY(client.networkManager());
+    for (int i = 0; i < 8; ++i)
+        client.query(query);
+    QTRY_COMPARE(server.heldResponses(), 6);
+    client.query(query, EnginioClient::ObjectOperation, EnginioClient::InteractivePriority);
+    QTRY_COMPARE(server.heldResponses(), 7);
+    server.releaseResponses();
+    QTRY_COMPARE(server.heldResponses(), 2);
+    server.releaseResponses();
+    QTRY_COMPARE(spy.count(), 17);
+
+    // without the reservation all managers take bulk requests
+    client.setReserveInteractiveManager(false);
+    for (int i = 0; i < 8; ++i)
+        client.query(query);
+    QTRY_COMPARE(server.heldResponses(), 8);
+    server.releaseResponses();
+    QTRY_COMPARE(spy.count(), 25);
+    CHECK_NO_ERROR(spy.last().at(0).value<EnginioReply*>());
+    server.setHoldResponses(false);
+}
+
 QTEST_MAIN(tst_EnginioClient)
 #include "tst_enginioclient.moc"
@@ -1,4 +1,4 @@
-QT       += testlib enginio widgets
+QT       += testlib enginio widgets network
 
 DEFINES += TEST_FILE_PATH=\\\"$$_PRO_FILE_PWD_/../common/enginio.png\\\"
 
@@ -10,6 +10,9 @@ TEMPLATE = app
 
 SOURCES += \
     tst_enginiomodel.cpp \
-    ../common/common.cpp
+    ../common/common.cpp \
+    ../common/mockserver.cpp
 
-HEADERS += ../common/common.h
+HEADERS += \
+    ../common/common.h \
+    ../common/mockserver.h
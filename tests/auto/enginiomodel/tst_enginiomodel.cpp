@@ -51,6 +51,7 @@
 #include <Enginio/enginioidentity.h>
 
 #include "../common/common.h"
+#include "../common/mockserver.h"
 
 class tst_EnginioModel: public QObject
 {
@@ -81,6 +82,17 @@ private slots:
     void invalidRemove();
     void invalidSetProperty();
     void multpleConnections();
+    void writeBehind();
+    void bulkAppendAndRemove();
+    void prefetch();
+    void shardedInitialLoad();
+    void keysetPaging();
+    void deltaSync();
+    void realtimeUpdates();
+    void sharedObjects();
+    void pageEviction();
+    void fieldProjection();
+    void declaredRoles();
 };
 
 void tst_EnginioModel::initTestCase()
@@ -434,13 +446,16 @@ void tst_EnginioModel::multpleConnections()
         QCOMPARE(model.counter["queryChanged"], 0);
         QCOMPARE(model.counter["enginioChanged"], 0);
 
+        // The model listens to its own replies only, it should never connect to the client's
+        // finished signal.
+        QCOMPARE(client1.counter["finished"], 0);
+        QCOMPARE(client2.counter["finished"], 0);
+
         // All of them are acctually disconnected but disconnectNotify is not called, it is
         // a known bug in Qt.
-        QCOMPARE(client1.counter["finished"], 20);
         QCOMPARE(client1.counter["backendIdChanged"], 20);
         QCOMPARE(client1.counter["backendSecretChanged"], 20);
         QCOMPARE(client1.counter["destroyed"], 20);
-        QCOMPARE(client2.counter["finished"], 20);
         QCOMPARE(client2.counter["backendIdChanged"], 20);
         QCOMPARE(client2.counter["backendSecretChanged"], 20);
         QCOMPARE(client2.counter["destroyed"], 20);
@@ -493,5 +508,613 @@ void tst_EnginioModel::multpleConnections()
     }
 }
 
+void tst_EnginioModel::writeBehind()
+{
+    EnginioClient client;
+    QObject::connect(&client, SIGNAL(error(EnginioReply *)), this, SLOT(error(EnginioReply *)));
+    client.setBackendId(_backendId);
+    client.setBackendSecret(_backendSecret);
+    client.setServiceUrl(EnginioTests::TESTAPP_URL);
+
+    EnginioModel model;
+    QSignalSpy intervalSpy(&model, SIGNAL(writeBehindIntervalChanged(int)));
+    model.setWriteBehindInterval(300);
+    QCOMPARE(model.writeBehindInterval(), 300);
+    QCOMPARE(intervalSpy.count(), 1);
+
+    model.setOperation(EnginioClient::UserOperation);
+    model.setQuery(QJsonDocument::fromJson("{\"limit\":1}").object());
+    model.setEnginio(&client);
+    QTRY_COMPARE(model.rowCount(), 1);
+
+    const int syncedRole = model.roleNames().key("_synced");
+    const QString username = model.data(model.index(0)).value<QJsonValue>().toObject()["username"].toString();
+    QVERIFY(!username.isEmpty());
+
+    QSignalSpy clientSpy(&client, SIGNAL(finished(EnginioReply*)));
+
+    // both changes are merged into one update request
+    EnginioReply *reply1 = model.setProperty(0, "username", username + QStringLiteral("_tmp"));
+    EnginioReply *reply2 = model.setProperty(0, "username", username);
+    QVERIFY(reply1);
+    QCOMPARE(reply1, reply2);
+    QVERIFY(!model.data(model.index(0), syncedRole).toBool());
+    QCOMPARE(model.data(model.index(0)).value<QJsonValue>().toObject()["username"].toString(), username);
+
+    QSignalSpy replySpy(reply1, SIGNAL(finished(EnginioReply*)));
+    QTRY_COMPARE(replySpy.count(), 1);
+    QVERIFY(!reply1->isError());
+    QCOMPARE(clientSpy.count(), 1);
+    QTRY_VERIFY(model.data(model.index(0), syncedRole).toBool());
+    QCOMPARE(model.data(model.index(0)).value<QJsonValue>().toObject()["username"].toString(), username);
+}
+
+void tst_EnginioModel::bulkAppendAndRemove()
+{
+    EnginioClient client;
+    QObject::connect(&client, SIGNAL(error(EnginioReply *)), this, SLOT(error(EnginioReply *)));
+    client.setBackendId(_backendId);
+    client.setBackendSecret(_backendSecret);
+    client.setServiceUrl(EnginioTests::TESTAPP_URL);
+
+    const int count = 10;
+    const QString prefix = QStringLiteral("bulkuser") + QString::number(QDateTime::currentMSecsSinceEpoch());
+    QJsonArray users;
+    QJsonArray usernames;
+    for (int i = 0; i < count; ++i) {
+        QJsonObject user;
+        user["username"] = prefix + QString::number(i);
+        user["password"] = prefix + QString::number(i);
+        users.append(user);
+        usernames.append(user["username"]);
+    }
+    QJsonObject in;
+    in["$in"] = usernames;
+    QJsonObject filter;
+    filter["username"] = in;
+    QJsonObject query;
+    query["query"] = filter;
+
+    EnginioModel model;
+    model.setOperation(EnginioClient::UserOperation);
+    model.setQuery(query);
+    QSignalSpy resetSpy(&model, SIGNAL(modelReset()));
+    model.setEnginio(&client);
+    QTRY_COMPARE(resetSpy.count(), 1);
+    QCOMPARE(model.rowCount(), 0);
+
+    QSignalSpy clientSpy(&client, SIGNAL(finished(EnginioReply*)));
+    QSignalSpy clientErrorSpy(&client, SIGNAL(error(EnginioReply*)));
+    QSignalSpy insertSpy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy removeSpy(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+
+    // all rows are added with a single model change
+    QList<EnginioReply*> replies = model.appendRows(users);
+    QCOMPARE(replies.count(), count);
+    QCOMPARE(model.rowCount(), count);
+    QCOMPARE(resetSpy.count() + insertSpy.count(), 2);
+
+    QTRY_COMPARE(clientSpy.count(), count);
+    QCOMPARE(clientErrorSpy.count(), 0);
+    const int syncedRole = model.roleNames().key("_synced");
+    for (int i = 0; i < count; ++i) {
+        QVERIFY(model.data(model.index(i), syncedRole).toBool());
+        QVERIFY(!model.data(model.index(i)).value<QJsonValue>().toObject()["id"].toString().isEmpty());
+    }
+
+    // and removed with a single model change as well, before the requests finish
+    QVERIFY(!model.removeRows(0, count + 1));
+    QVERIFY(model.removeRows(0, count));
+    QCOMPARE(removeSpy.count(), 1);
+    QCOMPARE(model.rowCount(), 0);
+    QTRY_COMPARE(clientSpy.count(), 2 * count);
+    QCOMPARE(clientErrorSpy.count(), 0);
+    QCOMPARE(model.rowCount(), 0);
+}
+
+void tst_EnginioModel::prefetch()
+{
+    EnginioClient client;
+    QObject::connect(&client, SIGNAL(error(EnginioReply *)), this, SLOT(error(EnginioReply *)));
+    client.setBackendId(_backendId);
+    client.setBackendSecret(_backendSecret);
+    client.setServiceUrl(EnginioTests::TESTAPP_URL);
+
+    EnginioModel model;
+    QSignalSpy prefetchSpy(&model, SIGNAL(prefetchPagesChanged(int)));
+    model.setPrefetchPages(2);
+    QCOMPARE(model.prefetchPages(), 2);
+    QCOMPARE(prefetchSpy.count(), 1);
+
+    model.setOperation(EnginioClient::UserOperation);
+    model.setQuery(QJsonDocument::fromJson("{\"pageSize\":1, \"sort\":[{\"sortBy\":\"createdAt\",\"direction\":\"asc\"}]}").object());
+    model.setEnginio(&client);
+    QTRY_COMPARE(model.rowCount(), 1);
+
+    // accessing a row keeps two more pages requested
+    QVERIFY(model.data(model.index(0)).isValid());
+    QTRY_COMPARE(model.rowCount(), 3);
+    QVERIFY(model.data(model.index(2)).isValid());
+    QTRY_COMPARE(model.rowCount(), 5);
+
+    // pages are inserted in order
+    QString previousCreatedAt;
+    for (int i = 0; i < model.rowCount(); ++i) {
+        const QString createdAt = model.data(model.index(i)).value<QJsonValue>().toObject()["createdAt"].toString();
+        QVERIFY(createdAt >= previousCreatedAt);
+        previousCreatedAt = createdAt;
+    }
+}
+
+void tst_EnginioModel::shardedInitialLoad()
+{
+    EnginioClient client;
+    QObject::connect(&client, SIGNAL(error(EnginioReply *)), this, SLOT(error(EnginioReply *)));
+    client.setBackendId(_backendId);
+    client.setBackendSecret(_backendSecret);
+    client.setServiceUrl(EnginioTests::TESTAPP_URL);
+
+    const QJsonObject query = QJsonDocument::fromJson("{\"sort\":[{\"sortBy\":\"createdAt\",\"direction\":\"asc\"}]}").object();
+
+    EnginioModel reference;
+    reference.setOperation(EnginioClient::UserOperation);
+    reference.setQuery(query);
+    reference.setEnginio(&client);
+
+    EnginioModel model;
+    QSignalSpy shardsSpy(&model, SIGNAL(initialLoadShardsChanged(int)));
+    model.setInitialLoadShards(3);
+    QCOMPARE(model.initialLoadShards(), 3);
+    QCOMPARE(shardsSpy.count(), 1);
+    model.setOperation(EnginioClient::UserOperation);
+    model.setQuery(query);
+    model.setEnginio(&client);
+
+    QTRY_VERIFY(reference.rowCount() >= 5);
+    QTRY_COMPARE(model.rowCount(), reference.rowCount());
+    for (int i = 0; i < model.rowCount(); ++i) {
+        QCOMPARE(model.data(model.index(i)).value<QJsonValue>().toObject()["id"],
+                 reference.data(reference.index(i)).value<QJsonValue>().toObject()["id"]);
+    }
+}
+
+void tst_EnginioModel::keysetPaging()
+{
+    EnginioClient client;
+    QObject::connect(&client, SIGNAL(error(EnginioReply *)), this, SLOT(error(EnginioReply *)));
+    client.setBackendId(_backendId);
+    client.setBackendSecret(_backendSecret);
+    client.setServiceUrl(EnginioTests::TESTAPP_URL);
+
+    EnginioModel reference;
+    reference.setOperation(EnginioClient::UserOperation);
+    reference.setQuery(QJsonDocument::fromJson("{\"sort\":[{\"sortBy\":\"createdAt\",\"direction\":\"asc\"}]}").object());
+    reference.setEnginio(&client);
+
+    qRegisterMetaType<EnginioModel::PagingMode>();
+    EnginioModel model;
+    QSignalSpy modeSpy(&model, SIGNAL(pagingModeChanged(EnginioModel::PagingMode)));
+    model.setPagingMode(EnginioModel::KeysetPaging);
+    QCOMPARE(model.pagingMode(), EnginioModel::KeysetPaging);
+    QCOMPARE(modeSpy.count(), 1);
+    model.setOperation(EnginioClient::UserOperation);
+    model.setQuery(QJsonDocument::fromJson("{\"pageSize\":2}").object());
+    model.setEnginio(&client);
+    QTRY_COMPARE(model.rowCount(), 2);
+
+    // fetch everything, page by page
+    QTRY_VERIFY(reference.rowCount() >= 5);
+    while (model.canFetchMore(QModelIndex())) {
+        const int rowCount = model.rowCount();
+        model.fetchMore(QModelIndex());
+        QTRY_VERIFY(model.rowCount() > rowCount || !model.canFetchMore(QModelIndex()));
+    }
+
+    // the same rows in the same order, none of them twice
+    QCOMPARE(model.rowCount(), reference.rowCount());
+    QSet<QString> ids;
+    for (int i = 0; i < model.rowCount(); ++i) {
+        const QString id = model.data(model.index(i)).value<QJsonValue>().toObject()["id"].toString();
+        QVERIFY(!ids.contains(id));
+        ids.insert(id);
+        QCOMPARE(id, reference.data(reference.index(i)).value<QJsonValue>().toObject()["id"].toString());
+    }
+}
+
+void tst_EnginioModel::deltaSync()
+{
+    EnginioClient client;
+    QObject::connect(&client, SIGNAL(error(EnginioReply *)), this, SLOT(error(EnginioReply *)));
+    client.setBackendId(_backendId);
+    client.setBackendSecret(_backendSecret);
+    client.setServiceUrl(EnginioTests::TESTAPP_URL);
+
+    const QString prefix = QStringLiteral("syncuser") + QString::number(QDateTime::currentMSecsSinceEpoch());
+    QJsonArray usernames;
+    for (int i = 0; i < 5; ++i)
+        usernames.append(prefix + QString::number(i));
+
+    QList<EnginioReply*> replies;
+    for (int i = 0; i < 3; ++i) {
+        QJsonObject user;
+        user["username"] = usernames.at(i);
+        user["password"] = usernames.at(i);
+        replies.append(client.create(user, EnginioClient::UserOperation));
+    }
+    foreach (EnginioReply *reply, replies) {
+        QTRY_VERIFY(reply->isFinished());
+        QVERIFY(!reply->isError());
+    }
+
+    QJsonObject in;
+    in["$in"] = usernames;
+    QJsonObject filter;
+    filter["username"] = in;
+    QJsonObject query;
+    query["query"] = filter;
+
+    EnginioModel model;
+    QSignalSpy intervalSpy(&model, SIGNAL(syncIntervalChanged(int)));
+    model.setSyncInterval(60000);
+    QCOMPARE(model.syncInterval(), 60000);
+    QCOMPARE(intervalSpy.count(), 1);
+    model.setSyncInterval(0);
+    model.setOperation(EnginioClient::UserOperation);
+    model.setQuery(query);
+    model.setEnginio(&client);
+    QTRY_COMPARE(model.rowCount(), 3);
+
+    QSignalSpy resetSpy(&model, SIGNAL(modelReset()));
+    QSignalSpy insertSpy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy removeSpy(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+
+    // rename one user, remove another and create a new one behind the model's back
+    QJsonObject renamed = replies.at(0)->data();
+    renamed["username"] = usernames.at(3);
+    QJsonObject update;
+    update["id"] = renamed["id"];
+    update["username"] = renamed["username"];
+    EnginioReply *updateReply = client.update(update, EnginioClient::UserOperation);
+    QJsonObject removed;
+    removed["id"] = replies.at(1)->data()["id"];
+    EnginioReply *removeReply = client.remove(removed, EnginioClient::UserOperation);
+    QJsonObject created;
+    created["username"] = usernames.at(4);
+    created["password"] = usernames.at(4);
+    EnginioReply *createReply = client.create(created, EnginioClient::UserOperation);
+    QTRY_VERIFY(updateReply->isFinished() && removeReply->isFinished() && createReply->isFinished());
+    QVERIFY(!updateReply->isError());
+    QVERIFY(!removeReply->isError());
+    QVERIFY(!createReply->isError());
+
+    // the removal is detected last, after the changed objects were patched in
+    model.synchronize();
+    QTRY_COMPARE(removeSpy.count(), 1);
+    QCOMPARE(insertSpy.count(), 1);
+    QCOMPARE(model.rowCount(), 3);
+    QSet<QString> names;
+    for (int i = 0; i < model.rowCount(); ++i)
+        names.insert(model.data(model.index(i)).value<QJsonValue>().toObject()["username"].toString());
+    QVERIFY(names.contains(usernames.at(2).toString()));
+    QVERIFY(names.contains(usernames.at(3).toString()));
+    QVERIFY(names.contains(usernames.at(4).toString()));
+
+    // the rows were patched, not reloaded
+    QCOMPARE(resetSpy.count(), 0);
+}
+
+void tst_EnginioModel::realtimeUpdates()
+{
+    EnginioTests::MockServer server;
+    QVERIFY(server.isListening());
+
+    const QString objectType = QStringLiteral("objects.todos");
+    QJsonObject todo;
+    todo["title"] = QStringLiteral("first");
+    const QJsonObject first = server.createObject(objectType, todo);
+    todo["title"] = QStringLiteral("second");
+    const QJsonObject second = server.createObject(objectType, todo);
+
+    EnginioClient client;
+    client.setBackendId("mockBackendId");
+    client.setBackendSecret("mockBackendSecret");
+    client.setServiceUrl(server.url());
+
+    QJsonObject query;
+    query["objectType"] = objectType;
+
+    EnginioModel model1;
+    QSignalSpy realtimeSpy(&model1, SIGNAL(realtimeUpdatesChanged(bool)));
+    model1.setRealtimeUpdates(true);
+    QVERIFY(model1.realtimeUpdates());
+    QCOMPARE(realtimeSpy.count(), 1);
+    model1.setQuery(query);
+    model1.setEnginio(&client);
+
+    EnginioModel model2;
+    model2.setRealtimeUpdates(true);
+    model2.setQuery(query);
+    model2.setEnginio(&client);
+
+    QTRY_COMPARE(model1.rowCount(), 2);
+    QTRY_COMPARE(model2.rowCount(), 2);
+    // both models share one subscription
+    QTRY_COMPARE(server.waitingStreams(), 1);
+
+    const int titleRole = model1.roleNames().key("title");
+    QJsonObject delta;
+    delta["title"] = QStringLiteral("changed");
+    server.updateObject(objectType, first["id"].toString(), delta);
+    QTRY_COMPARE(model1.data(model1.index(0), titleRole).value<QJsonValue>().toString(), QStringLiteral("changed"));
+    QTRY_COMPARE(model2.data(model2.index(0), titleRole).value<QJsonValue>().toString(), QStringLiteral("changed"));
+
+    todo["title"] = QStringLiteral("third");
+    server.createObject(objectType, todo);
+    QTRY_COMPARE(model1.rowCount(), 3);
+    QTRY_COMPARE(model2.rowCount(), 3);
+
+    server.removeObject(objectType, second["id"].toString());
+    QTRY_COMPARE(model1.rowCount(), 2);
+    QTRY_COMPARE(model2.rowCount(), 2);
+
+    // while the channel is down the models poll for changes
+    server.setStreamEnabled(false);
+    todo["title"] = QStringLiteral("fourth");
+    server.createObject(objectType, todo);
+    QTRY_COMPARE_WITH_TIMEOUT(model1.rowCount(), 3, 15000);
+    QTRY_COMPARE_WITH_TIMEOUT(model2.rowCount(), 3, 15000);
+
+    // and the channel recovers
+    server.setStreamEnabled(true);
+    todo["title"] = QStringLiteral("fifth");
+    server.createObject(objectType, todo);
+    QTRY_COMPARE_WITH_TIMEOUT(model1.rowCount(), 4, 35000);
+    QTRY_COMPARE_WITH_TIMEOUT(model2.rowCount(), 4, 35000);
+}
+
+void tst_EnginioModel::sharedObjects()
+{
+    EnginioTests::MockServer server;
+    QVERIFY(server.isListening());
+
+    const QString objectType = QStringLiteral("objects.todos");
+    for (int i = 0; i < 3; ++i) {
+        QJsonObject todo;
+        todo["title"] = QString::number(i);
+        todo["done"] = i == 2;
+        server.createObject(objectType, todo);
+    }
+
+    EnginioClient client;
+    client.setBackendId("mockBackendId");
+    client.setBackendSecret("mockBackendSecret");
+    client.setServiceUrl(server.url());
+
+    // "all todos" and a model showing a part of them
+    QJsonObject allQuery;
+    allQuery["objectType"] = objectType;
+    EnginioModel all;
+    all.setQuery(allQuery);
+    all.setEnginio(&client);
+
+    QJsonObject partQuery(allQuery);
+    partQuery["limit"] = 2;
+    EnginioModel part;
+    part.setQuery(partQuery);
+    part.setEnginio(&client);
+
+    QTRY_COMPARE(all.rowCount(), 3);
+    QTRY_COMPARE(part.rowCount(), 2);
+
+    const int titleRole = all.roleNames().key("title");
+    QSignalSpy dataChangedSpy(&part, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+
+    // a change made through one model is visible in the other one immediately
+    EnginioReply *reply = all.setProperty(1, "title", QStringLiteral("changed"));
+    QVERIFY(reply);
+    QCOMPARE(dataChangedSpy.count(), 1);
+    QCOMPARE(dataChangedSpy.at(0).at(0).value<QModelIndex>().row(), 1);
+    QCOMPARE(part.data(part.index(1), titleRole).value<QJsonValue>().toString(), QStringLiteral("changed"));
+
+    QSignalSpy replySpy(reply, SIGNAL(finished(EnginioReply*)));
+    QTRY_COMPARE(replySpy.count(), 1);
+    QVERIFY(!reply->isError());
+    QCOMPARE(part.data(part.index(1), titleRole).value<QJsonValue>().toString(), QStringLiteral("changed"));
+    QCOMPARE(server.objects(objectType).at(1)["title"].toString(), QStringLiteral("changed"));
+
+    // the objects are cached once, property names are shared by them
+    const QJsonObject metrics = client.metrics();
+    QCOMPARE(metrics["cachedObjects"].toDouble(), 3.0);
+    QVERIFY(metrics["internedStrings"].toDouble() > 0);
+    QVERIFY(metrics["internedBytesSaved"].toDouble() > 0);
+}
+
+void tst_EnginioModel::pageEviction()
+{
+    EnginioTests::MockServer server;
+    QVERIFY(server.isListening());
+
+    const QString objectType = QStringLiteral("objects.todos");
+    for (int i = 0; i < 10; ++i) {
+        QJsonObject todo;
+        todo["title"] = QString::number(i);
+        server.createObject(objectType, todo);
+    }
+
+    EnginioClient client;
+    client.setBackendId("mockBackendId");
+    client.setBackendSecret("mockBackendSecret");
+    client.setServiceUrl(server.url());
+
+    QJsonObject query;
+    query["objectType"] = objectType;
+    query["pageSize"] = 2;
+
+    EnginioModel model;
+    QSignalSpy residentSpy(&model, SIGNAL(maxResidentRowsChanged(int)));
+    model.setMaxResidentRows(4);
+    QCOMPARE(model.maxResidentRows(), 4);
+    QCOMPARE(residentSpy.count(), 1);
+    model.setQuery(query);
+    model.setEnginio(&client);
+    QTRY_COMPARE(model.rowCount(), 2);
+
+    while (model.canFetchMore(QModelIndex())) {
+        const int rowCount = model.rowCount();
+        model.fetchMore(QModelIndex());
+        QTRY_VERIFY(model.rowCount() > rowCount || !model.canFetchMore(QModelIndex()));
+    }
+    QCOMPARE(model.rowCount(), 10);
+
+    // only the two most recent pages are in memory, the rows of the others keep their slots
+    const int titleRole = model.roleNames().key("title");
+    QVERIFY(model.data(model.index(9), titleRole).isValid());
+    QVERIFY(model.data(model.index(7), titleRole).isValid());
+
+    // accessing an evicted row brings its page back
+    QSignalSpy dataChangedSpy(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+    QVERIFY(!model.data(model.index(0), titleRole).isValid());
+    QTRY_COMPARE(dataChangedSpy.count(), 1);
+    QCOMPARE(model.data(model.index(0), titleRole).value<QJsonValue>().toString(), QStringLiteral("0"));
+    QCOMPARE(model.data(model.index(1), titleRole).value<QJsonValue>().toString(), QStringLiteral("1"));
+    QCOMPARE(model.rowCount(), 10);
+
+    // and pushes the least recently used one out
+    QVERIFY(model.data(model.index(7), titleRole).isValid());
+    QVERIFY(!model.data(model.index(9), titleRole).isValid());
+}
+
+void tst_EnginioModel::fieldProjection()
+{
+    EnginioTests::MockServer server;
+    QVERIFY(server.isListening());
+
+    const QString objectType = QStringLiteral("objects.todos");
+    for (int i = 0; i < 3; ++i) {
+        QJsonObject todo;
+        todo["title"] = QString::number(i);
+        todo["description"] = QStringLiteral("A long description which is not shown in the list");
+        server.createObject(objectType, todo);
+    }
+
+    EnginioClient client;
+    client.setBackendId("mockBackendId");
+    client.setBackendSecret("mockBackendSecret");
+    client.setServiceUrl(server.url());
+
+    QJsonObject query;
+    query["objectType"] = objectType;
+    QJsonArray fields;
+    fields.append(QStringLiteral("title"));
+    query["fields"] = fields;
+
+    EnginioModel model;
+    QSignalSpy projectionSpy(&model, SIGNAL(fieldProjectionChanged(bool)));
+    model.setFieldProjection(true);
+    QVERIFY(model.fieldProjection());
+    QCOMPARE(projectionSpy.count(), 1);
+    model.setQuery(query);
+    model.setEnginio(&client);
+    QTRY_COMPARE(model.rowCount(), 3);
+
+    // only the requested and the system properties are downloaded
+    QVERIFY(model.roleNames().key("title"));
+    QVERIFY(!model.roleNames().key("description"));
+    QJsonObject object = model.data(model.index(1), Qt::DisplayRole).value<QJsonValue>().toObject();
+    QCOMPARE(object["title"].toString(), QStringLiteral("1"));
+    QVERIFY(!object["id"].toString().isEmpty());
+    QVERIFY(!object.contains("description"));
+
+    // the whole object is fetched on demand
+    QSignalSpy dataChangedSpy(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+    EnginioReply *reply = model.fetchFullObject(1);
+    QVERIFY(reply);
+    QTRY_COMPARE(dataChangedSpy.count(), 1);
+    QCOMPARE(dataChangedSpy.at(0).at(0).value<QModelIndex>().row(), 1);
+    object = model.data(model.index(1), Qt::DisplayRole).value<QJsonValue>().toObject();
+    QCOMPARE(object["title"].toString(), QStringLiteral("1"));
+    QVERIFY(object.contains("description"));
+
+    // another row still has the projected object only
+    object = model.data(model.index(0), Qt::DisplayRole).value<QJsonValue>().toObject();
+    QVERIFY(!object.contains("description"));
+}
+
+void tst_EnginioModel::declaredRoles()
+{
+    EnginioTests::MockServer server;
+    QVERIFY(server.isListening());
+
+    const QString objectType = QStringLiteral("objects.todos");
+    QJsonObject todo;
+    todo["title"] = QStringLiteral("first");
+    todo["done"] = true;
+    server.createObject(objectType, todo);
+    todo = QJsonObject();
+    todo["title"] = QStringLiteral("second");
+    server.createObject(objectType, todo);
+
+    EnginioClient client;
+    client.setBackendId("mockBackendId");
+    client.setBackendSecret("mockBackendSecret");
+    client.setServiceUrl(server.url());
+
+    QJsonObject roles;
+    roles["title"] = QStringLiteral("string");
+    roles["done"] = QStringLiteral("bool");
+    roles["priority"] = QStringLiteral("int");
+
+    EnginioModel model;
+    QSignalSpy rolesSpy(&model, SIGNAL(rolesChanged(QJsonObject)));
+    model.setRoles(roles);
+    QCOMPARE(model.roles(), roles);
+    QCOMPARE(rolesSpy.count(), 1);
+
+    // the roles are there before any data
+    const QHash<int, QByteArray> roleNames = model.roleNames();
+    const int titleRole = roleNames.key("title");
+    const int doneRole = roleNames.key("done");
+    const int priorityRole = roleNames.key("priority");
+    QVERIFY(titleRole);
+    QVERIFY(doneRole);
+    QVERIFY(priorityRole);
+    QVERIFY(roleNames.key("id"));
+
+    QSignalSpy resetSpy(&model, SIGNAL(modelReset()));
+    QJsonObject query;
+    query["objectType"] = objectType;
+    model.setQuery(query);
+    model.setEnginio(&client);
+    QTRY_COMPARE(model.rowCount(), 2);
+    QCOMPARE(model.roleNames(), roleNames);
+
+    // values are converted to the declared types, missing ones are defaults
+    QVariant value = model.data(model.index(0), titleRole);
+    QCOMPARE(int(value.type()), int(QMetaType::QString));
+    QCOMPARE(value.toString(), QStringLiteral("first"));
+    QCOMPARE(model.data(model.index(0), doneRole), QVariant(true));
+    value = model.data(model.index(1), doneRole);
+    QCOMPARE(int(value.type()), int(QMetaType::Bool));
+    QCOMPARE(value.toBool(), false);
+    value = model.data(model.index(1), priorityRole);
+    QCOMPARE(int(value.type()), int(QMetaType::Int));
+    QCOMPARE(value.toInt(), 0);
+
+    // the first appended row of an empty model does not reset it
+    QJsonObject emptyQuery;
+    emptyQuery["objectType"] = QStringLiteral("objects.empty");
+    model.setQuery(emptyQuery);
+    QTRY_COMPARE(model.rowCount(), 0);
+    resetSpy.clear();
+    QSignalSpy insertSpy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QJsonObject object;
+    object["title"] = QStringLiteral("appended");
+    model.append(object);
+    QCOMPARE(model.rowCount(), 1);
+    QCOMPARE(insertSpy.count(), 1);
+    QCOMPARE(resetSpy.count(), 0);
+    QCOMPARE(model.data(model.index(0), titleRole).toString(), QStringLiteral("appended"));
+}
+
 QTEST_MAIN(tst_EnginioModel)
 #include "tst_enginiomodel.moc"
@@ -0,0 +1,10 @@
+QT       += testlib enginio gui
+
+TARGET = tst_enginiosortfilterproxymodel
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+SOURCES += \
+    tst_enginiosortfilterproxymodel.cpp
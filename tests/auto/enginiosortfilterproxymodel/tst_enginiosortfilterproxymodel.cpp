@@ -0,0 +1,240 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtCore/qobject.h>
+#include <QtGui/qstandarditemmodel.h>
+
+#include <Enginio/enginiosortfilterproxymodel.h>
+
+class tst_EnginioSortFilterProxyModel: public QObject
+{
+    Q_OBJECT
+
+    enum {
+        TitleRole = Qt::UserRole + 1,
+        PriorityRole,
+        StatusRole
+    };
+
+    QStandardItemModel _source;
+
+    void appendTodo(const QString &title, int priority, const QString &status)
+    {
+        QStandardItem *item = new QStandardItem;
+        item->setData(title, TitleRole);
+        item->setData(priority, PriorityRole);
+        item->setData(status, StatusRole);
+        _source.appendRow(item);
+    }
+
+    QStringList titles(const QAbstractItemModel &model) const
+    {
+        QStringList result;
+        for (int row = 0; row < model.rowCount(); ++row)
+            result.append(model.data(model.index(row, 0), TitleRole).toString());
+        return result;
+    }
+
+private slots:
+    void init();
+    void sort();
+    void filter();
+    void changedRowIsRepositioned();
+    void insertAndRemove();
+};
+
+void tst_EnginioSortFilterProxyModel::init()
+{
+    _source.clear();
+    QHash<int, QByteArray> roles;
+    roles.insert(TitleRole, "title");
+    roles.insert(PriorityRole, "priority");
+    roles.insert(StatusRole, "status");
+    _source.setItemRoleNames(roles);
+
+    appendTodo(QStringLiteral("b"), 2, QStringLiteral("open"));
+    appendTodo(QStringLiteral("d"), 1, QStringLiteral("done"));
+    appendTodo(QStringLiteral("a"), 3, QStringLiteral("open"));
+    appendTodo(QStringLiteral("c"), 2, QStringLiteral("done"));
+}
+
+void tst_EnginioSortFilterProxyModel::sort()
+{
+    EnginioSortFilterProxyModel proxy;
+    proxy.setSourceModel(&_source);
+    QCOMPARE(proxy.roleNames(), _source.roleNames());
+    QCOMPARE(titles(proxy), QStringList() << "b" << "d" << "a" << "c");
+
+    QSignalSpy sortSpy(&proxy, SIGNAL(sortPropertyChanged(QString)));
+    QSignalSpy layoutSpy(&proxy, SIGNAL(layoutChanged()));
+    proxy.setSortProperty(QStringLiteral("title"));
+    QCOMPARE(proxy.sortProperty(), QStringLiteral("title"));
+    QCOMPARE(sortSpy.count(), 1);
+    QCOMPARE(layoutSpy.count(), 1);
+    QCOMPARE(titles(proxy), QStringList() << "a" << "b" << "c" << "d");
+
+    proxy.setSortOrder(Qt::DescendingOrder);
+    QCOMPARE(titles(proxy), QStringList() << "d" << "c" << "b" << "a");
+
+    // equal values keep the order of the source, reversed in descending order
+    proxy.setSortProperty(QStringLiteral("priority"));
+    QCOMPARE(titles(proxy), QStringList() << "a" << "c" << "b" << "d");
+    proxy.setSortOrder(Qt::AscendingOrder);
+    QCOMPARE(titles(proxy), QStringList() << "d" << "b" << "c" << "a");
+
+    // the indexes map both ways
+    for (int row = 0; row < proxy.rowCount(); ++row) {
+        const QModelIndex sourceIndex = proxy.mapToSource(proxy.index(row, 0));
+        QCOMPARE(proxy.mapFromSource(sourceIndex).row(), row);
+    }
+
+    proxy.setSortProperty(QString());
+    QCOMPARE(titles(proxy), QStringList() << "b" << "d" << "a" << "c");
+}
+
+void tst_EnginioSortFilterProxyModel::filter()
+{
+    EnginioSortFilterProxyModel proxy;
+    proxy.setSourceModel(&_source);
+    proxy.setSortProperty(QStringLiteral("title"));
+
+    QSignalSpy filterSpy(&proxy, SIGNAL(filterChanged(QJsonObject)));
+    QSignalSpy resetSpy(&proxy, SIGNAL(modelReset()));
+    QPersistentModelIndex persistent(proxy.index(1, 0)); // "b"
+    QJsonObject filter;
+    filter["status"] = QStringLiteral("open");
+    proxy.setFilter(filter);
+    QCOMPARE(proxy.filter(), filter);
+    QCOMPARE(filterSpy.count(), 1);
+    QCOMPARE(titles(proxy), QStringList() << "a" << "b");
+    QCOMPARE(persistent.row(), 1);
+
+    filter["priority"] = 2;
+    proxy.setFilter(filter);
+    QCOMPARE(titles(proxy), QStringList() << "b");
+
+    filter["unknownProperty"] = 1;
+    proxy.setFilter(filter);
+    QCOMPARE(proxy.rowCount(), 0);
+
+    proxy.setFilter(QJsonObject());
+    QCOMPARE(proxy.rowCount(), 4);
+    QCOMPARE(titles(proxy), QStringList() << "a" << "b" << "c" << "d");
+    QVERIFY(!proxy.mapFromSource(_source.index(5, 0)).isValid());
+    QCOMPARE(resetSpy.count(), 0);
+}
+
+void tst_EnginioSortFilterProxyModel::changedRowIsRepositioned()
+{
+    EnginioSortFilterProxyModel proxy;
+    proxy.setSourceModel(&_source);
+    proxy.setSortProperty(QStringLiteral("status"));
+    proxy.setSortProperty(QStringLiteral("title"));
+    QJsonObject filter;
+    filter["status"] = QStringLiteral("open");
+    proxy.setFilter(filter);
+    QCOMPARE(titles(proxy), QStringList() << "a" << "b");
+
+    QSignalSpy resetSpy(&proxy, SIGNAL(modelReset()));
+    QSignalSpy moveSpy(&proxy, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)));
+    QSignalSpy insertSpy(&proxy, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    QSignalSpy removeSpy(&proxy, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+
+    // "a" becomes "z" and moves to the end
+    QPersistentModelIndex persistent(proxy.index(0, 0));
+    _source.item(2)->setData(QStringLiteral("z"), TitleRole);
+    QCOMPARE(titles(proxy), QStringList() << "b" << "z");
+    QCOMPARE(moveSpy.count(), 1);
+    QCOMPARE(persistent.row(), 1);
+
+    // "c" starts to match the filter
+    _source.item(3)->setData(QStringLiteral("open"), StatusRole);
+    QCOMPARE(titles(proxy), QStringList() << "b" << "c" << "z");
+    QCOMPARE(insertSpy.count(), 1);
+    QCOMPARE(insertSpy.at(0).at(1).toInt(), 1);
+
+    // "b" does not anymore
+    _source.item(0)->setData(QStringLiteral("done"), StatusRole);
+    QCOMPARE(titles(proxy), QStringList() << "c" << "z");
+    QCOMPARE(removeSpy.count(), 1);
+    QCOMPARE(resetSpy.count(), 0);
+
+    // the cached index of another property is up to date too
+    proxy.setFilter(QJsonObject());
+    proxy.setSortProperty(QStringLiteral("status"));
+    QCOMPARE(titles(proxy), QStringList() << "b" << "d" << "z" << "c");
+}
+
+void tst_EnginioSortFilterProxyModel::insertAndRemove()
+{
+    EnginioSortFilterProxyModel proxy;
+    proxy.setSourceModel(&_source);
+    proxy.setSortProperty(QStringLiteral("title"));
+
+    QSignalSpy insertSpy(&proxy, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    appendTodo(QStringLiteral("bb"), 5, QStringLiteral("open"));
+    QCOMPARE(titles(proxy), QStringList() << "a" << "b" << "bb" << "c" << "d");
+    QCOMPARE(insertSpy.count(), 1);
+    QCOMPARE(insertSpy.at(0).at(1).toInt(), 2);
+
+    QStandardItem *item = new QStandardItem;
+    item->setData(QStringLiteral("0"), TitleRole);
+    _source.insertRow(0, item);
+    QCOMPARE(titles(proxy), QStringList() << "0" << "a" << "b" << "bb" << "c" << "d");
+
+    QSignalSpy removeSpy(&proxy, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+    _source.removeRows(1, 2); // "b" and "d"
+    QCOMPARE(titles(proxy), QStringList() << "0" << "a" << "bb" << "c");
+    QCOMPARE(removeSpy.count(), 2);
+
+    for (int row = 0; row < proxy.rowCount(); ++row) {
+        const QModelIndex sourceIndex = proxy.mapToSource(proxy.index(row, 0));
+        QCOMPARE(_source.data(sourceIndex, TitleRole), proxy.data(proxy.index(row, 0), TitleRole));
+    }
+
+    // the old order is still known after the rows moved in the source
+    proxy.setSortProperty(QStringLiteral("priority"));
+    proxy.setSortProperty(QStringLiteral("title"));
+    QCOMPARE(titles(proxy), QStringList() << "0" << "a" << "bb" << "c");
+}
+
+QTEST_MAIN(tst_EnginioSortFilterProxyModel)
+#include "tst_enginiosortfilterproxymodel.moc"
@@ -0,0 +1,14 @@
+QT       += testlib enginio network
+
+TARGET = tst_enginiotablemodel
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+SOURCES += \
+    tst_enginiotablemodel.cpp \
+    ../common/mockserver.cpp
+
+HEADERS += \
+    ../common/mockserver.h
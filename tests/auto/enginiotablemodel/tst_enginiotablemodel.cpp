@@ -0,0 +1,246 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://www.qt-project.org/legal
+**
+**
+** $QT_BEGIN_LICENSE:LGPL$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia.  For licensing terms and
+** conditions see http://qt.digia.com/licensing.  For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights.  These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtCore/qobject.h>
+
+#include <Enginio/enginioclient.h>
+#include <Enginio/enginioreply.h>
+#include <Enginio/enginiotablemodel.h>
+
+#include "../common/mockserver.h"
+
+class tst_EnginioTableModel: public QObject
+{
+    Q_OBJECT
+
+    EnginioTests::MockServer *_server;
+    EnginioClient *_client;
+    const QString _objectType;
+
+public:
+    tst_EnginioTableModel()
+        : _server(0)
+        , _client(0)
+        , _objectType(QStringLiteral("objects.todos"))
+    {}
+
+private slots:
+    void init();
+    void cleanup();
+    void declaredColumns();
+    void discoveredColumns();
+    void paging();
+    void writeBack();
+};
+
+void tst_EnginioTableModel::init()
+{
+    _server = new EnginioTests::MockServer;
+    QVERIFY(_server->isListening());
+    for (int i = 0; i < 5; ++i) {
+        QJsonObject todo;
+        todo["title"] = QStringLiteral("todo ") + QString::number(i);
+        todo["priority"] = i;
+        todo["done"] = i % 2 == 0;
+        _server->createObject(_objectType, todo);
+    }
+
+    _client = new EnginioClient;
+    _client->setBackendId("mockBackendId");
+    _client->setBackendSecret("mockBackendSecret");
+    _client->setServiceUrl(_server->url());
+}
+
+void tst_EnginioTableModel::cleanup()
+{
+    delete _client;
+    delete _server;
+}
+
+void tst_EnginioTableModel::declaredColumns()
+{
+    QJsonArray columns;
+    QJsonObject title;
+    title["name"] = QStringLiteral("title");
+    title["title"] = QStringLiteral("Title");
+    title["type"] = QStringLiteral("string");
+    columns.append(title);
+    QJsonObject priority;
+    priority["name"] = QStringLiteral("priority");
+    priority["type"] = QStringLiteral("number");
+    columns.append(priority);
+    columns.append(QStringLiteral("missing"));
+
+    EnginioTableModel model;
+    QSignalSpy columnsSpy(&model, SIGNAL(columnsChanged(QJsonArray)));
+    model.setColumns(columns);
+    QCOMPARE(model.columns(), columns);
+    QCOMPARE(columnsSpy.count(), 1);
+
+    // the header is there before any data
+    QCOMPARE(model.columnCount(), 3);
+    QCOMPARE(model.rowCount(), 0);
+    QCOMPARE(model.headerData(0, Qt::Horizontal).toString(), QStringLiteral("Title"));
+    QCOMPARE(model.headerData(1, Qt::Horizontal).toString(), QStringLiteral("priority"));
+    QCOMPARE(model.headerData(0, Qt::Horizontal, EnginioTableModel::PropertyNameRole).toString(), QStringLiteral("title"));
+    QCOMPARE(model.headerData(1, Qt::Horizontal, EnginioTableModel::PropertyTypeRole).toString(), QStringLiteral("number"));
+    QCOMPARE(model.headerData(2, Qt::Horizontal, EnginioTableModel::PropertyTypeRole).toString(), QStringLiteral("var"));
+
+    QJsonObject query;
+    query["objectType"] = _objectType;
+    model.setQuery(query);
+    model.setEnginio(_client);
+    QTRY_COMPARE(model.rowCount(), 5);
+    QCOMPARE(model.columnCount(), 3);
+
+    QVariant value = model.data(model.index(3, 0));
+    QCOMPARE(int(value.type()), int(QMetaType::QString));
+    QCOMPARE(value.toString(), QStringLiteral("todo 3"));
+    value = model.data(model.index(3, 1));
+    QCOMPARE(int(value.type()), int(QMetaType::Double));
+    QCOMPARE(value.toDouble(), 3.0);
+    QVERIFY(!model.data(model.index(3, 2)).isValid());
+    QVERIFY(!model.data(model.index(5, 0)).isValid());
+    QVERIFY(!model.data(model.index(0, 3)).isValid());
+}
+
+void tst_EnginioTableModel::discoveredColumns()
+{
+    QJsonObject query;
+    query["objectType"] = _objectType;
+
+    EnginioTableModel model;
+    model.setQuery(query);
+    model.setEnginio(_client);
+    QTRY_COMPARE(model.rowCount(), 5);
+
+    // every property of the first object, typed by its value
+    QHash<QString, int> columns;
+    for (int column = 0; column < model.columnCount(); ++column)
+        columns.insert(model.headerData(column, Qt::Horizontal, EnginioTableModel::PropertyNameRole).toString(), column);
+    QVERIFY(columns.contains("id"));
+    QVERIFY(columns.contains("title"));
+    QCOMPARE(model.headerData(columns.value("done"), Qt::Horizontal, EnginioTableModel::PropertyTypeRole).toString(), QStringLiteral("bool"));
+    QCOMPARE(model.data(model.index(2, columns.value("done"))), QVariant(true));
+    QCOMPARE(model.data(model.index(1, columns.value("done"))), QVariant(false));
+    QCOMPARE(model.data(model.index(4, columns.value("priority"))).toDouble(), 4.0);
+}
+
+void tst_EnginioTableModel::paging()
+{
+    QJsonObject query;
+    query["objectType"] = _objectType;
+    query["pageSize"] = 2;
+
+    EnginioTableModel model;
+    model.setQuery(query);
+    model.setEnginio(_client);
+    QTRY_COMPARE(model.rowCount(), 2);
+    QVERIFY(model.canFetchMore(QModelIndex()));
+
+    while (model.canFetchMore(QModelIndex())) {
+        const int rowCount = model.rowCount();
+        model.fetchMore(QModelIndex());
+        QTRY_VERIFY(model.rowCount() > rowCount || !model.canFetchMore(QModelIndex()));
+    }
+    QCOMPARE(model.rowCount(), 5);
+
+    const int titleColumn = 0;
+    QJsonArray columns;
+    columns.append(QStringLiteral("title"));
+    model.setColumns(columns);
+    QTRY_COMPARE(model.rowCount(), 2);
+    QCOMPARE(model.data(model.index(1, titleColumn)).toString(), QStringLiteral("todo 1"));
+}
+
+void tst_EnginioTableModel::writeBack()
+{
+    QJsonArray columns;
+    columns.append(QStringLiteral("title"));
+    QJsonObject done;
+    done["name"] = QStringLiteral("done");
+    done["type"] = QStringLiteral("bool");
+    columns.append(done);
+
+    QJsonObject query;
+    query["objectType"] = _objectType;
+
+    EnginioTableModel model;
+    model.setColumns(columns);
+    model.setQuery(query);
+    model.setEnginio(_client);
+    QTRY_COMPARE(model.rowCount(), 5);
+
+    // an edit is shown immediately and sent to the backend
+    QSignalSpy dataChangedSpy(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+    QVERIFY(model.setData(model.index(1, 1), true));
+    QCOMPARE(model.data(model.index(1, 1)), QVariant(true));
+    QCOMPARE(dataChangedSpy.count(), 1);
+    QTRY_COMPARE(dataChangedSpy.count(), 2);
+    QCOMPARE(_server->objects(_objectType).at(1)["done"].toBool(), true);
+
+    EnginioReply *reply = model.setProperty(2, QStringLiteral("title"), QStringLiteral("changed"));
+    QVERIFY(reply);
+    QSignalSpy updateSpy(reply, SIGNAL(finished(EnginioReply*)));
+    QCOMPARE(model.data(model.index(2, 0)).toString(), QStringLiteral("changed"));
+    QTRY_COMPARE(updateSpy.count(), 1);
+    QCOMPARE(_server->objects(_objectType).at(2)["title"].toString(), QStringLiteral("changed"));
+
+    QJsonObject todo;
+    todo["title"] = QStringLiteral("appended");
+    reply = model.append(todo);
+    QVERIFY(reply);
+    QCOMPARE(model.rowCount(), 6);
+    QSignalSpy createSpy(reply, SIGNAL(finished(EnginioReply*)));
+    QCOMPARE(model.data(model.index(5, 0)).toString(), QStringLiteral("appended"));
+    QTRY_COMPARE(createSpy.count(), 1);
+    QCOMPARE(_server->objects(_objectType).count(), 6);
+
+    reply = model.remove(0);
+    QVERIFY(reply);
+    QTRY_COMPARE(model.rowCount(), 5);
+    QCOMPARE(_server->objects(_objectType).count(), 5);
+    QCOMPARE(model.data(model.index(0, 0)).toString(), QStringLiteral("todo 1"));
+    QCOMPARE(model.data(model.index(4, 0)).toString(), QStringLiteral("appended"));
+}
+
+QTEST_MAIN(tst_EnginioTableModel)
+#include "tst_enginiotablemodel.moc"
@@ -0,0 +1,143 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://qt.digia.com/contact-us
+**
+** This file is part of the Enginio Qt Client Library.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtCore/qelapsedtimer.h>
+#include <QtCore/qjsonobject.h>
+#include <QtCore/qthread.h>
+
+#include <Enginio/enginioclient.h>
+#include <Enginio/enginioreply.h>
+
+#include "../../auto/common/mockserver.h"
+
+// Sends the first request of a client in a new thread, which has no network access
+// managers and so no open connections yet, like a process which was just started.
+class ColdStart : public QThread
+{
+    QUrl _url;
+    int _startupMsecs;
+
+public:
+    qint64 latency;
+
+    ColdStart(const QUrl &url, int startupMsecs)
+        : _url(url)
+        , _startupMsecs(startupMsecs)
+        , latency(-1)
+    {}
+
+protected:
+    virtual void run() Q_DECL_OVERRIDE
+    {
+        EnginioClient client;
+        client.setBackendId("mockBackendId");
+        client.setBackendSecret("mockBackendSecret");
+        client.setServiceUrl(_url);
+        // the rest of the application starting up, the connection can be opened meanwhile
+        if (_startupMsecs)
+            QTest::qWait(_startupMsecs);
+
+        QJsonObject query;
+        query["objectType"] = QStringLiteral("objects.todos");
+        QSignalSpy spy(&client, SIGNAL(finished(EnginioReply*)));
+        QElapsedTimer timer;
+        timer.start();
+        client.query(query);
+        if (spy.wait(30000))
+            latency = timer.elapsed();
+    }
+};
+
+class tst_bench_EnginioClient: public QObject
+{
+    Q_OBJECT
+
+    EnginioTests::MockServer _server;
+
+private slots:
+    void initTestCase();
+    void firstRequest_data();
+    void firstRequest();
+};
+
+void tst_bench_EnginioClient::initTestCase()
+{
+    QVERIFY(_server.isListening());
+    QJsonObject todo;
+    todo["title"] = QStringLiteral("Todo");
+    _server.createObject(QStringLiteral("objects.todos"), todo);
+}
+
+void tst_bench_EnginioClient::firstRequest_data()
+{
+    QTest::addColumn<QUrl>("url");
+    QTest::addColumn<int>("startupMsecs");
+
+    QTest::newRow("mock server, immediately") << _server.url() << 0;
+    QTest::newRow("mock server, after startup") << _server.url() << 200;
+
+    // with TLS, the later runs resume the session stored by the first one
+    const QByteArray backend = qgetenv("ENGINIO_API_URL");
+    if (!backend.isEmpty()) {
+        QTest::newRow("backend, immediately") << QUrl(QString::fromUtf8(backend)) << 0;
+        QTest::newRow("backend, after startup") << QUrl(QString::fromUtf8(backend)) << 500;
+    }
+}
+
+void tst_bench_EnginioClient::firstRequest()
+{
+    QFETCH(QUrl, url);
+    QFETCH(int, startupMsecs);
+
+    QList<qint64> latencies;
+    for (int i = 0; i < 5; ++i) {
+        ColdStart coldStart(url, startupMsecs);
+        QSignalSpy finished(&coldStart, SIGNAL(finished()));
+        coldStart.start();
+        QVERIFY(finished.wait(60000));
+        QVERIFY(coldStart.latency >= 0);
+        latencies.append(coldStart.latency);
+    }
+
+    qSort(latencies);
+    qDebug() << "first request latencies:" << latencies << "ms";
+    QTest::setBenchmarkResult(latencies.at(latencies.count() / 2), QTest::WalltimeMilliseconds);
+}
+
+QTEST_MAIN(tst_bench_EnginioClient)
+#include "tst_bench_enginioclient.moc"
@@ -0,0 +1,14 @@
+QT       += testlib enginio network
+QT       -= gui
+
+TARGET = tst_bench_enginiomodel
+CONFIG   += console
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+SOURCES += \
+    tst_bench_enginiomodel.cpp \
+    ../../auto/common/mockserver.cpp
+
+HEADERS += ../../auto/common/mockserver.h
@@ -0,0 +1,150 @@
+/****************************************************************************
+**
+** Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+** Contact: http://qt.digia.com/contact-us
+**
+** This file is part of the Enginio Qt Client Library.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and Digia. For licensing terms and
+** conditions see http://qt.digia.com/licensing. For further information
+** use the contact form at http://qt.digia.com/contact-us.
+**
+** GNU Lesser General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU Lesser
+** General Public License version 2.1 as published by the Free Software
+** Foundation and appearing in the file LICENSE.LGPL included in the
+** packaging of this file.  Please review the following information to
+** ensure the GNU Lesser General Public License version 2.1 requirements
+** will be met: http://www.gnu.org/licenses/old-licenses/lgpl-2.1.html.
+**
+** In addition, as a special exception, Digia gives you certain additional
+** rights. These rights are described in the Digia Qt LGPL Exception
+** version 1.1, included in the file LGPL_EXCEPTION.txt in this package.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3.0 as published by the Free Software
+** Foundation and appearing in the file LICENSE.GPL included in the
+** packaging of this file. Please review the following information to
+** ensure the GNU General Public License version 3.0 requirements will be
+** met: http://www.gnu.org/copyleft/gpl.html.
+**
+****************************************************************************/
+
+#include <QtTest/QtTest>
+#include <QtCore/qobject.h>
+#include <QtCore/qjsonobject.h>
+
+#include <Enginio/enginioclient.h>
+#include <Enginio/enginiomodel.h>
+#include <Enginio/enginiosortfilterproxymodel.h>
+
+#include "../../auto/common/mockserver.h"
+
+class tst_bench_EnginioModel: public QObject
+{
+    Q_OBJECT
+
+    EnginioTests::MockServer _server;
+
+private slots:
+    void initTestCase();
+    void load100k();
+    void sortFilter100k();
+};
+
+void tst_bench_EnginioModel::initTestCase()
+{
+    QVERIFY(_server.isListening());
+
+    // typical objects: the same properties and a few enum-like values in every one of them
+    const QString statuses[] = { QStringLiteral("open"), QStringLiteral("in progress"), QStringLiteral("done") };
+    for (int i = 0; i < 100000; ++i) {
+        QJsonObject todo;
+        todo["title"] = QStringLiteral("Todo ") + QString::number(i);
+        todo["status"] = statuses[i % 3];
+        todo["priority"] = i % 5;
+        todo["owner"] = QStringLiteral("user") + QString::number(i % 10);
+        _server.createObject(QStringLiteral("objects.todos"), todo);
+    }
+}
+
+void tst_bench_EnginioModel::load100k()
+{
+    QJsonObject query;
+    query["objectType"] = QStringLiteral("objects.todos");
+
+    QJsonObject metrics;
+    QBENCHMARK {
+        EnginioClient client;
+        client.setBackendId("mockBackendId");
+        client.setBackendSecret("mockBackendSecret");
+        client.setServiceUrl(_server.url());
+
+        EnginioModel model;
+        model.setQuery(query);
+        QSignalSpy resetSpy(&model, SIGNAL(modelReset()));
+        model.setEnginio(&client);
+        QVERIFY(resetSpy.wait(60000));
+        QCOMPARE(model.rowCount(), 100000);
+        metrics = client.metrics();
+    }
+
+    qDebug() << "cached objects:" << metrics["cachedObjects"].toDouble()
+             << "interned strings:" << metrics["internedStrings"].toDouble()
+             << "bytes saved by interning:" << metrics["internedBytesSaved"].toDouble();
+    QVERIFY(metrics["internedBytesSaved"].toDouble() > 0);
+}
+
+void tst_bench_EnginioModel::sortFilter100k()
+{
+    QJsonObject query;
+    query["objectType"] = QStringLiteral("objects.todos");
+
+    EnginioClient client;
+    client.setBackendId("mockBackendId");
+    client.setBackendSecret("mockBackendSecret");
+    client.setServiceUrl(_server.url());
+
+    EnginioModel model;
+    model.setQuery(query);
+    QSignalSpy resetSpy(&model, SIGNAL(modelReset()));
+    model.setEnginio(&client);
+    QVERIFY(resetSpy.wait(60000));
+    QCOMPARE(model.rowCount(), 100000);
+
+    EnginioSortFilterProxyModel proxy;
+    proxy.setSourceModel(&model);
+
+    // the indexes are built once, re-sorting afterwards is what a user clicking on headers does
+    QElapsedTimer timer;
+    timer.start();
+    proxy.setSortProperty(QStringLiteral("title"));
+    proxy.setSortProperty(QStringLiteral("priority"));
+    qDebug() << "building two sort indexes:" << timer.elapsed() << "ms";
+
+    QJsonObject filter;
+    filter["status"] = QStringLiteral("open");
+    QBENCHMARK {
+        proxy.setSortProperty(QStringLiteral("title"));
+        proxy.setSortOrder(Qt::DescendingOrder);
+        proxy.setFilter(filter);
+        proxy.setSortProperty(QStringLiteral("priority"));
+        proxy.setSortOrder(Qt::AscendingOrder);
+        proxy.setFilter(QJsonObject());
+    }
+    QCOMPARE(proxy.rowCount(), 100000);
+
+    // a changed row is moved into place without sorting again
+    timer.restart();
+    for (int row = 0; row < 100; ++row)
+        model.setProperty(row, QStringLiteral("priority"), 4 - row % 5);
+    qDebug() << "repositioning 100 changed rows:" << timer.elapsed() << "ms";
+}
+
+QTEST_MAIN(tst_bench_EnginioModel)
+#include "tst_bench_enginiomodel.moc"